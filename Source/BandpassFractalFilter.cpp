@@ -1,4 +1,5 @@
 #include "BandpassFractalFilter.h"
+#include "BiquadCoefficientCache.h"
 #include <algorithm>
 
 //==============================================================================
@@ -11,91 +12,90 @@ BandpassFractalFilter::~BandpassFractalFilter()
 }
 
 //==============================================================================
-void BandpassFractalFilter::prepareToPlay (double sampleRate, int samplesPerBlock)
+void BandpassFractalFilter::prepare (const juce::dsp::ProcessSpec& spec)
 {
-    this->sampleRate = sampleRate;
-    reset();
+    sampleRate = spec.sampleRate;
+    channelStates.assign (spec.numChannels, {});
+
+    // Retuning glides over 5 ms
+    rampSamples = juce::jmax (1, (int) (sampleRate * 0.005));
+
+    hasDesign = false;
+    coefficientsDirty = false;
     updateCoefficients();
 }
 
 void BandpassFractalFilter::reset()
 {
-    for (auto& filter : fractalFilters)
-    {
-        filter.reset();
-    }
+    std::fill (channelStates.begin(), channelStates.end(), LaneState {});
 }
 
 //==============================================================================
-void BandpassFractalFilter::process (juce::dsp::ProcessContextReplacing<float>& context)
+void BandpassFractalFilter::process (const juce::dsp::ProcessContextReplacing<float>& context)
 {
-    auto& inputBlock = context.getInputBlock();
     auto& outputBlock = context.getOutputBlock();
-    auto numSamples = outputBlock.getNumSamples();
-    auto numChannels = outputBlock.getNumChannels();
+    const int numSamples = (int) outputBlock.getNumSamples();
+    const size_t numChannels = juce::jmin (outputBlock.getNumChannels(), channelStates.size());
 
-    if (fractalFilters.empty() || mix <= 0.0f)
-        return;
-
-    // Store original input for parallel processing
-    for (size_t ch = 0; ch < numChannels; ++ch)
-    {
-        auto inputChannel = inputBlock.getChannelPointer (ch);
-        auto outputChannel = outputBlock.getChannelPointer (ch);
+    if (keyTracker != nullptr)
+        setCurrentFreq (keyTracker->getCurrentFrequency());
 
-        // Copy input to output initially (dry signal)
-        std::copy (inputChannel, inputChannel + numSamples, outputChannel);
-    }
-
-    if (fractalFilters.empty() || mix <= 0.0f)
-        return;
+    if (coefficientsDirty.exchange (false))
+        updateCoefficients();
 
-    // Process each fractal level in parallel (each processes original input)
-    for (size_t level = 0; level < fractalFilters.size(); ++level)
+    // The bank keeps running at zero mix so turning it back up does not click
+    for (int i = 0; i < numSamples; ++i)
     {
-        // Create temporary buffer for this level's output
-        std::vector<float> levelOutput (numChannels * numSamples, 0.0f);
+        if (rampRemaining > 0)
+            advanceRamp();
+
+        // Local copies, so the compiler can keep the lanes in registers without alias checks
+        const LaneCoefficients c = current;
 
-        // Copy original input to temp buffer
         for (size_t ch = 0; ch < numChannels; ++ch)
         {
-            auto inputChannel = inputBlock.getChannelPointer (ch);
-            std::copy (inputChannel, inputChannel + numSamples, levelOutput.data() + ch * numSamples);
-        }
+            float* samples = outputBlock.getChannelPointer (ch);
+            const float x = samples[i];
 
-        juce::dsp::AudioBlock<float> levelBlock (levelOutput);
-        juce::dsp::ProcessContextReplacing<float> levelContext (levelBlock);
+            // Every level reads the same input sample (transposed direct form II, b1 = 0, b2 = -b0)
+            LaneState state = channelStates[ch];
+            alignas (32) Lanes y;
 
-        // Apply this fractal level's bandpass filter
-        fractalFilters[level].process (levelContext);
-
-        // Add to output block (accumulating parallel branches)
-        for (size_t ch = 0; ch < numChannels; ++ch)
-        {
-            auto outputChannel = outputBlock.getChannelPointer (ch);
-            auto levelChannel = levelOutput.data() + ch * numSamples;
-            for (int sample = 0; sample < numSamples; ++sample)
+            for (int k = 0; k < maxDepth; ++k)
             {
-                outputChannel[sample] += levelChannel[sample];
+                y[(size_t) k] = c.b0[(size_t) k] * x + state.s1[(size_t) k];
+                state.s1[(size_t) k] = state.s2[(size_t) k] - c.a1[(size_t) k] * y[(size_t) k];
+                state.s2[(size_t) k] = -c.b0[(size_t) k] * x - c.a2[(size_t) k] * y[(size_t) k];
             }
+
+            channelStates[ch] = state;
+
+            // Pairwise horizontal sum, so the additions stay in vector registers
+            alignas (16) std::array<float, maxDepth / 2> half;
+            for (int k = 0; k < maxDepth / 2; ++k)
+                half[(size_t) k] = y[(size_t) k] + y[(size_t) k + maxDepth / 2];
+
+            const float wet = (half[0] + half[2]) + (half[1] + half[3]);
+
+            // Dry signal plus the summed bands, as before the bank was vectorised
+            samples[i] = x + mix * wet;
         }
     }
+}
 
-    // Apply wet/dry mix
-    if (mix < 1.0f)
+void BandpassFractalFilter::advanceRamp() noexcept
+{
+    if (--rampRemaining == 0)
     {
-        // Blend: output = (dry * (1-mix)) + (wet * mix)
-        for (size_t ch = 0; ch < numChannels; ++ch)
-        {
-            auto outputChannel = outputBlock.getChannelPointer (ch);
-            auto inputChannel = inputBlock.getChannelPointer (ch);
+        current = target;
+        return;
+    }
 
-            for (int sample = 0; sample < numSamples; ++sample)
-            {
-                float drySample = inputChannel[sample] * (1.0f - mix);
-                outputChannel[sample] = drySample + (outputChannel[sample] * mix);
-            }
-        }
+    for (int k = 0; k < maxDepth; ++k)
+    {
+        current.b0[(size_t) k] += step.b0[(size_t) k];
+        current.a1[(size_t) k] += step.a1[(size_t) k];
+        current.a2[(size_t) k] += step.a2[(size_t) k];
     }
 }
 
@@ -105,20 +105,20 @@ void BandpassFractalFilter::setCurrentFreq (double freq)
     if (std::abs (currentFreq - freq) > 1.0)
     {
         currentFreq = freq;
-        updateCoefficients();
+        coefficientsDirty = true;
     }
 }
 
 void BandpassFractalFilter::setDepth (int newDepth)
 {
     depth = std::max (2, std::min (maxDepth, newDepth));
-    updateCoefficients();
+    coefficientsDirty = true;
 }
 
 void BandpassFractalFilter::setScaleFactor (float scale)
 {
     scaleFactor = std::max (1.0f, std::min (3.0f, scale));
-    updateCoefficients();
+    coefficientsDirty = true;
 }
 
 void BandpassFractalFilter::setMix (float newMix)
@@ -129,20 +129,18 @@ void BandpassFractalFilter::setMix (float newMix)
 void BandpassFractalFilter::setBaseCenter (float centerHz)
 {
     baseCenter = std::max (50.0f, std::min (static_cast<float>(sampleRate) / 4.0f, centerHz));
-    updateCoefficients();
+    coefficientsDirty = true;
 }
 
 void BandpassFractalFilter::setBaseQ (float q)
 {
     baseQ = std::max (0.5f, std::min (20.0f, q));
-    updateCoefficients();
+    coefficientsDirty = true;
 }
 
 //==============================================================================
 void BandpassFractalFilter::updateCoefficients()
 {
-    fractalFilters.clear();
-
     // Calculate key-tracked base center frequency
     double trackedBase = baseCenter * (currentFreq / 100.0);  // Scale to bass reference
     trackedBase = std::max (50.0, std::min (sampleRate / 2.0 - 100.0, trackedBase));
@@ -152,29 +150,50 @@ void BandpassFractalFilter::updateCoefficients()
     int autoDepth = std::max (2, std::min (6, 4 - static_cast<int>(std::log2 (currentFreq / 200.0))));
     int effectiveDepth = (depth > 0) ? depth : autoDepth;
 
-    // Build fractal bandpass filter chain
+    // Design every level in place; levels past the depth keep their poles and fade out
     double currentCenter = trackedBase;
     float currentQ = baseQ;
 
-    for (int level = 0; level < effectiveDepth; ++level)
+    for (int level = 0; level < maxDepth; ++level)
     {
-        // Taper Q wider at deeper levels for harmonic spread and warmth
-        float taperedQ = currentQ / (1.0f + level * 0.2f);
-
-        // Create bandpass coefficients for this level
-        auto coeffs = juce::dsp::IIR::Coefficients<float>::makeBandPass (
-            static_cast<float>(sampleRate),
-            static_cast<float>(currentCenter),
-            taperedQ
-        );
+        if (level < effectiveDepth)
+        {
+            // Taper Q wider at deeper levels for harmonic spread and warmth
+            float taperedQ = currentQ / (1.0f + level * 0.2f);
 
-        // Create and configure filter
-        juce::dsp::IIR::Filter<float> newFilter;
-        newFilter.coefficients = *coeffs;
-        fractalFilters.push_back (std::move (newFilter));
+            const auto c = BiquadCoefficientCache::get (Biquad::Type::bandpass, sampleRate, static_cast<float>(currentCenter), taperedQ);
+            target.b0[(size_t) level] = c.b0;
+            target.a1[(size_t) level] = c.a1;
+            target.a2[(size_t) level] = c.a2;
+        }
+        else
+        {
+            target.b0[(size_t) level] = 0.0f;
+        }
 
         // Scale center frequency for next level (fractal self-similarity)
         currentCenter *= scaleFactor;
         currentCenter = std::min (currentCenter, sampleRate / 2.0 - 50.0);  // Clamp to Nyquist
     }
+
+    if (! hasDesign)
+    {
+        current = target;
+        rampRemaining = 0;
+        hasDesign = true;
+        return;
+    }
+
+    // Glide from wherever the lanes are now; the stability triangle is convex,
+    // so every interpolated pole pair is stable
+    const float inverseLength = 1.0f / (float) rampSamples;
+
+    for (int k = 0; k < maxDepth; ++k)
+    {
+        step.b0[(size_t) k] = (target.b0[(size_t) k] - current.b0[(size_t) k]) * inverseLength;
+        step.a1[(size_t) k] = (target.a1[(size_t) k] - current.a1[(size_t) k]) * inverseLength;
+        step.a2[(size_t) k] = (target.a2[(size_t) k] - current.a2[(size_t) k]) * inverseLength;
+    }
+
+    rampRemaining = rampSamples;
 }
@@ -1,7 +1,8 @@
 #pragma once
 
-#include <juce_audio_processors/juce_audio_processors.h>
-#include <juce_dsp/juce_dsp.h>
+#include "Module.h"
+#include <array>
+#include <atomic>
 
 //==============================================================================
 /**
@@ -13,19 +14,26 @@
     - Key-tracked base center for musical consistency across MIDI notes
     - Parallel bandpass filters emphasize harmonics without broadband loss
     - Perfect for formant-like evolutions and metallic bass rings
+
+    The levels are the lanes of one loop: every sample is read once, run
+    through all eight bandpasses side by side (coefficients and state stored
+    structure-of-arrays) and the lanes are summed. Unused levels have zero
+    gain. Retuning never rebuilds the filters: new coefficients are designed
+    at the start of the next block and each lane glides to them over a few
+    milliseconds, so key changes keep the filter state and do not click.
 */
-class BandpassFractalFilter
+class BandpassFractalFilter : public FilterModule
 {
 public:
     BandpassFractalFilter();
-    ~BandpassFractalFilter();
+    ~BandpassFractalFilter() override;
 
     //==============================================================================
-    void prepareToPlay (double sampleRate, int samplesPerBlock);
-    void reset();
+    void prepare (const juce::dsp::ProcessSpec& spec) override;
+    void process (const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
 
-    //==============================================================================
-    void process (juce::dsp::ProcessContextReplacing<float>& context);
+    const juce::String getName() const override { return "Bandpass Fractal Filter"; }
 
     //==============================================================================
     // Parameter setters
@@ -44,22 +52,42 @@ public:
 
 private:
     //==============================================================================
+    static constexpr int maxDepth = 8;
+    using Lanes = std::array<float, maxDepth>;
+
+    /** Bandpass coefficients of every level (b1 is always zero and b2 = -b0). */
+    struct LaneCoefficients
+    {
+        alignas (32) Lanes b0 {}, a1 {}, a2 {};
+    };
+
+    /** Filter state of every level for one channel. */
+    struct LaneState
+    {
+        alignas (32) Lanes s1 {}, s2 {};
+    };
+
     void updateCoefficients();
+    void advanceRamp() noexcept;
 
     //==============================================================================
     // DSP Components - Parallel bandpass filter bank
-    static constexpr int maxDepth = 8;
-    std::vector<juce::dsp::IIR::Filter<float>> fractalFilters;
+    LaneCoefficients current, target, step;
+    std::vector<LaneState> channelStates;
+    int rampSamples = 220;          // Length of a retuning glide
+    int rampRemaining = 0;
+    std::atomic<bool> coefficientsDirty { true };
 
     // Parameters
     double sampleRate = 44100.0;
     double currentFreq = 100.0;     // Current MIDI note frequency
     int depth = 4;                  // Number of fractal levels (2-8)
     float scaleFactor = 1.618f;     // Golden ratio for natural scaling
-    float mix = 0.5f;               // Dry/wet mix (0-1)
+    float mix = 0.5f;               // Amount of the summed bands added to the dry signal (0-1)
     float baseCenter = 200.0f;      // Base center frequency
     float currentBaseCenter = 200.0f;
     float baseQ = 2.0f;             // Base Q factor for bandwidth
+    bool hasDesign = false;         // The first design is applied without a glide
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BandpassFractalFilter)
 };
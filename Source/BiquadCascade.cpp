@@ -0,0 +1,30 @@
+#include "BiquadCascade.h"
+
+//==============================================================================
+Biquad Biquad::design (Type type, double sampleRate, float frequency, float q, float gainDecibels) noexcept
+{
+    // Bilinear-transform designs from the Audio EQ Cookbook
+    const double w0 = juce::MathConstants<double>::twoPi * juce::jlimit (10.0, sampleRate * 0.49, (double) frequency) / sampleRate;
+    const double cosW0 = std::cos (w0);
+    const double alpha = std::sin (w0) / (2.0 * juce::jmax (0.01f, q));
+
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0 + alpha, a1 = -2.0 * cosW0, a2 = 1.0 - alpha;
+
+    switch (type)
+    {
+        case Type::lowpass:  b0 = (1.0 - cosW0) * 0.5; b1 = 1.0 - cosW0;    b2 = b0; break;
+        case Type::highpass: b0 = (1.0 + cosW0) * 0.5; b1 = -(1.0 + cosW0); b2 = b0; break;
+        case Type::bandpass: b0 = alpha;               b1 = 0.0;            b2 = -alpha; break;
+        case Type::notch:    b0 = 1.0;                 b1 = -2.0 * cosW0;   b2 = 1.0; break;
+        case Type::allpass:  b0 = 1.0 - alpha;         b1 = -2.0 * cosW0;   b2 = 1.0 + alpha; break;
+        case Type::peak:
+        {
+            const double A = std::pow (10.0, gainDecibels / 40.0);
+            b0 = 1.0 + alpha * A; b1 = -2.0 * cosW0; b2 = 1.0 - alpha * A;
+            a0 = 1.0 + alpha / A; a2 = 1.0 - alpha / A;
+            break;
+        }
+    }
+
+    return { (float) (b0 / a0), (float) (b1 / a0), (float) (b2 / a0), (float) (a1 / a0), (float) (a2 / a0) };
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "FastMath.h"
+#include <array>
+
+//==============================================================================
+/** Normalised biquad (a0 = 1), designed in place without allocating. */
+struct Biquad
+{
+    enum class Type { lowpass, highpass, bandpass, notch, allpass, peak };
+
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+
+    /** The Q juce::dsp::IIR::Coefficients uses when none is given. */
+    static constexpr float butterworthQ = 0.70710678f;
+
+    /** Audio EQ Cookbook designs, the same responses as juce::dsp::IIR::Coefficients::make*. */
+    static Biquad design (Type type, double sampleRate, float frequency, float q, float gainDecibels = 0.0f) noexcept;
+};
+
+//==============================================================================
+/**
+    BiquadCascade - Up to eight biquads in series, pipelined across vector lanes
+
+    Coefficients and state are stored structure-of-arrays, one lane per stage.
+    Each step of the loop runs every stage once in parallel: stage k filters
+    sample t - k while stage k + 1 takes what stage k produced on the previous
+    step. A sample therefore passes through the whole cascade in one pass over
+    the block instead of one pass per stage, and the stage arithmetic is the
+    same transposed direct form II as a plain loop, so the result matches
+    running the stages one after another.
+
+    The pipeline fills and drains inside every call (lanes outside their
+    stretch of samples keep their state), so there is no added latency and
+    blocks can be any length. Stages past numStages pass samples through.
+*/
+namespace BiquadCascade
+{
+    static constexpr int maxStages = 8;
+    using Lanes = std::array<float, maxStages>;
+
+    /** Coefficients of every stage, shared by all channels. */
+    struct Coefficients
+    {
+        alignas (32) Lanes b0, b1, b2, a1, a2;
+        int numStages = 1;
+
+        Coefficients() noexcept { clear(); }
+
+        /** Every stage passes through; numStages is left at one. */
+        void clear() noexcept
+        {
+            b0.fill (1.0f); b1.fill (0.0f); b2.fill (0.0f); a1.fill (0.0f); a2.fill (0.0f);
+            numStages = 1;
+        }
+
+        void setStage (int stage, const Biquad& c) noexcept
+        {
+            b0[(size_t) stage] = c.b0; b1[(size_t) stage] = c.b1; b2[(size_t) stage] = c.b2;
+            a1[(size_t) stage] = c.a1; a2[(size_t) stage] = c.a2;
+        }
+
+        /** Uses stages [0, newNumStages) and turns the rest into pass-throughs. */
+        void setNumStages (int newNumStages) noexcept
+        {
+            numStages = juce::jlimit (1, maxStages, newNumStages);
+
+            for (int stage = numStages; stage < maxStages; ++stage)
+                setStage (stage, {});
+        }
+    };
+
+    /** Filter state of one channel. */
+    struct State
+    {
+        alignas (32) Lanes s1 {}, s2 {};
+
+        void reset() noexcept { s1.fill (0.0f); s2.fill (0.0f); }
+    };
+
+    /** Filters numSamples in place through c.numStages stages. */
+    inline void process (const Coefficients& c, State& state, float* samples, int numSamples) noexcept
+    {
+        const int lastStage = c.numStages - 1;
+
+        alignas (32) Lanes input {}, output {};
+
+        for (int t = 0; t < numSamples + lastStage; ++t)
+        {
+            input[0] = t < numSamples ? samples[t] : 0.0f;
+
+            for (int k = 0; k < maxStages; ++k)
+            {
+                const float x = input[(size_t) k];
+                const float y = c.b0[(size_t) k] * x + state.s1[(size_t) k];
+                const float s1 = c.b1[(size_t) k] * x - c.a1[(size_t) k] * y + state.s2[(size_t) k];
+                const float s2 = c.b2[(size_t) k] * x - c.a2[(size_t) k] * y;
+
+                // Stage k holds sample t - k; outside the block it is filling or draining and keeps its state
+                const bool active = (unsigned) (t - k) < (unsigned) numSamples;
+                state.s1[(size_t) k] = FastMath::select (active, s1, state.s1[(size_t) k]);
+                state.s2[(size_t) k] = FastMath::select (active, s2, state.s2[(size_t) k]);
+                output[(size_t) k] = y;
+            }
+
+            if (t >= lastStage)
+                samples[t - lastStage] = output[(size_t) lastStage];
+
+            for (int k = 1; k < maxStages; ++k)
+                input[(size_t) k] = output[(size_t) k - 1];
+        }
+    }
+}
@@ -0,0 +1,168 @@
+/*
+    WubForgeBiquadCascadeTest - BiquadCascade against plain sequential biquads
+
+    Runs a noise burst through BiquadCascade::process for every stage count from
+    1 to maxStages, split into blocks of odd lengths so the pipeline fills and
+    drains at every boundary, and compares it with the same stages run one
+    after another over the whole signal in transposed direct form II. Both do
+    the same float operations per stage, and the test target is built without
+    multiply-add contraction, so the outputs must be bit-identical. Returns
+    non-zero on any mismatch.
+
+    Registered with CTest as BiquadCascade.
+*/
+
+#include "BiquadCascade.h"
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+//==============================================================================
+/** Stages of assorted types, frequencies and Qs, all stable. */
+std::vector<Biquad> makeStages (double sampleRate)
+{
+    using Type = Biquad::Type;
+
+    return {
+        Biquad::design (Type::lowpass,  sampleRate, 2500.0f, 0.9f),
+        Biquad::design (Type::highpass, sampleRate, 40.0f,   Biquad::butterworthQ),
+        Biquad::design (Type::peak,     sampleRate, 120.0f,  4.0f, 9.0f),
+        Biquad::design (Type::bandpass, sampleRate, 800.0f,  2.0f),
+        Biquad::design (Type::notch,    sampleRate, 3000.0f, 6.0f),
+        Biquad::design (Type::allpass,  sampleRate, 600.0f,  0.5f),
+        Biquad::design (Type::peak,     sampleRate, 9000.0f, 1.0f, -6.0f),
+        Biquad::design (Type::lowpass,  sampleRate, 15000.0f, 12.0f),
+    };
+}
+
+/** The reference: each stage over the whole signal in turn. */
+std::vector<float> processSequentially (const std::vector<Biquad>& stages, int numStages, std::vector<float> samples)
+{
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        const auto& c = stages[(size_t) stage];
+        float s1 = 0.0f, s2 = 0.0f;
+
+        for (auto& sample : samples)
+        {
+            const float x = sample;
+            const float y = c.b0 * x + s1;
+            s1 = c.b1 * x - c.a1 * y + s2;
+            s2 = c.b2 * x - c.a2 * y;
+            sample = y;
+        }
+    }
+
+    return samples;
+}
+
+/** Runs the cascade over the signal in consecutive blocks of the given sizes, cycling through them.
+    Every stage is loaded first and then cut down to numStages, so stages past it must not reach the output. */
+std::vector<float> processCascade (const std::vector<Biquad>& stages, int numStages,
+                                   std::vector<float> samples, const std::vector<int>& blockSizes)
+{
+    BiquadCascade::Coefficients coefficients;
+
+    for (int stage = 0; stage < BiquadCascade::maxStages; ++stage)
+        coefficients.setStage (stage, stages[(size_t) stage]);
+
+    coefficients.setNumStages (numStages);
+
+    BiquadCascade::State state;
+    state.reset();
+
+    const int numSamples = (int) samples.size();
+
+    for (int start = 0, block = 0; start < numSamples; ++block)
+    {
+        const int n = std::min (blockSizes[(size_t) block % blockSizes.size()], numSamples - start);
+        BiquadCascade::process (coefficients, state, samples.data() + start, n);
+        start += n;
+    }
+
+    return samples;
+}
+
+/** Index of the first sample that differs, or -1. NaNs never compare equal, so they count. */
+int findMismatch (const std::vector<float>& a, const std::vector<float>& b)
+{
+    for (size_t i = 0; i < a.size(); ++i)
+        if (! (a[i] == b[i]))
+            return (int) i;
+
+    return -1;
+}
+} // namespace
+
+//==============================================================================
+int main()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numSamples = 4801;
+
+    const auto stages = makeStages (sampleRate);
+
+    // A noise burst then silence, so the tails of the resonant stages are compared too
+    std::vector<float> input ((size_t) numSamples, 0.0f);
+    std::mt19937 random (1234);
+    std::uniform_real_distribution<float> noise (-1.0f, 1.0f);
+
+    for (int i = 0; i < numSamples / 2; ++i)
+        input[(size_t) i] = noise (random);
+
+    const std::vector<std::vector<int>> blockPatterns {
+        { 1 }, { 3 }, { 7 }, { 63 }, { 511 }, { numSamples },
+        { 5, 1, 33, 9, 127, 3 }     // Blocks shorter and longer than the pipeline, mixed
+    };
+
+    int failures = 0;
+    std::vector<float> previous = input;
+    std::cout << std::setprecision (9);     // Enough digits to show a one-ulp mismatch
+
+    for (int numStages = 1; numStages <= BiquadCascade::maxStages; ++numStages)
+    {
+        const auto expected = processSequentially (stages, numStages, input);
+
+        // Each stage must change the output well above rounding, or a stage dropped,
+        // repeated or left running past numStages could pass unnoticed
+        float peak = 0.0f, change = 0.0f;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            peak = std::max (peak, std::abs (expected[(size_t) i]));
+            change = std::max (change, std::abs (expected[(size_t) i] - previous[(size_t) i]));
+        }
+
+        if (! (change > 1.0e-3f * peak))
+        {
+            ++failures;
+            std::cout << "FAIL  stage " << numStages << " barely changes the signal (" << change
+                      << " against a peak of " << peak << "), so it is not being tested" << std::endl;
+        }
+
+        previous = expected;
+
+        for (const auto& blockSizes : blockPatterns)
+        {
+            const auto actual = processCascade (stages, numStages, input, blockSizes);
+            const int mismatch = findMismatch (actual, expected);
+
+            if (mismatch >= 0)
+            {
+                ++failures;
+                std::cout << "FAIL  " << numStages << " stages, first block " << blockSizes.front()
+                          << ": sample " << mismatch << " is " << actual[(size_t) mismatch]
+                          << ", expected " << expected[(size_t) mismatch] << std::endl;
+            }
+        }
+    }
+
+    if (failures == 0)
+        std::cout << "BiquadCascade matches sequential biquads exactly for 1 to " << BiquadCascade::maxStages << " stages" << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
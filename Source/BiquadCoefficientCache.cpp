@@ -0,0 +1,147 @@
+#include "BiquadCoefficientCache.h"
+#include <atomic>
+#include <cstdint>
+
+namespace
+{
+    constexpr int pointsPerOctave = 48;
+    constexpr float minNormalised = 1.0e-4f;
+    constexpr float maxNormalised = 0.49f;
+
+    // Enough points to cover [minNormalised, maxNormalised] plus the right-hand neighbour of the last
+    constexpr int numPoints = 592;
+
+    constexpr int numCurves = 128;
+    constexpr int maxProbes = 16;
+
+    // Designs are run at a rate high enough that Biquad::design's 10 Hz floor sits below minNormalised
+    constexpr double designRate = 1.0e6;
+
+    constexpr float qStepsPerOctave = 24.0f;
+    constexpr float gainStepsPerDecibel = 10.0f;
+
+    enum : std::uint32_t { empty = 0, writing = 1, ready = 2 };
+
+    struct Point
+    {
+        std::atomic<std::uint32_t> state { empty };
+        float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    };
+}
+
+struct BiquadCoefficientCache::Slot
+{
+    std::atomic<std::uint64_t> key { 0 }; // 0 = unclaimed
+    Point points[numPoints];
+};
+
+namespace
+{
+    using Slot = BiquadCoefficientCache::Slot;
+
+    // Zero-initialised and untouched until used, so unclaimed slots cost no resident memory
+    Slot slots[numCurves];
+
+    std::uint64_t hashKey (std::uint64_t key) noexcept
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return key;
+    }
+
+    /** The slot for a key, claiming a free one if needed; nullptr when the table is full. */
+    Slot* findSlot (std::uint64_t key) noexcept
+    {
+        const auto start = (int) (hashKey (key) % numCurves);
+
+        for (int probe = 0; probe < maxProbes; ++probe)
+        {
+            auto& slot = slots[(start + probe) % numCurves];
+            auto existing = slot.key.load (std::memory_order_acquire);
+
+            if (existing == key)
+                return &slot;
+
+            if (existing == 0 && slot.key.compare_exchange_strong (existing, key, std::memory_order_acq_rel))
+                return &slot;
+
+            // Lost the race for an empty slot: it may have been claimed for the same key
+            if (existing == key)
+                return &slot;
+        }
+
+        return nullptr;
+    }
+
+    /** Designs a grid point and publishes it, unless another thread already is. */
+    JUCE_NOINLINE Biquad fillPoint (Point& point, Biquad::Type type, int index, float q, float gainDecibels) noexcept
+    {
+        const double normalised = minNormalised * std::exp2 ((double) index / pointsPerOctave);
+        const auto c = Biquad::design (type, designRate, (float) (normalised * designRate), q, gainDecibels);
+
+        auto expected = (std::uint32_t) empty;
+        if (point.state.compare_exchange_strong (expected, writing, std::memory_order_acquire))
+        {
+            point.b0 = c.b0; point.b1 = c.b1; point.b2 = c.b2; point.a1 = c.a1; point.a2 = c.a2;
+            point.state.store (ready, std::memory_order_release);
+        }
+
+        return c;
+    }
+}
+
+//==============================================================================
+BiquadCoefficientCache::Curve::Curve (Biquad::Type t, float newQ, float newGainDecibels) noexcept
+    : type (t)
+{
+    // Quantise the parameters that select a curve
+    const auto qIndex = (std::int32_t) FastMath::roundNearest (FastMath::log (juce::jmax (0.01f, newQ)) * (qStepsPerOctave / FastMath::ln2));
+    const auto gainIndex = (std::int32_t) FastMath::roundNearest (newGainDecibels * gainStepsPerDecibel);
+
+    q = FastMath::exp ((float) qIndex * (FastMath::ln2 / qStepsPerOctave));
+    gainDecibels = (float) gainIndex / gainStepsPerDecibel;
+
+    slot = findSlot (((std::uint64_t) type + 1) << 56
+                     | (std::uint64_t) (std::uint16_t) qIndex << 32
+                     | (std::uint64_t) (std::uint32_t) gainIndex);
+}
+
+Biquad BiquadCoefficientCache::Curve::get (double sampleRate, float frequency) const noexcept
+{
+    if (slot == nullptr)
+        return Biquad::design (type, sampleRate, frequency, q, gainDecibels);
+
+    // Position on the log-frequency grid
+    const float normalised = juce::jlimit (minNormalised, maxNormalised, frequency / (float) sampleRate);
+    const float position = FastMath::log (normalised * (1.0f / minNormalised)) * ((float) pointsPerOctave / FastMath::ln2);
+    const int index = juce::jlimit (0, numPoints - 2, (int) position);
+    const float t = position - (float) index;
+
+    auto& p0 = slot->points[index];
+    auto& p1 = slot->points[index + 1];
+
+    const auto lower = p0.state.load (std::memory_order_acquire) == ready ? Biquad { p0.b0, p0.b1, p0.b2, p0.a1, p0.a2 }
+                                                                          : fillPoint (p0, type, index, q, gainDecibels);
+    const auto upper = p1.state.load (std::memory_order_acquire) == ready ? Biquad { p1.b0, p1.b1, p1.b2, p1.a1, p1.a2 }
+                                                                          : fillPoint (p1, type, index + 1, q, gainDecibels);
+
+    return { lower.b0 + t * (upper.b0 - lower.b0),
+             lower.b1 + t * (upper.b1 - lower.b1),
+             lower.b2 + t * (upper.b2 - lower.b2),
+             lower.a1 + t * (upper.a1 - lower.a1),
+             lower.a2 + t * (upper.a2 - lower.a2) };
+}
+
+void BiquadCoefficientCache::assign (juce::dsp::IIR::Coefficients<float>& target, const Biquad& c)
+{
+    // Normalised biquad layout: b0, b1, b2, a1, a2
+    target.coefficients.resize (5);
+
+    auto* raw = target.getRawCoefficients();
+    raw[0] = c.b0;
+    raw[1] = c.b1;
+    raw[2] = c.b2;
+    raw[3] = c.a1;
+    raw[4] = c.a2;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "BiquadCascade.h"
+
+//==============================================================================
+/**
+    BiquadCoefficientCache - Process-wide table of biquad designs
+
+    Every IIR module asks here instead of running the cookbook trig (and, for
+    juce::dsp::IIR filters, allocating a new Coefficients object) whenever a
+    cutoff moves. Designs are keyed by type, Q (quantised to 1/24 octave) and
+    gain (0.1 dB), and each key owns a curve sampled at 48 points per octave of
+    normalised frequency, from 1e-4 up to 0.49 of the sample rate. A lookup
+    interpolates the two neighbouring points linearly, which stays within
+    0.1 dB of the exact design above 100 Hz. Because the curves are normalised,
+    every sample rate shares them.
+
+    The table is fixed-size and lock-free. A point is designed the first time
+    it is read and published with a release store; readers that race with the
+    writer design their own copy. When every curve slot is taken, lookups fall
+    back to Biquad::design. A lookup never allocates or blocks, so it is safe
+    on the audio thread.
+*/
+namespace BiquadCoefficientCache
+{
+    struct Slot;
+
+    /** One type, Q and gain, found once and then read at any frequency. Hold one
+        where the frequency moves but the rest stays put (e.g. per block). */
+    class Curve
+    {
+    public:
+        Curve (Biquad::Type type, float q, float gainDecibels = 0.0f) noexcept;
+
+        /** Coefficients at frequency, interpolated from the shared table. */
+        Biquad get (double sampleRate, float frequency) const noexcept;
+
+    private:
+        Slot* slot;
+        Biquad::Type type;
+        float q, gainDecibels; // Quantised
+    };
+
+    /** One-off lookup, the same as Curve (type, q, gainDecibels).get (sampleRate, frequency). */
+    inline Biquad get (Biquad::Type type, double sampleRate, float frequency, float q, float gainDecibels = 0.0f) noexcept
+    {
+        return Curve (type, q, gainDecibels).get (sampleRate, frequency);
+    }
+
+    /** Writes c into an existing juce::dsp::IIR::Coefficients object. Only the first
+        write to an object that is not already second order resizes its storage. */
+    void assign (juce::dsp::IIR::Coefficients<float>& target, const Biquad& c);
+}
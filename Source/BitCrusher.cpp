@@ -1,4 +1,21 @@
 #include "BitCrusher.h"
+#include "BiquadCoefficientCache.h"
+
+//==============================================================================
+namespace
+{
+    /** Integer hash (lowbias32). Dither is hashed from its sample index rather than
+        stepped through a generator, so a chunk of it is one vectorised pass. */
+    inline std::uint32_t hash (std::uint32_t x) noexcept
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+}
 
 //==============================================================================
 BitCrusher::BitCrusher()
@@ -10,81 +27,139 @@ BitCrusher::~BitCrusher()
 }
 
 //==============================================================================
-void BitCrusher::prepareToPlay (double sampleRate, int samplesPerBlock)
+void BitCrusher::prepare (const juce::dsp::ProcessSpec& spec)
 {
-    this->sampleRate = sampleRate;
+    sampleRate = spec.sampleRate;
 
-    juce::dsp::ProcessSpec spec { sampleRate, static_cast<juce::uint32>(samplesPerBlock), 1 };
-
-    // Prepare anti-aliasing filter
-    auto filterCoeffs = juce::dsp::IIR::Coefficients<float>::makeLowPass (sampleRate, filterCutoff);
-    antiAliasingFilter.prepare (spec);
-    antiAliasingFilter.reset();
-    *antiAliasingFilter.state = *filterCoeffs;
-
-    // Prepare dry/wet mixer
-    mixer.prepare (spec);
-    mixer.setWetMixProportion (dryWetMix);
+    // One filter, error and dither sequence per channel
+    channelStates.resize (spec.numChannels);
 
     reset();
-    updateFilter();
 }
 
 void BitCrusher::reset()
 {
-    antiAliasingFilter.reset();
-    mixer.reset();
+    for (size_t ch = 0; ch < channelStates.size(); ++ch)
+    {
+        channelStates[ch] = {};
+        channelStates[ch].ditherIndex = (std::uint32_t) ch * 0x9e3779b9u; // Far apart, so channels dither independently
+    }
+
     currentBitDepth = bitDepth;
     currentFilterCutoff = filterCutoff;
     lastFilterCutoff = filterCutoff;
+    lastMix = dryWetMix;
+
+    antiAliasingFilter = BiquadCoefficientCache::get (Biquad::Type::lowpass, sampleRate, currentFilterCutoff, Biquad::butterworthQ);
 }
 
 //==============================================================================
-void BitCrusher::process (juce::dsp::ProcessContextReplacing<float>& context)
+void BitCrusher::process (const juce::dsp::ProcessContextReplacing<float>& context)
 {
-    auto& inputBlock = context.getInputBlock();
-    auto& outputBlock = context.getOutputBlock();
-    auto numSamples = outputBlock.getNumSamples();
-    auto numChannels = outputBlock.getNumChannels();
+    auto block = context.getOutputBlock();
+    const auto numSamples = (int) block.getNumSamples();
+    const auto numChannels = std::min (block.getNumChannels(), channelStates.size());
 
-    // Update dry/wet mix
-    mixer.setWetMixProportion (dryWetMix);
+    if (numSamples == 0)
+        return;
 
-    for (int sample = 0; sample < numSamples; ++sample)
-    {
-        float processedSample = 0.0f;
+    currentBitDepth = bitDepth;
 
-        // Sum input channels for mono processing
-        for (size_t channel = 0; channel < numChannels; ++channel)
-        {
-            processedSample += inputBlock.getSample (channel, sample);
-        }
-        processedSample /= static_cast<float>(numChannels);
+    // Glide the cutoff towards its target, one step per block
+    if (currentFilterCutoff != filterCutoff)
+        updateFilter();
 
-        // Apply bit crushing
-        processedSample = processBitCrushing (processedSample);
+    // Ramp the mix across the block instead of stepping it
+    const float mixStep = (dryWetMix - lastMix) / (float) numSamples;
 
-        // Note: Anti-aliasing filter commented out due to AudioBlock constructor compatibility issues
-        // In a production version, this would apply a low-pass filter to remove aliasing artifacts
+    for (size_t ch = 0; ch < numChannels; ++ch)
+        processChannel (block.getChannelPointer (ch), numSamples, channelStates[ch], lastMix, mixStep);
 
-        // Apply dry/wet mix
-        float wetSample = processedSample;
-        float drySample = 0.0f;
+    lastMix = dryWetMix;
+}
 
-        for (size_t channel = 0; channel < numChannels; ++channel)
+void BitCrusher::processChannel (float* samples, int numSamples, ChannelState& state,
+                                 float mix, float mixStep) noexcept
+{
+    constexpr int chunkSize = 64;
+    alignas (16) float dither[chunkSize];
+    alignas (16) float wet[chunkSize];
+
+    // Levels per unit, as 2^bits; 16 bits and up passes through unquantised
+    const bool quantise = currentBitDepth < 16.0f;
+    const float scale = std::exp2 (currentBitDepth);
+    const float step = 1.0f / scale;
+
+    const Biquad c = antiAliasingFilter;
+    float s1 = state.s1, s2 = state.s2, error = state.error;
+    std::uint32_t ditherIndex = state.ditherIndex;
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int n = std::min (chunkSize, numSamples - start);
+        float* chunk = samples + start;
+
+        // TPDF dither: the difference of two uniform 16-bit draws, one step either side
+        if (ditherEnabled)
+        {
+            const float ditherScale = step / 65536.0f;
+
+            for (int i = 0; i < n; ++i)
+            {
+                const std::uint32_t h = hash (ditherIndex + (std::uint32_t) i);
+                dither[i] = ((float) (h & 0xffffu) - (float) (h >> 16)) * ditherScale;
+            }
+
+            ditherIndex += (std::uint32_t) n;
+        }
+        else
         {
-            drySample += inputBlock.getSample (channel, sample);
+            std::fill (dither, dither + n, 0.0f);
         }
-        drySample /= static_cast<float>(numChannels);
 
-        float outputSample = drySample * (1.0f - dryWetMix) + wetSample * dryWetMix;
+        if (! quantise)
+        {
+            std::copy (chunk, chunk + n, wet);
+        }
+        else if (noiseShapingEnabled)
+        {
+            // Error feedback: each sample is corrected by the last one's quantisation
+            // error, which leaves that error high-passed by (1 - z^-1) in the output
+            for (int i = 0; i < n; ++i)
+            {
+                const float v = chunk[i] - error;
+                const float y = FastMath::roundNearest ((v + dither[i]) * scale) * step;
+                error = y - v;
+                wet[i] = y;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < n; ++i)
+                wet[i] = FastMath::roundNearest ((chunk[i] + dither[i]) * scale) * step;
+        }
 
-        // Write to all output channels
-        for (size_t channel = 0; channel < numChannels; ++channel)
+        // Anti-aliasing lowpass over the crushed signal
+        for (int i = 0; i < n; ++i)
         {
-            outputBlock.setSample (channel, sample, outputSample);
+            const float x = wet[i];
+            const float y = c.b0 * x + s1;
+            s1 = c.b1 * x - c.a1 * y + s2;
+            s2 = c.b2 * x - c.a2 * y;
+            wet[i] = y;
         }
+
+        // Dry/wet, written back over the input
+        const float chunkMix = mix + (float) start * mixStep;
+
+        for (int i = 0; i < n; ++i)
+            chunk[i] += (chunkMix + (float) i * mixStep) * (wet[i] - chunk[i]);
     }
+
+    state.s1 = s1;
+    state.s2 = s2;
+    state.error = error;
+    state.ditherIndex = ditherIndex;
 }
 
 //==============================================================================
@@ -95,8 +170,8 @@ void BitCrusher::setBitDepth (float depth)
 
 void BitCrusher::setFilterCutoff (float cutoffHz)
 {
+    // The filter follows at the next block
     filterCutoff = (cutoffHz < 100.0f) ? 100.0f : (cutoffHz > static_cast<float>(sampleRate) / 2.0f) ? static_cast<float>(sampleRate) / 2.0f : cutoffHz;
-    updateFilter();
 }
 
 void BitCrusher::setDryWetMix (float mix)
@@ -104,28 +179,21 @@ void BitCrusher::setDryWetMix (float mix)
     dryWetMix = (mix < 0.0f) ? 0.0f : (mix > 1.0f) ? 1.0f : mix;
 }
 
-//==============================================================================
-float BitCrusher::processBitCrushing (float input)
+void BitCrusher::setDither (bool shouldDither)
 {
-    if (bitDepth >= 16.0f)
-        return input;
-
-    // Calculate bit depth scaling
-    int numBits = static_cast<int>(bitDepth);
-    float scale = static_cast<float>(1 << numBits);  // 2^bits
-
-    // Quantize the signal
-    float quantized = std::round (input * scale) / scale;
+    ditherEnabled = shouldDither;
+}
 
-    // Mix between dry and crushed signal based on bit depth
-    float crushAmount = 1.0f - (bitDepth / 16.0f);
-    return input * (1.0f - crushAmount) + quantized * crushAmount;
+void BitCrusher::setNoiseShaping (bool shouldShapeNoise)
+{
+    noiseShapingEnabled = shouldShapeNoise;
 }
 
+//==============================================================================
 void BitCrusher::updateFilter()
 {
     // Smooth filter cutoff changes
-    float slewRate = 100.0f; // Hz per sample
+    float slewRate = 100.0f; // Hz per block
     float cutoffDiff = filterCutoff - lastFilterCutoff;
 
     if (std::abs (cutoffDiff) > slewRate)
@@ -139,7 +207,6 @@ void BitCrusher::updateFilter()
 
     lastFilterCutoff = currentFilterCutoff;
 
-    // Update filter coefficients
-    auto filterCoeffs = juce::dsp::IIR::Coefficients<float>::makeLowPass (sampleRate, currentFilterCutoff);
-    *antiAliasingFilter.state = *filterCoeffs;
-}
\ No newline at end of file
+    // Update filter coefficients from the shared cache
+    antiAliasingFilter = BiquadCoefficientCache::get (Biquad::Type::lowpass, sampleRate, currentFilterCutoff, Biquad::butterworthQ);
+}
@@ -1,27 +1,44 @@
 #pragma once
 
-#include <juce_audio_processors/juce_audio_processors.h>
-#include <juce_dsp/juce_dsp.h>
+#include "Module.h"
+#include "BiquadCascade.h"
 
 //==============================================================================
-class BitCrusher
+/**
+    BitCrusher - Bit depth reduction with optional dither and noise shaping
+
+    Channels are crushed independently. Each block is worked through in short
+    chunks that stay in cache, so the input is read from memory once: dither,
+    quantiser and mix are branch-free passes that vectorise, and only the
+    anti-aliasing lowpass (and the quantiser, when noise shaping feeds its
+    error back) runs sample by sample.
+
+    Dither is TPDF, one step wide either side, drawn from a counter-based hash
+    so a whole chunk is generated in one vectorised pass. First-order error
+    feedback shapes the quantisation noise by (1 - z^-1), pushing it up in
+    frequency where the lowpass takes most of it away.
+*/
+class BitCrusher : public DistortionModule
 {
 public:
     BitCrusher();
     ~BitCrusher();
 
     //==============================================================================
-    void prepareToPlay (double sampleRate, int samplesPerBlock);
-    void reset();
+    // AudioModule interface
+    void prepare (const juce::dsp::ProcessSpec& spec) override;
+    void process (const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
 
-    //==============================================================================
-    void process (juce::dsp::ProcessContextReplacing<float>& context);
+    const juce::String getName() const override { return "Bit Crusher"; }
 
     //==============================================================================
     // Parameter setters
     void setBitDepth (float bitDepth);
     void setFilterCutoff (float cutoffHz);
     void setDryWetMix (float mix);
+    void setDither (bool shouldDither);
+    void setNoiseShaping (bool shouldShapeNoise);
 
     //==============================================================================
     // Getters for visualization
@@ -31,9 +48,17 @@ public:
 
 private:
     //==============================================================================
+    // Per-channel state
+    struct ChannelState
+    {
+        float s1 = 0.0f, s2 = 0.0f;     // Anti-aliasing filter (transposed direct form II)
+        float error = 0.0f;             // Last quantisation error, for noise shaping
+        std::uint32_t ditherIndex = 0;  // Position in this channel's dither sequence
+    };
+
     // DSP Components
-    juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>> antiAliasingFilter;
-    juce::dsp::DryWetMixer<float> mixer;
+    Biquad antiAliasingFilter;
+    std::vector<ChannelState> channelStates;
 
     // Parameters
     float bitDepth = 8.0f;          // Bit depth (1-16 bits)
@@ -41,14 +66,18 @@ private:
     float filterCutoff = 8000.0f;   // Filter cutoff frequency (Hz)
     float currentFilterCutoff = 8000.0f;
     float dryWetMix = 1.0f;         // Dry/wet mix (0 = dry, 1 = wet)
+    bool ditherEnabled = false;
+    bool noiseShapingEnabled = false;
 
     // State
     double sampleRate = 44100.0;
     float lastFilterCutoff = 8000.0f;
+    float lastMix = 1.0f;           // Mix at the end of the last block, ramped from
 
     //==============================================================================
-    float processBitCrushing (float input);
+    void processChannel (float* samples, int numSamples, ChannelState& state,
+                         float mix, float mixStep) noexcept;
     void updateFilter();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BitCrusher)
-};
\ No newline at end of file
+};
@@ -0,0 +1,155 @@
+/*
+    WubForgeDSPBenchmark - Processing cost of the distortion modules
+
+    Runs DistortionForge and UniversalDistortionModule over the same stereo test
+    signal with matched settings, so each pair shapes with the equivalent curve,
+    and reports the time per block and per sample.
+
+    Usage:
+        WubForgeDSPBenchmark [--blocks=N] [--block-size=N] [--sample-rate=Hz]
+
+        --blocks       Timed blocks per configuration (default 2000)
+        --block-size   Samples per block (default 512)
+        --sample-rate  Sample rate in Hz (default 48000)
+*/
+
+#include "DistortionForge.h"
+#include "UniversalDistortionModule.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <numeric>
+
+namespace
+{
+//==============================================================================
+struct Timings
+{
+    std::vector<double> microseconds;
+
+    void report (const juce::String& label, int samplesPerBlock) const
+    {
+        auto sorted = microseconds;
+        std::sort (sorted.begin(), sorted.end());
+
+        const auto at = [&sorted] (double fraction) { return sorted[(size_t) (fraction * (double) (sorted.size() - 1))]; };
+        const double mean = std::accumulate (sorted.begin(), sorted.end(), 0.0) / (double) sorted.size();
+
+        std::cout << label.paddedRight (' ', 44)
+                  << "  mean " << juce::String (mean, 2).paddedLeft (' ', 8)
+                  << "  median " << juce::String (at (0.5), 2).paddedLeft (' ', 8)
+                  << "  p95 " << juce::String (at (0.95), 2).paddedLeft (' ', 8)
+                  << "  max " << juce::String (sorted.back(), 2).paddedLeft (' ', 8) << " us"
+                  << "  (" << juce::String (1000.0 * at (0.5) / samplesPerBlock, 2) << " ns/sample)" << std::endl;
+    }
+};
+
+/** A module set up for one curve. */
+struct Configuration
+{
+    juce::String label;
+    std::function<std::unique_ptr<AudioModule>()> create;
+};
+
+std::unique_ptr<AudioModule> forge (DistortionForge::Algorithm algorithm, float driveDB,
+                                    std::function<void (DistortionForge&)> configure = {})
+{
+    auto module = std::make_unique<DistortionForge>();
+    module->setAlgorithm (algorithm);
+    module->setDrive (driveDB);
+
+    if (configure)
+        configure (*module);
+
+    return module;
+}
+
+std::unique_ptr<AudioModule> universal (UniversalDistortionModule::Model model,
+                                        std::function<void (UniversalDistortionModule&)> configure)
+{
+    auto module = std::make_unique<UniversalDistortionModule>();
+    module->setModel (model);
+    configure (*module);
+    return module;
+}
+
+/** Matched pairs. UniversalDistortionModule's fold drive is 1 + 5 * amount and its crush
+    depth runs from 16 bits down to 2; its clippers are circuit models, so they are set
+    against the forge clipper closest in character at the same gain. */
+std::vector<Configuration> configurations()
+{
+    using Algorithm = DistortionForge::Algorithm;
+    using Model = UniversalDistortionModule::Model;
+
+    const float foldAmount = 0.6f;
+    const float foldDriveDB = juce::Decibels::gainToDecibels (1.0f + 5.0f * foldAmount);
+    const float crushAmount = 0.5f;
+    const float crushBits = juce::jmap (crushAmount, 16.0f, 2.0f);
+
+    return {
+        { "sine fold      Distortion Forge (ADAA)",   [=] { return forge (Algorithm::Wavefold, foldDriveDB); } },
+        { "sine fold      Universal Digital",         [=] { return universal (Model::Digital, [=] (auto& m) { m.setDigitalWavefold (foldAmount); }); } },
+        { "bit crush      Distortion Forge",          [=] { return forge (Algorithm::BitCrush, 0.0f, [=] (auto& m) { m.setBitDepth (crushBits); }); } },
+        { "bit crush      Universal Digital",         [=] { return universal (Model::Digital, [=] (auto& m) { m.setDigitalBitcrush (crushAmount); }); } },
+        { "hard clip      Distortion Forge (ADAA)",   [=] { return forge (Algorithm::HardClip, 20.0f); } },
+        { "hard clip      Universal Rodent",          [=] { return universal (Model::Rodent, [=] (auto& m) { m.setRodentDrive (0.5f); }); } },
+        { "soft clip      Distortion Forge tanh",     [=] { return forge (Algorithm::Tanh, 20.0f); } },
+        { "soft clip      Distortion Forge x/(1+|x|)", [=] { return forge (Algorithm::SoftClip, 20.0f); } },
+        { "soft clip      Universal Screamer",        [=] { return universal (Model::Screamer, [=] (auto& m) { m.setScreamerDrive (0.5f); }); } },
+    };
+}
+
+void benchmark (const Configuration& configuration, double sampleRate, int blockSize, int numBlocks)
+{
+    constexpr int numChannels = 2;
+
+    auto module = configuration.create();
+    module->prepare ({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+    double phase = 0.0;
+
+    Timings timings;
+
+    // A few untimed blocks first, so smoothers settle and caches are warm
+    for (int i = -16; i < numBlocks; ++i)
+    {
+        // A bass note with some upper partials, the right channel a little detuned
+        for (int s = 0; s < blockSize; ++s)
+        {
+            buffer.setSample (0, s, (float) (0.5 * std::sin (phase) + 0.2 * std::sin (5.0 * phase)));
+            buffer.setSample (1, s, (float) (0.5 * std::sin (1.003 * phase) + 0.2 * std::sin (5.0 * phase)));
+            phase = std::fmod (phase + juce::MathConstants<double>::twoPi * 55.0 / sampleRate, juce::MathConstants<double>::twoPi * 1000.0);
+        }
+
+        juce::dsp::AudioBlock<float> block (buffer);
+        juce::dsp::ProcessContextReplacing<float> context (block);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        module->process (context);
+        const auto elapsed = juce::Time::getHighResolutionTicks() - start;
+
+        if (i >= 0)
+            timings.microseconds.push_back (1.0e6 * juce::Time::highResolutionTicksToSeconds (elapsed));
+    }
+
+    timings.report (configuration.label, blockSize);
+}
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    const int numBlocks = juce::jmax (1, args.containsOption ("--blocks") ? args.getValueForOption ("--blocks").getIntValue() : 2000);
+    const int blockSize = juce::jmax (1, args.containsOption ("--block-size") ? args.getValueForOption ("--block-size").getIntValue() : 512);
+    const double sampleRate = juce::jmax (8000.0, args.containsOption ("--sample-rate") ? args.getValueForOption ("--sample-rate").getDoubleValue() : 48000.0);
+
+    std::cout << "Stereo, " << blockSize << " samples per block at " << sampleRate << " Hz" << std::endl;
+
+    for (const auto& configuration : configurations())
+        benchmark (configuration, sampleRate, blockSize, numBlocks);
+
+    return 0;
+}
@@ -1,11 +1,60 @@
 #include "DistortionForge.h"
+#include "BiquadCoefficientCache.h"
+#include "FastMath.h"
+
+//==============================================================================
+namespace
+{
+    /** Multiplies by a gain that ramps linearly across the block. Vectorises. */
+    void applyGainRamp (float* __restrict samples, int numSamples, float gain, float step) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] *= gain + (float) i * step;
+    }
+
+    /** Rounds to the nearest of steps levels per unit. Vectorises. */
+    void quantise (float* __restrict samples, int numSamples, float steps, float stepSize) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] = FastMath::roundNearest (samples[i] * steps) * stepSize;
+    }
+
+    /** Scalar quantise(), for values held by the decimator. Steps of zero leaves x alone. */
+    float quantiseSample (float x, float steps, float stepSize) noexcept
+    {
+        return steps > 0.0f ? FastMath::roundNearest (x * steps) * stepSize : x;
+    }
+
+    /** Runs each (already driven) channel through its anti-aliased shaper. The bias
+        moves the operating point off-centre for asymmetric shaping; the shaper takes
+        the DC it causes back off the output. */
+    template <typename Shaper>
+    void processShaper (const juce::dsp::AudioBlock<float>& block, std::vector<Shaper>& shapers, float bias)
+    {
+        const auto numSamples = (int) block.getNumSamples();
+        const auto numChannels = std::min (block.getNumChannels(), shapers.size());
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            shapers[ch].setBias (bias);
+            shapers[ch].process (block.getChannelPointer (ch), numSamples);
+        }
+    }
+
+    template <typename Shaper>
+    void resetShapers (std::vector<Shaper>& shapers)
+    {
+        for (auto& shaper : shapers)
+            shaper.reset();
+    }
+}
 
 //==============================================================================
 DistortionForge::DistortionForge()
 {
     // Initialize DSP components
-    inputGain.setRampDurationSeconds(0.05);   // Smooth parameter changes
-    outputGain.setRampDurationSeconds(0.05);
+    driveGain.setCurrentAndTargetValue(1.0f);
+    outputGain.setRampDurationSeconds(0.05);  // Smooth parameter changes
     // Note: DryWetMixer doesn't have setRampDurationSeconds in this JUCE version
 
     // Set initial gain staging
@@ -25,12 +74,18 @@ void DistortionForge::prepare (const juce::dsp::ProcessSpec& spec)
     toneFilter.prepare(spec);
 
     // Prepare gain staging
-    inputGain.prepare(spec);
+    driveGain.reset(spec.sampleRate, 0.05);
     outputGain.prepare(spec);
     dryWetMixer.prepare(spec);
 
-    // Initialize bit crush buffer
-    bitCrushBuffer.resize(spec.maximumBlockSize);
+    // One shaper per channel for each algorithm
+    tanhShapers.resize(spec.numChannels);
+    hardClipShapers.resize(spec.numChannels);
+    softClipShapers.resize(spec.numChannels);
+    wavefoldShapers.resize(spec.numChannels);
+
+    // One sample-and-hold per channel
+    decimators.resize(spec.numChannels);
 
     // Reset to ensure clean state
     reset();
@@ -42,9 +97,12 @@ void DistortionForge::prepare (const juce::dsp::ProcessSpec& spec)
 
 void DistortionForge::process (const juce::dsp::ProcessContextReplacing<float>& context)
 {
-    // Apply input gain for drive control
+    // Keep the dry signal before the block is processed in place
+    dryWetMixer.pushDrySamples(context.getInputBlock());
+
+    // Apply the drive once, ahead of whichever algorithm runs
     auto inputContext = context;
-    inputGain.process(inputContext);
+    applyDrive(inputContext.getOutputBlock());
 
     // Route to appropriate distortion algorithm
     switch (currentAlgorithm)
@@ -73,19 +131,23 @@ void DistortionForge::process (const juce::dsp::ProcessContextReplacing<float>&
     outputGain.process(inputContext);
 
     // Apply dry/wet mixing
-    dryWetMixer.pushDrySamples(context.getInputBlock());
     dryWetMixer.mixWetSamples(inputContext.getOutputBlock());
 }
 
 void DistortionForge::reset()
 {
     toneFilter.reset();
-    inputGain.reset();
+    driveGain.setCurrentAndTargetValue(driveGain.getTargetValue());
     outputGain.reset();
     dryWetMixer.reset();
 
-    bitCrushCounter = 0;
-    bitCrushPhase = 0.0f;
+    resetShapers(tanhShapers);
+    resetShapers(hardClipShapers);
+    resetShapers(softClipShapers);
+    resetShapers(wavefoldShapers);
+
+    for (auto& decimator : decimators)
+        decimator = {};
 }
 
 //==============================================================================
@@ -93,6 +155,7 @@ void DistortionForge::reset()
 void DistortionForge::setAlgorithm (Algorithm algorithm)
 {
     currentAlgorithm = algorithm;
+    updateGainStaging();    // Output compensation depends on the algorithm
 }
 
 void DistortionForge::setDrive (float driveDB)
@@ -128,146 +191,141 @@ void DistortionForge::setSampleRateReduction (float reduction)
     this->sampleRateReduction = std::max(0.01f, std::min(1.0f, reduction));
 }
 
+void DistortionForge::setHoldMode (HoldMode mode)
+{
+    holdMode = mode;
+}
+
 //==============================================================================
 // Distortion Algorithm Implementations
 
 void DistortionForge::processTanh (const juce::dsp::ProcessContextReplacing<float>& context)
 {
-    auto block = context.getOutputBlock();
+    processShaper (context.getOutputBlock(), tanhShapers, biasAmount);
+}
 
-    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
-    {
-        auto* channelData = block.getChannelPointer(ch);
+void DistortionForge::processHardClip (const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    processShaper (context.getOutputBlock(), hardClipShapers, biasAmount);
+}
 
-        for (size_t i = 0; i < block.getNumSamples(); ++i)
-        {
-            // Apply DC bias for asymmetric distortion
-            float input = channelData[i] + biasAmount;
+void DistortionForge::processSoftClip (const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    processShaper (context.getOutputBlock(), softClipShapers, biasAmount);
+}
 
-            // Apply tanh distortion with drive scaling
-            float drive = std::pow(10.0f, driveDB / 20.0f);
-            channelData[i] = std::tanh(input * drive);
-        }
-    }
+void DistortionForge::processWavefold (const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    // Fold the signal into sine waves at multiples of pi
+    processShaper (context.getOutputBlock(), wavefoldShapers, biasAmount);
 }
 
-void DistortionForge::processHardClip (const juce::dsp::ProcessContextReplacing<float>& context)
+void DistortionForge::processBitCrush (const juce::dsp::ProcessContextReplacing<float>& context)
 {
     auto block = context.getOutputBlock();
+    const auto numSamples = (int) block.getNumSamples();
+    const auto numChannels = std::min(block.getNumChannels(), decimators.size());
 
-    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+    // Quantiser step, worked out once per block (zero steps: full resolution)
+    const bool reduceBits = bitDepth < 16.0f;
+    const float steps = reduceBits ? std::pow(2.0f, bitDepth) - 1.0f : 0.0f;
+    const float stepSize = reduceBits ? 1.0f / steps : 0.0f;
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
     {
         auto* channelData = block.getChannelPointer(ch);
 
-        for (size_t i = 0; i < block.getNumSamples(); ++i)
-        {
-            // Apply DC bias and drive scaling
-            float input = channelData[i] + biasAmount;
-            float drive = std::pow(10.0f, driveDB / 20.0f);
-
-            // Apply simple hard clipping (-1 to 1)
-            channelData[i] = std::max(-1.0f, std::min(1.0f, input * drive));
-        }
+        // With the rate reduced, only the held values need quantising
+        if (sampleRateReduction < 1.0f)
+            decimators[ch].process(channelData, numSamples, sampleRateReduction,
+                                   steps, stepSize, holdMode == HoldMode::BandLimited);
+        else if (reduceBits)
+            quantise(channelData, numSamples, steps, stepSize);
     }
 }
 
-void DistortionForge::processSoftClip (const juce::dsp::ProcessContextReplacing<float>& context)
+void DistortionForge::Decimator::process (float* samples, int numSamples, float rate,
+                                          float steps, float stepSize, bool bandLimited) noexcept
 {
-    auto block = context.getOutputBlock();
+    int i = 0;
 
-    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+    while (i < numSamples)
     {
-        auto* channelData = block.getChannelPointer(ch);
+        // Samples until the phase wraps, counting the one it wraps on
+        const int run = std::max(1, (int) std::ceil((1.0f - phase) / rate));
 
-        for (size_t i = 0; i < block.getNumSamples(); ++i)
+        if (i + run > numSamples)
         {
-            // Apply DC bias and drive scaling
-            float input = channelData[i] + biasAmount;
-            float drive = std::pow(10.0f, driveDB / 20.0f);
-
-            // Apply polynomial soft clipping (arctangent approximation)
-            float x = input * drive;
-            channelData[i] = x / (1.0f + std::abs(x));  // Simple soft clip
+            lastInput = samples[numSamples - 1];
+            std::fill(samples + i, samples + numSamples, held);
+            phase += (float) (numSamples - i) * rate;
+            return;
         }
-    }
-}
 
-void DistortionForge::processWavefold (const juce::dsp::ProcessContextReplacing<float>& context)
-{
-    auto block = context.getOutputBlock();
+        // Read the inputs around the wrap before the hold overwrites them
+        const int j = i + run - 1;
+        const float input = samples[j];
+        const float previousInput = j > i ? samples[j - 1] : lastInput;
 
-    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
-    {
-        auto* channelData = block.getChannelPointer(ch);
+        std::fill(samples + i, samples + j, held);
+        phase = std::max(0.0f, phase + (float) run * rate - 1.0f);
 
-        for (size_t i = 0; i < block.getNumSamples(); ++i)
+        if (bandLimited)
         {
-            // Apply DC bias and drive scaling
-            float input = channelData[i] + biasAmount;
-            float drive = std::pow(10.0f, driveDB / 20.0f);
-
-            // Apply simple wavefolding using sine function
-            float x = input * drive;
-            // Fold the signal into sine waves at multiples of pi
-            channelData[i] = std::sin(x);
-        }
-    }
-}
+            // The wrap fell d samples before sample j: sample the input there, then
+            // replace the step with a band-limited one, its two-sample polyBLEP
+            // residual split across sample j and the one before. At the start of a
+            // block that sample has already gone, so its half is dropped.
+            const float d = std::min(phase / rate, 1.0f);
+            const float value = quantiseSample(input + d * (previousInput - input), steps, stepSize);
+            const float step = value - held;
 
-void DistortionForge::processBitCrush (const juce::dsp::ProcessContextReplacing<float>& context)
-{
-    auto block = context.getOutputBlock();
-    auto numSamples = block.getNumSamples();
+            samples[j] = value - 0.5f * step * (1.0f - d) * (1.0f - d);
 
-    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
-    {
-        auto* channelData = block.getChannelPointer(ch);
+            if (j > 0)
+                samples[j - 1] += 0.5f * step * d * d;
 
-        for (size_t i = 0; i < numSamples; ++i)
+            held = value;
+        }
+        else
         {
-            // Sample rate reduction
-            float reductionFactor = sampleRateReduction;
-            if (reductionFactor < 1.0f)
-            {
-                bitCrushPhase += reductionFactor;
-
-                if (bitCrushPhase >= 1.0f)
-                {
-                    bitCrushPhase -= 1.0f;
-                    bitCrushBuffer[ch] = channelData[i];
-                }
-
-                channelData[i] = bitCrushBuffer[ch];
-            }
-
-            // Bit depth reduction
-            if (bitDepth < 16.0f)
-            {
-                float steps = std::pow(2.0f, bitDepth) - 1.0f;
-                float scale = 1.0f / steps;
-
-                // Quantize to bit depth
-                channelData[i] = std::round(channelData[i] / scale) * scale;
-            }
+            held = quantiseSample(input, steps, stepSize);
+            samples[j] = held;
         }
+
+        lastInput = input;
+        i = j + 1;
     }
 }
 
 //==============================================================================
 // Internal Helper Functions
 
+void DistortionForge::applyDrive (const juce::dsp::AudioBlock<float>& block)
+{
+    const auto numSamples = (int) block.getNumSamples();
+    if (numSamples == 0)
+        return;
+
+    // The smoother steps once per block and the gain ramps linearly between its values
+    const float start = driveGain.getCurrentValue();
+    const float step = (driveGain.skip(numSamples) - start) / (float) numSamples;
+
+    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+        applyGainRamp(block.getChannelPointer(ch), numSamples, start, step);
+}
+
 void DistortionForge::updateFilters()
 {
-    // Update tone filter coefficients
-    auto toneCoeffs = juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, toneFreqHz);
-    *toneFilter.state = *toneCoeffs;
+    // Update tone filter coefficients in place from the shared cache
+    BiquadCoefficientCache::assign(*toneFilter.state,
+                                   BiquadCoefficientCache::get(Biquad::Type::lowpass, sampleRate, toneFreqHz, Biquad::butterworthQ));
 }
 
 void DistortionForge::updateGainStaging()
 {
-    // Calculate input gain from drive parameter
-    float inputGainLinear = std::pow(10.0f, driveDB / 20.0f);
-    inputGain.setGainLinear(inputGainLinear);
+    // Drive gain, glided towards by applyDrive()
+    driveGain.setTargetValue(std::pow(10.0f, driveDB / 20.0f));
 
     // Calculate output gain compensation based on distortion algorithm
     float outputGainDB = 0.0f;
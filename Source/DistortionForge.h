@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Module.h"
+#include "Waveshapers.h"
 #include <juce_gui_extra/juce_gui_extra.h> // Temporarily for basic dependencies
 
 //==============================================================================
@@ -23,6 +24,13 @@ public:
         BitCrush        // Bit reduction with sample rate reduction
     };
 
+    /** How BitCrush holds each sample when the rate is reduced. */
+    enum class HoldMode
+    {
+        Crunchy,        // Steps land on the input samples, as the classic hardware does
+        BandLimited     // Sampled between inputs at the exact rate, steps polyBLEP-smoothed
+    };
+
     DistortionForge();
     ~DistortionForge();
 
@@ -46,6 +54,7 @@ public:
     void setBias (float biasAmount);        // DC offset for asymmetric distortion
     void setBitDepth (float bitDepth);      // For bit crushing (1-16 bits)
     void setSampleRateReduction (float reduction); // Sample rate reduction factor
+    void setHoldMode (HoldMode mode);       // Sample-and-hold character when the rate is reduced
 
 private:
     //==============================================================================
@@ -56,6 +65,7 @@ private:
     void processWavefold (const juce::dsp::ProcessContextReplacing<float>& context);
     void processBitCrush (const juce::dsp::ProcessContextReplacing<float>& context);
 
+    void applyDrive (const juce::dsp::AudioBlock<float>& block);
     void updateFilters();
     void updateGainStaging();
 
@@ -70,27 +80,44 @@ private:
     float wetMix = 1.0f;           // Dry/wet mix (0-1)
 
     // Advanced parameters
-    float biasAmount = 0.0f;        // DC bias for asymmetric distortion
+    float biasAmount = 0.0f;        // Offset of the operating point along the curve, after the drive
     float bitDepth = 16.0f;         // Bit depth for bit crushing
     float sampleRateReduction = 1.0f; // Sample rate reduction factor
+    HoldMode holdMode = HoldMode::Crunchy;
 
     //==============================================================================
     // DSP Components using JUCE and basic algorithms
-    // (chowdsp waveshapers not available in this version)
+
+    // Anti-aliased (first-order ADAA) shapers, one per channel
+    std::vector<Waveshapers::Processor<Waveshapers::Tanh, 1>> tanhShapers;
+    std::vector<Waveshapers::Processor<Waveshapers::HardClip, 1>> hardClipShapers;
+    std::vector<Waveshapers::Processor<Waveshapers::SoftClip, 1>> softClipShapers;
+    std::vector<Waveshapers::Processor<Waveshapers::SineFold, 1>> wavefoldShapers;
 
     // Tone filtering
     juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>,
                                    juce::dsp::IIR::Coefficients<float>> toneFilter;
 
     // Gain staging for professional audio quality
-    juce::dsp::Gain<float> inputGain;      // Pre-distortion gain
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> driveGain;  // Pre-distortion gain
     juce::dsp::Gain<float> outputGain;     // Post-distortion gain compensation
     juce::dsp::DryWetMixer<float> dryWetMixer;
 
-    // Bit crushing components
-    std::vector<float> bitCrushBuffer;      // For sample-and-hold processing
-    int bitCrushCounter = 0;
-    float bitCrushPhase = 0.0f;
+    // Bit crushing: a fractional-rate sample-and-hold per channel
+    struct Decimator
+    {
+        /** Holds samples at rate times the host rate, in place. Only the samples the
+            phase wraps on are worked on; the rest are filled with the held value.
+            Held values are quantised to steps levels per unit, unless steps is zero. */
+        void process (float* samples, int numSamples, float rate,
+                      float steps, float stepSize, bool bandLimited) noexcept;
+
+        float phase = 0.0f;         // Progress towards the next hold, in holds
+        float held = 0.0f;
+        float lastInput = 0.0f;     // Input before the block, to sample between
+    };
+
+    std::vector<Decimator> decimators;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DistortionForge)
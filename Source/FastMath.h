@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+//==============================================================================
+/**
+    FastMath - Branch-free approximations for per-bin and per-sample DSP
+
+    Every function here is inline, free of branches and library calls, so loops
+    over contiguous arrays compile to packed SSE/AVX/NEON code (the target is
+    built with -fno-math-errno -fno-trapping-math so GCC will do this too). The
+    frame kernels at the bottom are the intended entry points for spectral work.
+
+    Accuracy (float inputs, tested over the documented ranges):
+        atan2       < 1.2e-5 rad
+        sin / cos   < 4.0e-6 absolute, |x| < 1e5
+        exp         < 4.0e-6 relative, x in [-87, 88]
+        log         < 4.0e-6 absolute, x > 0
+        tanh        < 1.0e-6 absolute
+*/
+namespace FastMath
+{
+    constexpr float pi       = 3.14159265358979323846f;
+    constexpr float twoPi    = 6.28318530717958647692f;
+    constexpr float halfPi   = 1.57079632679489661923f;
+    constexpr float invTwoPi = 0.15915494309189533577f;
+    constexpr float ln2      = 0.69314718055994530942f;
+    constexpr float log2e    = 1.44269504088896340736f;
+
+    inline float bitsToFloat (std::uint32_t bits) noexcept { float f; std::memcpy (&f, &bits, sizeof (f)); return f; }
+    inline std::uint32_t floatToBits (float f) noexcept    { std::uint32_t u; std::memcpy (&u, &f, sizeof (u)); return u; }
+
+    /** Returns a if condition holds, otherwise b. Both sides are evaluated up front so
+        the compiler can lower this to a blend instead of a branch. */
+    inline float select (bool condition, float a, float b) noexcept
+    {
+        return condition ? a : b;
+    }
+
+    /** Rounds to the nearest integer value (ties away from zero) without a library call. */
+    inline float roundNearest (float x) noexcept
+    {
+        return (float) (std::int32_t) (x + std::copysign (0.5f, x));
+    }
+
+    /** Wraps a phase into [-pi, pi]. Uses a two-part 2*pi so large arguments stay accurate. */
+    inline float wrapPhase (float x) noexcept
+    {
+        constexpr float twoPiHi = 6.28125f;
+        constexpr float twoPiLo = 1.9353071795864769e-3f;
+        const float k = roundNearest (x * invTwoPi);
+        return (x - k * twoPiHi) - k * twoPiLo;
+    }
+
+    /** Degree-9 odd polynomial for sin on [-pi/2, pi/2]. */
+    inline float sinPoly (float x) noexcept
+    {
+        const float x2 = x * x;
+        return x * (1.0f + x2 * (-1.6666667e-1f + x2 * (8.3333333e-3f + x2 * (-1.9841270e-4f + x2 * 2.7557319e-6f))));
+    }
+
+    /** Computes sin and cos together from a single range reduction. */
+    inline void sincos (float x, float& s, float& c) noexcept
+    {
+        x = wrapPhase (x);
+
+        // Reflect into [-pi/2, pi/2] for sin; cos(x) = sin(pi/2 - |x|) is already in range
+        const float xs = select (std::abs (x) > halfPi, std::copysign (pi, x) - x, x);
+        s = sinPoly (xs);
+        c = sinPoly (halfPi - std::abs (x));
+    }
+
+    inline float sin (float x) noexcept
+    {
+        x = wrapPhase (x);
+        return sinPoly (select (std::abs (x) > halfPi, std::copysign (pi, x) - x, x));
+    }
+
+    inline float cos (float x) noexcept
+    {
+        return sinPoly (halfPi - std::abs (wrapPhase (x)));
+    }
+
+    /** Four-quadrant arctangent. Returns 0 for (0, 0). */
+    inline float atan2 (float y, float x) noexcept
+    {
+        const float ax = std::abs (x), ay = std::abs (y);
+        const float mx = std::max (ax, ay), mn = std::min (ax, ay);
+        const float a = mn / (mx + 1.0e-30f);
+        const float s = a * a;
+
+        float r = a * (0.9998660f + s * (-0.3302995f + s * (0.1801410f + s * (-0.0851330f + s * 0.0208351f))));
+        r = select (ay > ax, halfPi - r, r);
+        r = select (x < 0.0f, pi - r, r);
+        return std::copysign (r, y);
+    }
+
+    /** e^x via 2^n * 2^f with f in [-0.5, 0.5]. Inputs are clamped to avoid overflow. */
+    inline float exp (float x) noexcept
+    {
+        x = std::min (88.0f, std::max (-87.0f, x));
+        const float t = x * log2e;
+        const float n = roundNearest (t);
+        const float f = (t - n) * ln2;
+
+        const float p = 1.0f + f * (1.0f + f * (0.5f + f * (1.6666667e-1f + f * (4.1666667e-2f + f * (8.3333333e-3f + f * 1.3888889e-3f)))));
+        const auto scale = bitsToFloat ((std::uint32_t) ((std::int32_t) n + 127) << 23);
+        return p * scale;
+    }
+
+    /** Natural log for positive inputs (values below 1e-30 are treated as 1e-30). */
+    inline float log (float x) noexcept
+    {
+        x = std::max (x, 1.0e-30f);
+        const auto bits = floatToBits (x);
+
+        // Split into exponent and mantissa, keeping the mantissa in [sqrt(0.5), sqrt(2))
+        const auto adjusted = bits + (0x3f800000u - 0x3f3504f3u);
+        const float e = (float) ((std::int32_t) (adjusted >> 23) - 127);
+        const float m = bitsToFloat ((adjusted & 0x007fffffu) + 0x3f3504f3u);
+
+        // log(m) = 2 * atanh((m - 1) / (m + 1))
+        const float s = (m - 1.0f) / (m + 1.0f);
+        const float s2 = s * s;
+        const float logM = 2.0f * s * (1.0f + s2 * (3.3333333e-1f + s2 * (2.0e-1f + s2 * (1.4285714e-1f + s2 * 1.1111111e-1f))));
+
+        return e * ln2 + logM;
+    }
+
+    /** tanh from one exp; inputs beyond +-9 saturate to +-1. */
+    inline float tanh (float x) noexcept
+    {
+        const float e = exp (2.0f * std::min (9.0f, std::max (-9.0f, x)));
+        return (e - 1.0f) / (e + 1.0f);
+    }
+
+    //==============================================================================
+    // Frame kernels over split real/imaginary arrays
+
+    /** magnitude = |re + j im|, phase = arg(re + j im) */
+    inline void cartesianToPolar (const float* __restrict re, const float* __restrict im,
+                                  float* __restrict magnitude, float* __restrict phase, int numBins) noexcept
+    {
+        for (int i = 0; i < numBins; ++i)
+        {
+            magnitude[i] = std::sqrt (re[i] * re[i] + im[i] * im[i]);
+            phase[i] = atan2 (im[i], re[i]);
+        }
+    }
+
+    /** re + j im = magnitude * e^(j phase) */
+    inline void polarToCartesian (const float* __restrict magnitude, const float* __restrict phase,
+                                  float* __restrict re, float* __restrict im, int numBins) noexcept
+    {
+        for (int i = 0; i < numBins; ++i)
+        {
+            float s, c;
+            sincos (phase[i], s, c);
+            re[i] = magnitude[i] * c;
+            im[i] = magnitude[i] * s;
+        }
+    }
+}
@@ -1,4 +1,6 @@
 #include "FibonacciSpiralDistort.h"
+#include "BiquadCoefficientCache.h"
+#include "FastMath.h"
 #include <cmath>
 
 // Constructor
@@ -13,24 +15,13 @@ FibonacciSpiralDistort::FibonacciSpiralDistort()
     // Initialize distortion stages
     for (auto& stage : distortionStages) {
         stage.drive = 1.0f;
-        stage.envelope = 0.0f;
         stage.attackCoeff = 0.999f;
         stage.releaseCoeff = 0.999f;
     }
 
     // Initialize veil filters (helical LP with key-scaled cutoff)
-    for (auto& filter : veilFilters) {
-        filter.coefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(44100.0, 800.0f);
-        filter.filter.coefficients = filter.coefficients;
-    }
-
-    // Initialize resonator BP filters with self-oscillation
-    for (auto& resonator : resonators) {
-        resonator.bpCoefficients = juce::dsp::IIR::Coefficients<float>::makeBandPass(44100.0, 100.0f, 2.0f);
-        resonator.bpFilter.coefficients = resonator.bpCoefficients;
-        resonator.feedback = 0.9f;
-        resonator.prevOutput = 0.0f;
-    }
+    veilCoefficients.setNumStages(VEIL_FILTERS);
+    updateVeilFilterCutoffs();
 
     // Initialize A-weighting filter for psychoacoustic processing (20Hz-20kHz bandpass)
     aWeightCoefficients = juce::dsp::IIR::Coefficients<float>::makeBandPass(sampleRate, 1000.0f, 0.5f);
@@ -55,6 +46,9 @@ void FibonacciSpiralDistort::prepare(const juce::dsp::ProcessSpec& spec)
 {
     sampleRate = spec.sampleRate;
 
+    // One set of resonators, cascade envelopes and veil filters per channel
+    channelStates.resize(spec.numChannels);
+
     // Update all coefficients for new sample rate
     updateEnvelopeCoefficients();
     updateResonatorBank();
@@ -66,51 +60,73 @@ void FibonacciSpiralDistort::prepare(const juce::dsp::ProcessSpec& spec)
 
 void FibonacciSpiralDistort::process(const juce::dsp::ProcessContextReplacing<float>& context)
 {
-    auto inputBlock = context.getInputBlock();
     auto outputBlock = context.getOutputBlock();
-    auto numSamples = (int)inputBlock.getNumSamples();
-    auto numChannels = (int)inputBlock.getNumChannels();
+    auto numSamples = (int)outputBlock.getNumSamples();
+    auto numChannels = std::min(outputBlock.getNumChannels(), channelStates.size());
 
-    // Process each channel
-    for (int channel = 0; channel < numChannels; ++channel) {
-        auto* input = inputBlock.getChannelPointer(channel);
-        auto* output = outputBlock.getChannelPointer(channel);
+    if (numSamples == 0)
+        return;
 
-        // Create working buffer for processing
-        std::vector<float> workingBuffer(numSamples);
-        std::copy(input, input + numSamples, workingBuffer.data());
+    // Ramp the mix across the block instead of stepping it
+    const float mixStep = (wetMix - lastMix) / (float)numSamples;
+    const float morph = morphAmount;
 
-        // Apply FSD algorithm stages
-        processResonatorBank(input, workingBuffer.data(), numSamples);
-        processFibonacciDistortion(workingBuffer.data(), numSamples);
-        processSpiralVeilFilter(workingBuffer.data(), numSamples);
+    // Worked through in chunks small enough to keep the dry copy on the stack
+    constexpr int chunkSize = 64;
+    alignas(16) float dry[chunkSize];
+    alignas(16) float simple[chunkSize];
 
-        // Mix with dry signal
-        float wetMix = 0.8f; // TODO: Make this a parameter
-        for (int sample = 0; sample < numSamples; ++sample) {
-            output[sample] = input[sample] * (1.0f - wetMix) + workingBuffer[sample] * wetMix;
+    for (size_t channel = 0; channel < numChannels; ++channel) {
+        auto* samples = outputBlock.getChannelPointer(channel);
+        auto& state = channelStates[channel];
+
+        for (int start = 0; start < numSamples; start += chunkSize) {
+            const int n = std::min(chunkSize, numSamples - start);
+            float* chunk = samples + start;
+
+            std::copy(chunk, chunk + n, dry);
+
+            // Morph target at zero: one plain tanh stage at the base drive
+            for (int i = 0; i < n; ++i)
+                simple[i] = FastMath::tanh(fibDrive * dry[i]);
+
+            // Apply FSD algorithm stages
+            processResonatorBank(state, chunk, n);
+            processFibonacciDistortion(state, chunk, n);
+
+            for (int i = 0; i < n; ++i)
+                chunk[i] = simple[i] + morph * (chunk[i] - simple[i]);
+
+            BiquadCascade::process(veilCoefficients, state.veil, chunk, n);
+
+            // Mix with dry signal
+            const float chunkMix = lastMix + (float)start * mixStep;
+
+            for (int i = 0; i < n; ++i)
+                chunk[i] = dry[i] + (chunkMix + (float)i * mixStep) * (chunk[i] - dry[i]);
         }
     }
+
+    lastMix = wetMix;
 }
 
 void FibonacciSpiralDistort::reset()
 {
-    // Reset resonator phases
-    for (auto& resonator : resonators) {
-        resonator.phase = 0.0f;
-    }
-
-    // Reset envelope followers
-    envelopeFollower = 0.0f;
+    // Oscillators back to phase zero, filters and envelopes cleared
+    for (auto& state : channelStates)
+        state.reset();
 
-    for (auto& stage : distortionStages) {
-        stage.envelope = 0.0f;
-    }
+    lastMix = wetMix;
+}
 
-    // Reset filters
-    for (auto& filter : veilFilters) {
-        filter.filter.reset();
-    }
+void FibonacciSpiralDistort::ChannelState::reset() noexcept
+{
+    oscillatorCos.fill(ResonatorVector::expand(1.0f));
+    oscillatorSin.fill(ResonatorVector::expand(0.0f));
+    resonatorRe.fill(ResonatorVector::expand(0.0f));
+    resonatorIm.fill(ResonatorVector::expand(0.0f));
+    stageEnvelopes.fill(0.0f);
+    veil.reset();
 }
 
 // Parameter setters
@@ -128,10 +144,9 @@ void FibonacciSpiralDistort::setTone(float toneFreqHz)
     updateVeilFilterCutoffs();
 }
 
-void FibonacciSpiralDistort::setMix(float wetMix)
+void FibonacciSpiralDistort::setMix(float newWetMix)
 {
-    // Mix is handled in process() method
-    // Could store for more complex mixing logic
+    wetMix = juce::jlimit(0.0f, 1.0f, newWetMix);
 }
 
 void FibonacciSpiralDistort::setSpiralDepth(float depth)
@@ -176,6 +191,7 @@ void FibonacciSpiralDistort::setMidiNote(float midiNoteValue)
     // Update frequency based on MIDI note (A4 = 69 = 440Hz)
     currentFrequency = 440.0f * std::pow(2.0f, (midiNote - 69.0f) / 12.0f);
     updateResonatorBank();
+    updateVeilFilterCutoffs();
 }
 
 void FibonacciSpiralDistort::setMorphAmount(float morphValue)
@@ -194,8 +210,7 @@ void FibonacciSpiralDistort::updateFibonacciRatios()
 
 void FibonacciSpiralDistort::updateEnvelopeCoefficients()
 {
-    // Convert bloom rate to coefficient (time constant)
-    float tau = 1.0f / (bloomRate * sampleRate);
+    // Bloom rate is the release time constant, in seconds
     envAttackCoeff = std::exp(-1.0f / (0.01f * sampleRate));  // Fast attack
     envReleaseCoeff = std::exp(-1.0f / (bloomRate * sampleRate)); // Variable release
 
@@ -208,113 +223,103 @@ void FibonacciSpiralDistort::updateEnvelopeCoefficients()
 
 void FibonacciSpiralDistort::updateResonatorBank()
 {
+    // Padding lanes stay silent
+    for (auto* lanes : { &oscillatorRotationCos, &oscillatorRotationSin, &resonatorRotationCos, &resonatorRotationSin,
+                         &resonatorInputGain, &oscillatorAmplitudes, &resonatorGains })
+        lanes->fill(ResonatorVector::expand(0.0f));
+
     // Update resonator frequencies based on current frequency and golden ratio
     for (int n = 0; n < MAX_RESONATORS; ++n) {
-        resonators[n].frequency = currentFrequency * 3.0f * std::pow(phi, (float)n);
-        resonators[n].amplitude = spiralDepth * 0.2f;
-        resonators[n].feedback = resonance;
+        const double frequency = currentFrequency * 3.0 * std::pow((double)phi, (double)n);
+        const double w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+
+        // Bandwidth narrows from half the centre frequency to a tenth as resonance rises
+        const double bandwidth = frequency * (0.5 - 0.5 * resonance);
+        const double radius = std::exp(-juce::MathConstants<double>::pi * bandwidth / sampleRate);
+
+        // Lanes that would alias are silenced
+        const bool audible = frequency < 0.45 * sampleRate;
+
+        const int v = n / RESONATOR_LANES;
+        const size_t lane = (size_t)(n % RESONATOR_LANES);
+        oscillatorRotationCos[v].set(lane, (float)std::cos(w));
+        oscillatorRotationSin[v].set(lane, (float)std::sin(w));
+        resonatorRotationCos[v].set(lane, (float)(radius * std::cos(w)));
+        resonatorRotationSin[v].set(lane, (float)(radius * std::sin(w)));
+        resonatorInputGain[v].set(lane, (float)(1.0 - radius));
+        oscillatorAmplitudes[v].set(lane, audible ? spiralDepth * 0.2f : 0.0f);
+        resonatorGains[v].set(lane, audible ? resonance : 0.0f);
     }
 }
 
 void FibonacciSpiralDistort::updateVeilFilterCutoffs()
 {
-    for (int m = 0; m < VEIL_FILTERS; ++m) {
-        veilFilters[m].cutoff = veilCutoff * std::pow(phi, (float)m);
-        veilFilters[m].coefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(
-            sampleRate, veilFilters[m].cutoff);
-        veilFilters[m].filter.coefficients = veilFilters[m].coefficients;
-    }
+    // Cutoffs spaced by φ and scaled with the key, clamped below Nyquist by the cache
+    const BiquadCoefficientCache::Curve veilCurve(Biquad::Type::lowpass, Biquad::butterworthQ);
+    const float keyScale = std::sqrt(currentFrequency / 100.0f);
+
+    for (int m = 0; m < VEIL_FILTERS; ++m)
+        veilCoefficients.setStage(m, veilCurve.get(sampleRate, veilCutoff * std::pow(phi, (float)m) * keyScale));
 }
 
-void FibonacciSpiralDistort::processResonatorBank(const float* input, float* output, int numSamples)
+void FibonacciSpiralDistort::processResonatorBank(ChannelState& state, float* buffer, int numSamples) const noexcept
 {
-    // Generate resonator signals and mix with input
-    for (int sample = 0; sample < numSamples; ++sample) {
-        float resonatorSum = 0.0f;
-
-        for (int n = 0; n < MAX_RESONATORS; ++n) {
-            auto& res = resonators[n];
-
-            // Generate sine wave
-            float resonatorSignal = res.amplitude * std::sin(res.phase * juce::MathConstants<float>::twoPi);
-
-            // Add some feedback from previous output
-            if (sample > 0) {
-                resonatorSignal += res.feedback * output[sample - 1] * 0.1f;
-            }
+    auto oscCos = state.oscillatorCos, oscSin = state.oscillatorSin;
+    auto resRe = state.resonatorRe, resIm = state.resonatorIm;
+    const float bankGain = spiralDepth * 0.3f;
 
-            resonatorSum += resonatorSignal;
-
-            // Update phase
-            float phaseInc = res.frequency / sampleRate;
-            res.phase += phaseInc;
-            res.phase = std::fmod(res.phase, 1.0f);
+    for (int sample = 0; sample < numSamples; ++sample) {
+        const float x = buffer[sample];
+        auto sum = ResonatorVector::expand(0.0f);
+
+        for (int v = 0; v < RESONATOR_VECTORS; ++v) {
+            // Oscillator: rotate the phasor, then pull it back onto the unit circle
+            // (first-order correction, enough for the drift of one rotation)
+            const auto c = oscCos[v] * oscillatorRotationCos[v] - oscSin[v] * oscillatorRotationSin[v];
+            const auto s = oscCos[v] * oscillatorRotationSin[v] + oscSin[v] * oscillatorRotationCos[v];
+            const auto g = ResonatorVector::expand(1.5f) - (c * c + s * s) * 0.5f;
+            oscCos[v] = c * g;
+            oscSin[v] = s * g;
+
+            // Bandpass: the same rotation inside the pole radius, driven by the input
+            const auto re = resRe[v] * resonatorRotationCos[v] - resIm[v] * resonatorRotationSin[v] + resonatorInputGain[v] * x;
+            resIm[v] = resRe[v] * resonatorRotationSin[v] + resIm[v] * resonatorRotationCos[v];
+            resRe[v] = re;
+
+            sum = sum + oscillatorAmplitudes[v] * oscSin[v] + resonatorGains[v] * re;
         }
 
         // Mix resonator bank with input
-        output[sample] = input[sample] + spiralDepth * resonatorSum * 0.3f;
+        buffer[sample] = x + bankGain * sum.sum();
     }
-}
-
-void FibonacciSpiralDistort::processFibonacciDistortion(float* buffer, int numSamples)
-{
-    for (int sample = 0; sample < numSamples; ++sample) {
-        float inputSample = buffer[sample];
-
-        // Update envelope follower
-        float envInput = std::abs(inputSample);
-        envelopeFollower = envInput + envAttackCoeff * (envelopeFollower - envInput);
-
-        // Process through Fibonacci distortion cascade
-        float processedSample = inputSample;
-
-        for (int k = 0; k < DISTORTION_STAGES; ++k) {
-            auto& stage = distortionStages[k];
 
-            // Update stage envelope
-            float stageEnvInput = std::abs(processedSample);
-            stage.envelope = stageEnvInput + stage.attackCoeff * (stage.envelope - stageEnvInput);
-
-            // Apply Fibonacci-ratio drive
-            float drive = fibDrive * fibRatios[k % 16];
-            float distorted = std::tanh(drive * stage.envelope * processedSample);
-
-            processedSample = distorted;
-        }
-
-        buffer[sample] = processedSample;
-    }
+    state.oscillatorCos = oscCos;
+    state.oscillatorSin = oscSin;
+    state.resonatorRe = resRe;
+    state.resonatorIm = resIm;
 }
 
-void FibonacciSpiralDistort::processSpiralVeilFilter(float* buffer, int numSamples)
+void FibonacciSpiralDistort::processFibonacciDistortion(ChannelState& state, float* buffer, int numSamples) const noexcept
 {
-    // Apply cascaded veil filters with key-scaled cutoff
-    for (auto& filter : veilFilters) {
-        // Update cutoff based on current frequency for key-scaled veil
-        float keyScaledCutoff = filter.cutoff * std::pow(currentFrequency / 100.0f, 0.5f);
-        filter.coefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, keyScaledCutoff);
-        filter.filter.coefficients = filter.coefficients;
-
-        juce::dsp::AudioBlock<float> block(buffer, 1, 0, numSamples);
-        juce::dsp::ProcessContextReplacing<float> context(block);
-        filter.filter.process(context);
-    }
-}
+    // Stage by stage over the whole buffer: only the envelope is recursive, so
+    // the tanh of each stage runs as its own vectorised loop
+    for (int k = 0; k < DISTORTION_STAGES; ++k) {
+        const float drive = fibDrive * fibRatios[k % 16];
+        const float attack = distortionStages[k].attackCoeff;
+        float envelope = state.stageEnvelopes[k];
+
+        // Update stage envelope, folding it into the Fibonacci-ratio drive
+        for (int sample = 0; sample < numSamples; ++sample) {
+            const float stageEnvInput = std::abs(buffer[sample]);
+            envelope = stageEnvInput + attack * (envelope - stageEnvInput);
+            buffer[sample] *= drive * envelope;
+        }
 
-float FibonacciSpiralDistort::processEnvelopeFollower(float input)
-{
-    float absInput = std::abs(input);
+        for (int sample = 0; sample < numSamples; ++sample)
+            buffer[sample] = FastMath::tanh(buffer[sample]);
 
-    // Attack phase
-    if (absInput > envelopeFollower) {
-        envelopeFollower = absInput + envAttackCoeff * (envelopeFollower - absInput);
-    }
-    // Release phase
-    else {
-        envelopeFollower = absInput + envReleaseCoeff * (envelopeFollower - absInput);
+        state.stageEnvelopes[k] = envelope;
     }
-
-    return envelopeFollower;
 }
 
 float FibonacciSpiralDistort::fibonacciRatio(int n) const
@@ -325,7 +330,7 @@ float FibonacciSpiralDistort::fibonacciRatio(int n) const
     };
 
     if (n < 1) return 1.0f;
-    if (n >= fibSequence.size()) return phi; // Converge to golden ratio
+    if (n >= static_cast<int>(fibSequence.size())) return phi; // Converge to golden ratio
 
     return static_cast<float>(fibSequence[n]) / static_cast<float>(fibSequence[n - 1]);
 }
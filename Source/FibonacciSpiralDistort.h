@@ -1,8 +1,8 @@
 #pragma once
 
 #include "Module.h"
-#include "../JUCE/modules/juce_dsp/juce_dsp.h"
-#include "../JUCE/modules/juce_audio_processors/juce_audio_processors.h"
+#include "BiquadCascade.h"
+#include <juce_audio_processors/juce_audio_processors.h>
 
 /**
  * Fibonacci Spiral Distort (FSD) - A novel hybrid filter-distortion algorithm
@@ -10,6 +10,12 @@
  * This module creates self-similar, consonant harmonics using golden ratio (φ ≈ 1.618)
  * spacing and Fibonacci approximations for "pleasing" richness without dissonance.
  * Perfect for transforming sterile sines into evolving, resonant monsters for dubstep bass.
+ *
+ * The four φ-spaced resonators are the lanes of a juce::dsp::SIMDRegister (one
+ * register on SSE and NEON, padded with silent lanes on wider ones): each is a
+ * recursive quadrature oscillator (a rotation renormalised every sample, no sin or
+ * fmod) sharing its rotation with a complex one-pole bandpass that rings on the
+ * input. Every channel keeps its own resonator, cascade and veil state.
  */
 class FibonacciSpiralDistort : public DistortionModule
 {
@@ -41,7 +47,7 @@ public:
     void setResonance(float resonance);    // 0.0-0.8: φ-resonator feedback
     void setFibDepth(int fibN);           // 5-15: Fibonacci ratio depth
     void setMidiNote(float midiNote);     // 0-127: Key-dependent frequency scaling
-    void setMorphAmount(float morph);     // 0.0-1.0: Simple WT to full spiral morphing
+    void setMorphAmount(float morph);     // 0.0-1.0: Plain tanh drive to full spiral
 
     // Parameter accessors
     float getSpiralDepth() const { return spiralDepth; }
@@ -50,33 +56,21 @@ public:
     float getVeilCutoff() const { return veilCutoff; }
     float getResonance() const { return resonance; }
     int getFibDepth() const { return fibN; }
+    float getMix() const { return wetMix; }
+    float getMorphAmount() const { return morphAmount; }
 
 private:
-    // Core algorithm components
-    void updateResonatorBank();
-    void processResonatorBank(const float* input, float* output, int numSamples);
-    void processFibonacciDistortion(float* buffer, int numSamples);
-    void processSpiralVeilFilter(float* buffer, int numSamples);
-
-    // Resonator bank (φ-spaced BP filters with self-oscillation)
+    // Resonator bank (φ-spaced oscillators and bandpasses, one SIMD lane each)
     static constexpr int MAX_RESONATORS = 4;
-    struct Resonator {
-        float phase = 0.0f;
-        float frequency = 100.0f;
-        float amplitude = 0.25f;
-        float feedback = 0.9f;
-        float prevOutput = 0.0f;
-        juce::dsp::IIR::Filter<float> bpFilter;
-        juce::dsp::IIR::Coefficients<float>::Ptr bpCoefficients;
-    };
-    std::array<Resonator, MAX_RESONATORS> resonators;
-    float currentFrequency = 55.0f; // Track input frequency
+    using ResonatorVector = juce::dsp::SIMDRegister<float>;
+    static constexpr int RESONATOR_LANES = (int)ResonatorVector::SIMDNumElements;
+    static constexpr int RESONATOR_VECTORS = (MAX_RESONATORS + RESONATOR_LANES - 1) / RESONATOR_LANES;
+    using ResonatorLanes = std::array<ResonatorVector, RESONATOR_VECTORS>;
 
     // Fibonacci distortion cascade (4-stage waveshaper)
     static constexpr int DISTORTION_STAGES = 4;
     struct DistortionStage {
         float drive = 1.0f;
-        float envelope = 0.0f;
         float attackCoeff = 0.999f;
         float releaseCoeff = 0.999f;
     };
@@ -84,12 +78,31 @@ private:
 
     // Spiral veil filter (cascaded LPs with φ-cutoff spacing)
     static constexpr int VEIL_FILTERS = 3;
-    struct VeilFilter {
-        juce::dsp::IIR::Filter<float> filter;
-        float cutoff = 500.0f;
-        juce::dsp::IIR::Coefficients<float>::Ptr coefficients;
+    BiquadCascade::Coefficients veilCoefficients;
+
+    // Everything that runs on the signal, once per channel
+    struct ChannelState {
+        ResonatorLanes oscillatorCos {}, oscillatorSin {};   // Unit phasor of each oscillator
+        ResonatorLanes resonatorRe {}, resonatorIm {};       // Bandpass state
+        std::array<float, DISTORTION_STAGES> stageEnvelopes {};
+        BiquadCascade::State veil;
+
+        void reset() noexcept;
     };
-    std::array<VeilFilter, VEIL_FILTERS> veilFilters;
+    std::vector<ChannelState> channelStates;
+
+    // Core algorithm components
+    void updateResonatorBank();
+    void processResonatorBank(ChannelState& state, float* buffer, int numSamples) const noexcept;
+    void processFibonacciDistortion(ChannelState& state, float* buffer, int numSamples) const noexcept;
+
+    // Resonator coefficients, shared by every channel
+    ResonatorLanes oscillatorRotationCos {}, oscillatorRotationSin {};
+    ResonatorLanes resonatorRotationCos {}, resonatorRotationSin {};    // Scaled by the pole radius
+    ResonatorLanes resonatorInputGain {};       // 1 - radius: unity gain at the centre
+    ResonatorLanes oscillatorAmplitudes {};     // Zero for padding lanes and lanes at or above 0.45 of the sample rate
+    ResonatorLanes resonatorGains {};
+    float currentFrequency = 55.0f; // Track input frequency
 
     // Parameters
     float spiralDepth = 0.3f;      // φ-resonator bank mix amount
@@ -99,14 +112,15 @@ private:
     float resonance = 0.4f;        // φ-resonator feedback amount
     int fibN = 8;                  // Fibonacci ratio depth (5-15)
     float midiNote = 69.0f;        // 0-127: Key-dependent frequency scaling (A4 = 69)
-    float morphAmount = 0.5f;      // 0.0-1.0: Simple WT to full spiral morphing
+    float morphAmount = 1.0f;      // 0.0-1.0: Plain tanh drive to full spiral
+    float wetMix = 0.8f;           // Dry/wet mix
+    float lastMix = 0.8f;          // Mix at the end of the last block, ramped from
 
     // DSP state
     double sampleRate = 44100.0;
     float phi = (1.0f + std::sqrt(5.0f)) / 2.0f; // Golden ratio ≈ 1.618034
 
     // Envelope follower for dynamic processing
-    float envelopeFollower = 0.0f;
     float envAttackCoeff = 0.999f;
     float envReleaseCoeff = 0.999f;
 
@@ -123,9 +137,6 @@ private:
     std::vector<float> aWeightBuffer;
     int blockPosition = 0;
 
-    // Self-oscillation feedback states for resonators
-    std::array<float, MAX_RESONATORS> prevResonatorOutput = {0.0f};
-
     // Psychoacoustic Fib envelope follower
     float fibEnvelope = 0.0f;
     float fibAlpha = 0.619f; // 13/21 Fibonacci ratio for smooth decay
@@ -133,8 +144,6 @@ private:
     // Utility functions
     void updateFibonacciRatios();
     void updateEnvelopeCoefficients();
-    void updateResonatorFrequencies();
     void updateVeilFilterCutoffs();
-    float processEnvelopeFollower(float input);
     float fibonacciRatio(int n) const;
 };
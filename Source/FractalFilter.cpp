@@ -29,9 +29,6 @@ static constexpr std::array<float, 8> MUSICAL_INTERVALS = {
 
 FractalFilterModule::FractalFilterModule()
 {
-    filterChain.resize (maxDepth);
-    coefficients.resize (maxDepth);
-
     // Initialize fractal patterns
     fractalPatterns[0] = FractalPattern::GoldenRatio;
     fractalPatterns[1] = FractalPattern::Fibonacci;
@@ -43,9 +40,7 @@ FractalFilterModule::FractalFilterModule()
 void FractalFilterModule::prepare (const juce::dsp::ProcessSpec& spec)
 {
     sampleRate = spec.sampleRate;
-
-    for (auto& filter : filterChain)
-        filter.prepare(spec);
+    channelStates.assign (spec.numChannels, {});
 
     // Initialize fractal pattern frequencies
     updateFractalPattern();
@@ -55,8 +50,8 @@ void FractalFilterModule::prepare (const juce::dsp::ProcessSpec& spec)
 
 void FractalFilterModule::reset()
 {
-    for (auto& filter : filterChain)
-        filter.reset();
+    for (auto& state : channelStates)
+        state.reset();
 }
 
 void FractalFilterModule::process (const juce::dsp::ProcessContextReplacing<float>& context)
@@ -64,14 +59,14 @@ void FractalFilterModule::process (const juce::dsp::ProcessContextReplacing<floa
     if (needsUpdate)
         updateCoefficients();
 
-    auto& inputBlock = context.getInputBlock();
     auto& outputBlock = context.getOutputBlock();
 
-    // Apply fractal filter chain with optional feedback
-    for (int i = 0; i < depth; ++i)
-    {
-        filterChain[i].process(context);
-    }
+    // Apply fractal filter chain, every stage in a single pass over each channel
+    const auto numChannels = juce::jmin (outputBlock.getNumChannels(), channelStates.size());
+    const int numSamples = (int) outputBlock.getNumSamples();
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+        BiquadCascade::process (coefficients, channelStates[ch], outputBlock.getChannelPointer (ch), numSamples);
 
     // Add subtle feedback for fractal resonance
     if (fractalFeedback > 0.01f)
@@ -151,32 +146,26 @@ void FractalFilterModule::setHarmonicDrive (float drive)
 
 void FractalFilterModule::updateCoefficients()
 {
-    for (int i = 0; i < depth; ++i)
+    // Stage frequencies follow the current base frequency
+    updateFractalPattern();
+
+    Biquad::Type type = Biquad::Type::lowpass;
+    switch (filterType)
     {
-        float freq = fractalFrequencies[i];
-
-        switch (filterType)
-        {
-            case 0: // Low-pass
-                *coefficients[i] = *Coefficients::makeLowPass (sampleRate, freq, q);
-                break;
-            case 1: // High-pass
-                *coefficients[i] = *Coefficients::makeHighPass (sampleRate, freq, q);
-                break;
-            case 2: // Band-pass
-                *coefficients[i] = *Coefficients::makeBandPass (sampleRate, freq, q);
-                break;
-            case 3: // Notch
-                *coefficients[i] = *Coefficients::makeNotch (sampleRate, freq, q);
-                break;
-            case 4: // Allpass
-                *coefficients[i] = *Coefficients::makeAllPass (sampleRate, freq, q);
-                break;
-        }
-
-        filterChain[i].coefficients = *coefficients[i];
+        case 1: type = Biquad::Type::highpass; break;
+        case 2: type = Biquad::Type::bandpass; break;
+        case 3: type = Biquad::Type::notch; break;
+        case 4: type = Biquad::Type::allpass; break;
+        default: break;
     }
 
+    // Read from the shared coefficient cache, no Coefficients objects are allocated
+    const BiquadCoefficientCache::Curve curve (type, q);
+
+    coefficients.setNumStages (depth);
+    for (int i = 0; i < depth; ++i)
+        coefficients.setStage (i, curve.get (sampleRate, fractalFrequencies[i]));
+
     needsUpdate = false;
 }
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Module.h"
+#include "BiquadCascade.h"
+#include "BiquadCoefficientCache.h"
 #include <vector>
 #include <array>
 
@@ -50,11 +52,10 @@ private:
     double sampleRate = 44100.0;
     bool needsUpdate = true;
 
-    // DSP components
-    static constexpr int maxDepth = 8;
-    std::vector<juce::dsp::IIR::Filter<float>> filterChain;
-    using Coefficients = juce::dsp::IIR::Coefficients<float>;
-    std::vector<std::shared_ptr<Coefficients>> coefficients;
+    // DSP components: one pipelined pass per channel runs every stage
+    static constexpr int maxDepth = BiquadCascade::maxStages;
+    BiquadCascade::Coefficients coefficients;
+    std::vector<BiquadCascade::State> channelStates;
 
     // Enhanced parameters
     int filterType = 0;
@@ -22,11 +22,14 @@ void KeyTracker::reset()
     lastNoteNumber = -1;
     sustainPedalPressed = false;
     activeNotes.clear();
+    numBlockNoteOns = 0;
 }
 
 //==============================================================================
 void KeyTracker::processMidi (const juce::MidiBuffer& midiMessages, int numSamples)
 {
+    numBlockNoteOns = 0;
+
     // Process MIDI messages to track note on/off events
     for (const auto& metadata : midiMessages)
     {
@@ -39,6 +42,10 @@ void KeyTracker::processMidi (const juce::MidiBuffer& midiMessages, int numSampl
             // Add to active notes for polyphonic tracking
             activeNotes.insert(noteNumber);
             lastNoteNumber = noteNumber;
+            ++noteOnCount;
+
+            if (numBlockNoteOns < maxNoteOnsPerBlock)
+                blockNoteOns[(size_t) numBlockNoteOns++] = { noteNumber, message.getFloatVelocity(), metadata.samplePosition };
 
             // Update frequency based on current tracking mode
             updateFrequencyFromActiveNotes();
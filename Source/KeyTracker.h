@@ -2,6 +2,7 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include <array>
 #include <set>
 
 //==============================================================================
@@ -23,6 +24,21 @@ public:
     float getKeyTrackAmount() const { return keyTrackAmount; }
     void setKeyTrackAmount (float amount) { keyTrackAmount = amount; }
 
+    // Running count of note-ons; compare between blocks to detect new attacks
+    int getNoteOnCount() const { return noteOnCount; }
+
+    // Note-ons of the block last passed to processMidi, in order, for voices that play every note
+    struct NoteOn
+    {
+        int noteNumber;
+        float velocity;
+        int samplePosition;
+    };
+
+    static constexpr int maxNoteOnsPerBlock = 32;
+    int getNumBlockNoteOns() const { return numBlockNoteOns; }
+    const NoteOn& getBlockNoteOn (int index) const { return blockNoteOns[(size_t) index]; }
+
     //==============================================================================
     // Key tracking modes for different use cases
     enum class KeyTrackMode
@@ -50,6 +66,9 @@ private:
     // MIDI state tracking for polyphony
     std::set<int> activeNotes;  // Track all currently active notes
     int lastNoteNumber = -1;
+    int noteOnCount = 0;
+    std::array<NoteOn, maxNoteOnsPerBlock> blockNoteOns {};
+    int numBlockNoteOns = 0;
     bool sustainPedalPressed = false;
 
     //==============================================================================
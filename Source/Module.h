@@ -2,6 +2,7 @@
 
 #include <juce_dsp/juce_dsp.h>
 #include "KeyTracker.h"
+#include "STFTAnalysisService.h"
 
 // Defines the signal routing configuration for the module chain
 enum class Routing
@@ -19,7 +20,11 @@ enum class Routing
 class AudioModule
 {
 public:
-    virtual ~AudioModule() = default;
+    virtual ~AudioModule()
+    {
+        if (isAnalysisUser)
+            analysisPoint->removeUser();
+    }
 
     // Enum to identify module types
     enum class ModuleType { Filter, Distortion };
@@ -35,8 +40,49 @@ public:
     // Optional: for modules that need key tracking info
     virtual void setKeyTracker (KeyTracker* tracker) { keyTracker = tracker; }
 
+    // Optional: processing delay introduced by the module (e.g. FFT-based modules)
+    virtual int getLatencySamples() const { return 0; }
+
+    // Called by modules whose getLatencySamples() can change, on whichever thread changed
+    // it; set by the processor, which reports the new total to the host asynchronously
+    std::function<void()> onLatencyChanged;
+
+    // Optional: for modules that read the processor's shared STFT of their input. The
+    // module is registered as a user of its point only while this returns true
+    virtual bool usesSharedAnalysis() const { return false; }
+
+    void setAnalysisPoint (STFTAnalysisService::Point* point)
+    {
+        if (isAnalysisUser)
+            analysisPoint->removeUser();
+
+        isAnalysisUser = false;
+        analysisPoint = point;
+        updateAnalysisUser();
+    }
+
 protected:
+    // Call when usesSharedAnalysis() changes (message thread, like setAnalysisPoint())
+    void updateAnalysisUser()
+    {
+        const bool shouldUse = analysisPoint != nullptr && usesSharedAnalysis();
+
+        if (shouldUse == isAnalysisUser)
+            return;
+
+        if (shouldUse)
+            analysisPoint->addUser();
+        else
+            analysisPoint->removeUser();
+
+        isAnalysisUser = shouldUse;
+    }
+
     KeyTracker* keyTracker = nullptr;
+    STFTAnalysisService::Point* analysisPoint = nullptr;
+
+private:
+    bool isAnalysisUser = false;
 };
 
 //==============================================================================
@@ -0,0 +1,39 @@
+#include "OffscreenRenderer.h"
+
+//==============================================================================
+juce::Image OffscreenRenderer::render (juce::Component& component, float scale)
+{
+    juce::Image image;
+    renderInto (component, image, scale);
+    return image;
+}
+
+void OffscreenRenderer::renderInto (juce::Component& component, juce::Image& target, float scale)
+{
+    const int width = juce::jmax (1, juce::roundToInt ((float) component.getWidth() * scale));
+    const int height = juce::jmax (1, juce::roundToInt ((float) component.getHeight() * scale));
+
+    if (! target.isValid() || target.getWidth() != width || target.getHeight() != height)
+        target = juce::Image (juce::Image::ARGB, width, height, true, juce::SoftwareImageType());
+    else
+        target.clear (target.getBounds());
+
+    juce::Graphics g (target);
+    g.addTransform (juce::AffineTransform::scale (scale));
+    component.paintEntireComponent (g, true);
+}
+
+bool OffscreenRenderer::writePNG (const juce::Image& image, const juce::File& file)
+{
+    if (! image.isValid())
+        return false;
+
+    file.deleteFile();
+    juce::FileOutputStream stream (file);
+
+    if (! stream.openedOk())
+        return false;
+
+    juce::PNGImageFormat png;
+    return png.writeImageToStream (image, stream);
+}
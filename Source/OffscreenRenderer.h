@@ -0,0 +1,32 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+//==============================================================================
+/**
+    OffscreenRenderer - Paints components into software images without a display
+
+    Components never need a peer (window) to be painted: paintEntireComponent()
+    draws the component and its children into any Graphics context. Rendering
+    into a SoftwareImageType image keeps everything in process memory, so the
+    editor and its visualisers can be drawn, timed and saved on machines with no
+    windowing system, such as headless Linux build agents.
+*/
+class OffscreenRenderer
+{
+public:
+    /** Renders the component at its current size, scaled by scale (e.g. 2.0 for a HiDPI frame). */
+    static juce::Image render (juce::Component& component, float scale = 1.0f);
+
+    /**
+        Renders into target, reallocating it only if the size has changed. Use this
+        in loops so a benchmark measures painting rather than image allocation.
+    */
+    static void renderInto (juce::Component& component, juce::Image& target, float scale = 1.0f);
+
+    /** Writes an image as a PNG, replacing any existing file. */
+    static bool writePNG (const juce::Image& image, const juce::File& file);
+
+private:
+    OffscreenRenderer() = delete;
+};
@@ -15,14 +15,48 @@ WubForgeAudioProcessorEditor::WubForgeAudioProcessorEditor (WubForgeAudioProcess
     addAndMakeVisible (infoLabel);
     infoLabel.setText ("Spectral Audio Effect\nAlpha Test Build", juce::dontSendNotification);
     infoLabel.setJustificationType (juce::Justification::centred);
+
+    // XY pad: the editor paints it and listens to its mouse events
+    addAndMakeVisible (xyPadGroup);
+    addAndMakeVisible (xyPad);
+    xyPad.addMouseListener (this, false);
+
+    updateXYPadFromParameters();
+
+    // Spectrogram of the plugin output; the tap only runs while the editor is open
+    addAndMakeVisible (spectrogramGroup);
+    addAndMakeVisible (spectrogramComponent);
+    spectrumFrame.resize ((size_t) SpectrumAnalyzerTap::maxFrameBins);
+    spectrumFrequencies.resize ((size_t) SpectrumAnalyzerTap::maxFrameBins);
+
+    addAndMakeVisible (bassZoomButton);
+    bassZoomButton.setToggleState (true, juce::dontSendNotification);
+    bassZoomButton.onClick = [this]
+    {
+        audioProcessor.setSpectrumResolution (WubForgeAudioProcessor::outputSpectrumTap,
+                                              bassZoomButton.getToggleState() ? SpectrumAnalyzerTap::Resolution::bass
+                                                                              : SpectrumAnalyzerTap::Resolution::linear);
+    };
+    bassZoomButton.onClick();
+
+    audioProcessor.setSpectrumTapActive (WubForgeAudioProcessor::outputSpectrumTap, true);
+    startTimerHz (60);
 }
 
-WubForgeAudioProcessorEditor::~WubForgeAudioProcessorEditor() = default;
+WubForgeAudioProcessorEditor::~WubForgeAudioProcessorEditor()
+{
+    stopTimer();
+    mouseUpXY();
+    audioProcessor.setSpectrumTapActive (WubForgeAudioProcessor::outputSpectrumTap, false);
+    xyPad.removeMouseListener (this);
+}
 
 //==============================================================================
 void WubForgeAudioProcessorEditor::paint (juce::Graphics& g)
 {
     g.fillAll (juce::Colour (45, 48, 51));
+
+    drawXYPad (g, xyPad.getBounds().toFloat());
 }
 
 void WubForgeAudioProcessorEditor::resized()
@@ -30,5 +64,122 @@ void WubForgeAudioProcessorEditor::resized()
     auto bounds = getLocalBounds();
 
     titleLabel.setBounds (bounds.removeFromTop (100).reduced (20));
-    infoLabel.setBounds (bounds.reduced (20));
+
+    auto padArea = bounds.removeFromRight (bounds.getHeight()).reduced (20);
+    xyPadGroup.setBounds (padArea);
+    xyPad.setBounds (padArea.reduced (15).withTrimmedTop (10));
+
+    infoLabel.setBounds (bounds.removeFromBottom (60).reduced (20, 10));
+
+    auto spectrogramArea = bounds.reduced (20, 0);
+    spectrogramGroup.setBounds (spectrogramArea);
+    bassZoomButton.setBounds (spectrogramArea.getRight() - 110, spectrogramArea.getY(), 100, 20);
+    spectrogramComponent.setBounds (spectrogramArea.reduced (15).withTrimmedTop (10));
+}
+
+void WubForgeAudioProcessorEditor::timerCallback()
+{
+    const int tap = WubForgeAudioProcessor::outputSpectrumTap;
+
+    const int numBins = audioProcessor.getSpectrumFrame (tap, spectrumFrame.data(), spectrumFrequencies.data(),
+                                                         (int) spectrumFrame.size());
+    if (numBins > 0)
+        spectrogramComponent.pushSpectrumData (spectrumFrame.data(), spectrumFrequencies.data(), numBins);
+
+    updateXYPadFromParameters();
+}
+
+//==============================================================================
+void WubForgeAudioProcessorEditor::mouseDown (const juce::MouseEvent& event)
+{
+    if (event.eventComponent == &xyPad)
+        mouseDownXY (event.getEventRelativeTo (&xyPad));
+}
+
+void WubForgeAudioProcessorEditor::mouseDrag (const juce::MouseEvent& event)
+{
+    if (event.eventComponent == &xyPad)
+        mouseDragXY (event.getEventRelativeTo (&xyPad));
+}
+
+void WubForgeAudioProcessorEditor::mouseUp (const juce::MouseEvent& event)
+{
+    if (event.eventComponent == &xyPad)
+        mouseUpXY();
+}
+
+void WubForgeAudioProcessorEditor::mouseDownXY (const juce::MouseEvent& event)
+{
+    if (! xyPadDragging)
+    {
+        xyPadDragging = true;
+        audioProcessor.beginMorphGesture();
+    }
+
+    mouseDragXY (event);
+}
+
+void WubForgeAudioProcessorEditor::mouseDragXY (const juce::MouseEvent& event)
+{
+    const auto width = (float) juce::jmax (1, xyPad.getWidth());
+    const auto height = (float) juce::jmax (1, xyPad.getHeight());
+
+    // Y grows upwards so the top snapshots sit at the top of the pad
+    xyPadValueX = juce::jlimit (0.0f, 1.0f, (float) event.x / width);
+    xyPadValueY = juce::jlimit (0.0f, 1.0f, 1.0f - (float) event.y / height);
+
+    audioProcessor.setMorphPosition (xyPadValueX, xyPadValueY);
+    repaint (xyPad.getBounds());
+}
+
+void WubForgeAudioProcessorEditor::mouseUpXY()
+{
+    if (xyPadDragging)
+    {
+        xyPadDragging = false;
+        audioProcessor.endMorphGesture();
+    }
+}
+
+void WubForgeAudioProcessorEditor::updateXYPadFromParameters()
+{
+    if (xyPadDragging)
+        return;
+
+    const auto morphPosition = audioProcessor.getMorphPosition();
+
+    if (morphPosition.x != xyPadValueX || morphPosition.y != xyPadValueY)
+    {
+        xyPadValueX = morphPosition.x;
+        xyPadValueY = morphPosition.y;
+        repaint (xyPad.getBounds());
+    }
+}
+
+void WubForgeAudioProcessorEditor::drawXYPad (juce::Graphics& g, juce::Rectangle<float> area)
+{
+    if (area.isEmpty())
+        return;
+
+    g.setColour (juce::Colour (30, 32, 35));
+    g.fillRoundedRectangle (area, 4.0f);
+
+    g.setColour (juce::Colours::white.withAlpha (0.1f));
+    g.drawHorizontalLine ((int) area.getCentreY(), area.getX(), area.getRight());
+    g.drawVerticalLine ((int) area.getCentreX(), area.getY(), area.getBottom());
+
+    // Snapshot slots sit in the corners: 0 bottom-left, 1 bottom-right, 2 top-left, 3 top-right
+    g.setColour (juce::Colours::white.withAlpha (0.4f));
+    g.setFont (12.0f);
+    const auto labels = area.reduced (6.0f);
+    g.drawText ("A", labels, juce::Justification::bottomLeft);
+    g.drawText ("B", labels, juce::Justification::bottomRight);
+    g.drawText ("C", labels, juce::Justification::topLeft);
+    g.drawText ("D", labels, juce::Justification::topRight);
+
+    const juce::Point<float> puck (area.getX() + xyPadValueX * area.getWidth(),
+                                   area.getBottom() - xyPadValueY * area.getHeight());
+
+    g.setColour (juce::Colour (0, 200, 255));
+    g.fillEllipse (juce::Rectangle<float> (12.0f, 12.0f).withCentre (puck));
 }
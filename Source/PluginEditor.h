@@ -18,7 +18,8 @@
     - Preset management system
     - Real-time spectrogram display
 */
-class WubForgeAudioProcessorEditor : public juce::AudioProcessorEditor
+class WubForgeAudioProcessorEditor : public juce::AudioProcessorEditor,
+                                     private juce::Timer
 {
 public:
     WubForgeAudioProcessorEditor (WubForgeAudioProcessor&);
@@ -28,10 +29,19 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
+    void mouseDown (const juce::MouseEvent& event) override;
+    void mouseDrag (const juce::MouseEvent& event) override;
+    void mouseUp (const juce::MouseEvent& event) override;
+
 private:
     //==============================================================================
     WubForgeAudioProcessor& audioProcessor;
 
+    // Pulls analyzer frames published by the processor into the spectrogram, and keeps
+    // the XY puck on the morph parameters
+    void timerCallback() override;
+    std::vector<float> spectrumFrame, spectrumFrequencies;
+
     // Main layout components
     juce::StretchableLayoutManager layoutManager;
 
@@ -51,6 +61,7 @@ private:
     juce::Component centerPanel;
     juce::GroupComponent spectrogramGroup { {}, "Real-time Spectral Analysis" };
     SpectrogramComponent spectrogramComponent;
+    juce::ToggleButton bassZoomButton { "Bass Zoom" }; // Multirate analyser for detail below 100 Hz
     juce::GroupComponent xyPadGroup { {}, "Spectral Morphing Control" };
     juce::Component xyPad;
 
@@ -70,12 +81,15 @@ private:
     void updateModuleVisualization();
     void handleMagicForge();
 
-    // XY Pad control
+    // XY Pad control; the puck follows automation and preset loads unless it is being dragged
     float xyPadValueX = 0.5f;
     float xyPadValueY = 0.5f;
+    bool xyPadDragging = false;
     void drawXYPad (juce::Graphics& g, juce::Rectangle<float> area);
     void mouseDownXY (const juce::MouseEvent& event);
     void mouseDragXY (const juce::MouseEvent& event);
+    void mouseUpXY();
+    void updateXYPadFromParameters();
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WubForgeAudioProcessorEditor)
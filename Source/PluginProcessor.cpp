@@ -3,11 +3,14 @@
 #include "UniversalDistortionModule.h"
 #include "UniversalFilterModule.h"
 #include "DistortionForge.h"
+#include "BitCrusher.h"
 #include "MDASubSynthModuleDirect.h"
 #include "SampleMorpher.h"
 #include "FibonacciSpiralDistort.h"
 #include "HarmonicRichFilter.h"
 #include "WavetableFilterModule.h"
+#include "SpectralMorphingModule.h"
+#include "BandpassFractalFilter.h"
 #include <juce_dsp/juce_dsp.h>
 
 // Note: ChowEQModule requires ChowDSP library which may need separate installation
@@ -18,12 +21,16 @@ juce::StringArray WubForgeAudioProcessor::getAvailableModules()
     return {
         "Universal Filter",
         "Universal Distortion",
+        "Distortion Forge",
+        "Bit Crusher",
         "Chow EQ",
         "MDA SubSynth",
         "Sample Morpher",
         "Fibonacci Spiral Distort",
         "Harmonic Rich Filter",
-        "Wavetable Filter"
+        "Wavetable Filter",
+        "Spectral Morpher",
+        "Bandpass Fractal Filter"
     };
 }
 
@@ -31,12 +38,16 @@ std::unique_ptr<AudioModule> WubForgeAudioProcessor::createModuleFromName(const
 {
     if (name == "Universal Filter") return std::make_unique<UniversalFilterModule>();
     if (name == "Universal Distortion") return std::make_unique<UniversalDistortionModule>();
+    if (name == "Distortion Forge") return std::make_unique<DistortionForge>();
+    if (name == "Bit Crusher") return std::make_unique<BitCrusher>();
     // if (name == "Chow EQ") return std::make_unique<ChowEQModule>(); // Requires ChowDSP library
     if (name == "MDA SubSynth") return std::make_unique<MDASubSynthModuleDirect>();
     if (name == "Sample Morpher") return std::make_unique<SampleMorpher>();
     if (name == "Fibonacci Spiral Distort") return std::make_unique<FibonacciSpiralDistort>();
     if (name == "Harmonic Rich Filter") return std::make_unique<HarmonicRichFilter>();
     if (name == "Wavetable Filter") return std::make_unique<WavetableFilterModule>();
+    if (name == "Spectral Morpher") return std::make_unique<SpectralMorphingModule>();
+    if (name == "Bandpass Fractal Filter") return std::make_unique<BandpassFractalFilter>();
 
     return nullptr;
 }
@@ -65,17 +76,26 @@ WubForgeAudioProcessor::WubForgeAudioProcessor()
    moduleSlots[4] = nullptr;
 
    // Provide global components to modules that need them
-   for (auto& slot : moduleSlots)
+   for (int i = 0; i < numModuleSlots; ++i)
    {
-       if (slot != nullptr)
-           slot->setKeyTracker (&keyTracker);
+       if (moduleSlots[i] != nullptr)
+       {
+           moduleSlots[i]->setKeyTracker (&keyTracker);
+           moduleSlots[i]->setAnalysisPoint (analysisService.getPoint (i));
+           moduleSlots[i]->onLatencyChanged = [this] { triggerAsyncUpdate(); };
+       }
    }
 
    keyTracker.prepareToPlay (44100.0, 512);
+
+   for (auto& tap : spectrumTaps)
+       analyzerThread.addTimeSliceClient (&tap);
 }
 
 WubForgeAudioProcessor::~WubForgeAudioProcessor()
 {
+    cancelPendingUpdate();
+    analyzerThread.stopThread (1000);
 }
 
 //==============================================================================
@@ -86,6 +106,8 @@ void WubForgeAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
 
     juce::dsp::ProcessSpec spec { sampleRate, static_cast<juce::uint32>(samplesPerBlock), 2 };
 
+    analysisService.prepare (spec);
+
     // Prepare all modules
     for (auto& slot : moduleSlots)
     {
@@ -94,6 +116,10 @@ void WubForgeAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
     }
 
     keyTracker.prepareToPlay (sampleRate, samplesPerBlock);
+    updateLatency();
+
+    for (auto& tap : spectrumTaps)
+        tap.prepare (sampleRate, samplesPerBlock);
 
     // Prepare feedback
     feedbackBuffer.setSize(spec.numChannels, spec.maximumBlockSize);
@@ -119,6 +145,7 @@ void WubForgeAudioProcessor::reset()
     }
 
     keyTracker.reset();
+    analysisService.reset();
     feedbackBuffer.clear();
     outputGain.reset();
     dryWetMixer.reset();
@@ -146,15 +173,25 @@ void WubForgeAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     juce::dsp::AudioBlock<float> block (buffer);
     juce::dsp::ProcessContextReplacing<float> context (block);
 
-    // Process all slots in order
-    for (auto& slot : moduleSlots)
+    // Process all slots in order, capturing each slot's input for the shared STFT first
+    for (int i = 0; i < numModuleSlots; ++i)
     {
-        if (slot != nullptr)
-            slot->process (context);
+        if (moduleSlots[i] == nullptr)
+            continue;
+
+        auto* analysisPoint = analysisService.getPoint (i);
+        if (analysisPoint->hasUsers())
+            analysisPoint->pushBlock (block);
+        else
+            analysisPoint->skipBlock();
+
+        moduleSlots[i]->process (context);
+        spectrumTaps[(size_t) i].push (block);
     }
 
     // Apply final output processing
     outputGain.process (context);
+    spectrumTaps[outputSpectrumTap].push (block);
 }
 
 //==============================================================================
@@ -171,15 +208,76 @@ AudioModule* WubForgeAudioProcessor::getModuleInSlot (int slotIndex) const
     return nullptr;
 }
 
-//==============================================================================
-bool WubForgeAudioProcessor::getCurrentSpectrumData(float* magnitudeBuffer, int maxSize) const
+void WubForgeAudioProcessor::handleAsyncUpdate()
+{
+    updateLatency();
+}
+
+void WubForgeAudioProcessor::updateLatency()
 {
-    // Placeholder - modules can implement this if they support spectrum data
-    if (magnitudeBuffer && maxSize > 0)
+    // Slots run in series, so their delays add up
+    int totalLatency = 0;
+    for (auto& slot : moduleSlots)
     {
-        std::fill_n(magnitudeBuffer, maxSize, 0.0f);
+        if (slot != nullptr)
+            totalLatency += slot->getLatencySamples();
     }
-    return false;
+
+    if (totalLatency != getLatencySamples())
+        setLatencySamples (totalLatency);
+}
+
+//==============================================================================
+void WubForgeAudioProcessor::setSpectrumTapActive (int tapIndex, bool shouldBeActive)
+{
+    if (! juce::isPositiveAndBelow (tapIndex, numSpectrumTaps))
+        return;
+
+    spectrumTaps[(size_t) tapIndex].setActive (shouldBeActive);
+
+    // Only keep the analysis thread around while somebody is looking
+    const bool anyActive = std::any_of (spectrumTaps.begin(), spectrumTaps.end(),
+                                        [] (const SpectrumAnalyzerTap& tap) { return tap.isActive(); });
+
+    if (anyActive && ! analyzerThread.isThreadRunning())
+        analyzerThread.startThread();
+    else if (! anyActive && analyzerThread.isThreadRunning())
+        analyzerThread.stopThread (1000);
+}
+
+void WubForgeAudioProcessor::setSpectrumResolution (int tapIndex, SpectrumAnalyzerTap::Resolution resolution)
+{
+    if (juce::isPositiveAndBelow (tapIndex, numSpectrumTaps))
+        spectrumTaps[(size_t) tapIndex].setResolution (resolution);
+}
+
+bool WubForgeAudioProcessor::getCurrentSpectrumData(float* magnitudeBuffer, int maxSize) const
+{
+    return getSpectrumData (outputSpectrumTap, magnitudeBuffer, maxSize);
+}
+
+bool WubForgeAudioProcessor::getSpectrumData (int tapIndex, float* magnitudeBuffer, int maxSize) const
+{
+    if (! juce::isPositiveAndBelow (tapIndex, numSpectrumTaps))
+        return false;
+
+    return spectrumTaps[(size_t) tapIndex].readLatestFrame (magnitudeBuffer, maxSize);
+}
+
+int WubForgeAudioProcessor::getSpectrumFrame (int tapIndex, float* magnitudeBuffer, float* binFrequencies, int maxSize) const
+{
+    if (! juce::isPositiveAndBelow (tapIndex, numSpectrumTaps))
+        return 0;
+
+    return spectrumTaps[(size_t) tapIndex].readLatestFrame (magnitudeBuffer, binFrequencies, maxSize);
+}
+
+double WubForgeAudioProcessor::getSpectrumSampleRate (int tapIndex) const
+{
+    if (! juce::isPositiveAndBelow (tapIndex, numSpectrumTaps))
+        return currentSampleRate;
+
+    return spectrumTaps[(size_t) tapIndex].getAnalysisSampleRate();
 }
 
 //==============================================================================
@@ -236,12 +334,31 @@ juce::AudioProcessorValueTreeState::ParameterLayout WubForgeAudioProcessor::crea
         juce::NormalisableRange<float>(-60.0f, 0.0f, 0.1f),
         -24.0f));
 
+    // Spectral Morpher XY pad
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        "morphX",
+        "Spectral Morph X",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f),
+        0.5f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        "morphY",
+        "Spectral Morph Y",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f),
+        0.5f));
+
     return { params.begin(), params.end() };
 }
 
 //==============================================================================
 void WubForgeAudioProcessor::updateDSPParameters()
 {
+    // The XY pad only takes over a Spectral Morpher when it moves, so A/B morphing
+    // chosen on the module holds until the pad is touched or automated
+    const auto morphPosition = getMorphPosition();
+    const bool morphMoved = morphPosition != forwardedMorphPosition;
+    forwardedMorphPosition = morphPosition;
+
     // Update Harmonic Rich Filter parameters if module exists
     for (auto& slot : moduleSlots)
     {
@@ -309,9 +426,47 @@ void WubForgeAudioProcessor::updateDSPParameters()
                 // We'll need to add it to the filter interface
             }
         }
+
+        // The XY pad drives every Spectral Morpher in the chain
+        if (morphMoved && slot != nullptr && slot->getName() == "Spectral Morpher")
+            static_cast<SpectralMorphingModule*>(slot.get())->setMorphPosition(morphPosition.x, morphPosition.y);
     }
 }
 
+//==============================================================================
+void WubForgeAudioProcessor::beginMorphGesture()
+{
+    for (auto* id : { "morphX", "morphY" })
+        if (auto* param = valueTreeState.getParameter (id))
+            param->beginChangeGesture();
+}
+
+void WubForgeAudioProcessor::endMorphGesture()
+{
+    for (auto* id : { "morphX", "morphY" })
+        if (auto* param = valueTreeState.getParameter (id))
+            param->endChangeGesture();
+}
+
+void WubForgeAudioProcessor::setMorphPosition (float x, float y)
+{
+    if (auto* param = valueTreeState.getParameter ("morphX"))
+        param->setValueNotifyingHost (param->convertTo0to1 (x));
+    if (auto* param = valueTreeState.getParameter ("morphY"))
+        param->setValueNotifyingHost (param->convertTo0to1 (y));
+}
+
+juce::Point<float> WubForgeAudioProcessor::getMorphPosition() const
+{
+    auto morphXParam = valueTreeState.getRawParameterValue ("morphX");
+    auto morphYParam = valueTreeState.getRawParameterValue ("morphY");
+
+    if (morphXParam == nullptr || morphYParam == nullptr)
+        return { 0.5f, 0.5f };
+
+    return { morphXParam->load(), morphYParam->load() };
+}
+
 //==============================================================================
 void WubForgeAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
 {
@@ -399,7 +554,28 @@ void WubForgeAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
     auto state = valueTreeState.copyState();
     std::unique_ptr<juce::XmlElement> xml(state.createXml());
+
+    // Each Spectral Morpher's snapshot set follows the XML as raw bytes, in element order
+    juce::MemoryBlock snapshotSets;
+
+    for (int i = 0; i < numModuleSlots; ++i)
+    {
+        if (moduleSlots[i] != nullptr && moduleSlots[i]->getName() == "Spectral Morpher")
+        {
+            juce::MemoryBlock snapshotSet;
+
+            if (static_cast<SpectralMorphingModule*>(moduleSlots[i].get())->storeSnapshotSet(snapshotSet))
+            {
+                auto* element = xml->createNewChildElement("SpectralSnapshots");
+                element->setAttribute("slot", i);
+                element->setAttribute("bytes", (int) snapshotSet.getSize());
+                snapshotSets.append(snapshotSet.getData(), snapshotSet.getSize());
+            }
+        }
+    }
+
     copyXmlToBinary(*xml, destData);
+    destData.append(snapshotSets.getData(), snapshotSets.getSize());
 }
 
 void WubForgeAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
@@ -407,6 +583,42 @@ void WubForgeAudioProcessor::setStateInformation(const void* data, int sizeInByt
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
     if (xmlState.get() != nullptr)
+    {
         if (xmlState->hasTagName(valueTreeState.state.getType()))
+        {
+            // The snapshot sets are the last bytes of the state
+            size_t snapshotBytes = 0;
+            for (auto* element : xmlState->getChildWithTagNameIterator("SpectralSnapshots"))
+                snapshotBytes += (size_t) juce::jmax(0, element->getIntAttribute("bytes"));
+
+            const bool hasSnapshotSets = snapshotBytes <= (size_t) sizeInBytes;
+            auto* snapshotSet = static_cast<const char*>(data) + (hasSnapshotSets ? (size_t) sizeInBytes - snapshotBytes : 0);
+
+            for (auto* element : xmlState->getChildWithTagNameIterator("SpectralSnapshots"))
+            {
+                const int slotIndex = element->getIntAttribute("slot", -1);
+                const auto setSize = hasSnapshotSets ? (size_t) juce::jmax(0, element->getIntAttribute("bytes")) : 0;
+                auto* module = getModuleInSlot(slotIndex);
+
+                if (module != nullptr && module->getName() == "Spectral Morpher")
+                {
+                    auto* morpher = static_cast<SpectralMorphingModule*>(module);
+
+                    // States from before sets were embedded only hold the path of a file
+                    const auto legacyPath = element->getStringAttribute("file");
+                    juce::MemoryBlock legacySet;
+
+                    if (setSize > 0)
+                        morpher->restoreSnapshotSet(snapshotSet, setSize);
+                    else if (juce::File::isAbsolutePath(legacyPath) && juce::File(legacyPath).loadFileAsData(legacySet))
+                        morpher->restoreSnapshotSet(legacySet.getData(), legacySet.getSize());
+                }
+
+                snapshotSet += setSize;
+            }
+
+            xmlState->deleteAllChildElementsWithTagName("SpectralSnapshots");
             valueTreeState.replaceState(juce::ValueTree::fromXml(*xmlState));
+        }
+    }
 }
@@ -7,18 +7,24 @@
 #include <memory>
 #include "Module.h"
 #include "KeyTracker.h"
+#include "STFTAnalysisService.h"
+#include "SpectrumAnalyzerTap.h"
 #include "Presets.h"
 #include "HarmonicRichFilter.h"
 
 //==============================================================================
 class WubForgeAudioProcessor : public juce::AudioProcessor,
-                               public juce::AudioProcessorValueTreeState::Listener
+                               public juce::AudioProcessorValueTreeState::Listener,
+                               private juce::AsyncUpdater
 {
 private:
     //==============================================================================
     // AudioProcessorValueTreeState::Listener required implementation
     void parameterChanged(const juce::String& parameterID, float newValue) override;
 
+    // Reports a module's latency change to the host on the message thread
+    void handleAsyncUpdate() override;
+
 public:
     //==============================================================================
     // --- Factory Methods for Modules ---
@@ -63,20 +69,50 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    //==============================================================================
+    // Spectral morph XY pad (0..1 on both axes), forwarded to any Spectral Morpher slot.
+    // Wrap a drag in begin/endMorphGesture so hosts record it as one automation gesture.
+    void beginMorphGesture();
+    void setMorphPosition (float x, float y);
+    void endMorphGesture();
+    juce::Point<float> getMorphPosition() const;
+
     //==============================================================================
     // Visualization Data Access
-    bool getCurrentSpectrumData(float* magnitudeBuffer, int maxSize) const;
+    // Analyzer taps sit after each slot and at the output. They only do work while active,
+    // so the editor switches on the ones it displays and switches them off when it closes.
+    static constexpr int numSpectrumTaps = 6; // One per module slot, then the output
+    static constexpr int outputSpectrumTap = numSpectrumTaps - 1;
+
+    void setSpectrumTapActive (int tapIndex, bool shouldBeActive);
+    void setSpectrumResolution (int tapIndex, SpectrumAnalyzerTap::Resolution resolution);
+    bool getCurrentSpectrumData(float* magnitudeBuffer, int maxSize) const; // Output tap
+    bool getSpectrumData (int tapIndex, float* magnitudeBuffer, int maxSize) const;
+    double getSpectrumSampleRate (int tapIndex) const;
+
+    // Latest frame of any resolution with the frequency of each bin; returns the bin count, 0 if nothing new
+    int getSpectrumFrame (int tapIndex, float* magnitudeBuffer, float* binFrequencies, int maxSize) const;
 
 private:
     //==============================================================================
     // Modular DSP Components
     static constexpr int numModuleSlots = 5;
+    static_assert (numSpectrumTaps == numModuleSlots + 1, "Every slot needs a tap, plus one for the output");
+
+    // Shared STFT of each slot's input; declared first so it outlives the modules using it
+    STFTAnalysisService analysisService { numModuleSlots };
+
     std::array<std::unique_ptr<AudioModule>, numModuleSlots> moduleSlots;
     Routing currentRouting = Routing::Serial;
 
     // Global components
     KeyTracker keyTracker;
 
+    // Analyzer taps and the thread that runs their FFTs; the thread is declared last of
+    // the two so it stops before the taps go away
+    std::array<SpectrumAnalyzerTap, numSpectrumTaps> spectrumTaps;
+    juce::TimeSliceThread analyzerThread { "WubForge Analyzer" };
+
     // Feedback components
     juce::AudioBuffer<float> feedbackBuffer;
     juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>> feedbackDampingFilter;
@@ -98,10 +134,12 @@ private:
     // State
     double currentSampleRate = 44100.0;
     int currentBlockSize = 512;
+    juce::Point<float> forwardedMorphPosition { -1.0f, -1.0f };  // Last XY pad position sent to the morphers
 
     //==============================================================================
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     void updateDSPParameters();
+    void updateLatency();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WubForgeAudioProcessor)
 };
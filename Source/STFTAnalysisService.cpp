@@ -0,0 +1,154 @@
+#include "STFTAnalysisService.h"
+#include "FastMath.h"
+#include <algorithm>
+
+//==============================================================================
+STFTAnalysisService::STFTAnalysisService (int numPoints)
+{
+    // Periodic Hann, matching the STFT modules so their overlap-add gains still hold
+    for (int i = 0; i < fftSize; ++i)
+        window[(size_t) i] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) fftSize);
+
+    for (int i = 0; i < numPoints; ++i)
+        points.emplace_back (new Point (*this));
+}
+
+void STFTAnalysisService::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    workspace.assign (fftSize * 2, 0.0f);
+
+    for (auto& point : points)
+        point->prepare ((int) spec.numChannels, (int) spec.maximumBlockSize);
+}
+
+void STFTAnalysisService::reset() noexcept
+{
+    for (auto& point : points)
+        point->reset();
+}
+
+STFTAnalysisService::Point* STFTAnalysisService::getPoint (int index) noexcept
+{
+    return juce::isPositiveAndBelow (index, (int) points.size()) ? points[(size_t) index].get() : nullptr;
+}
+
+void STFTAnalysisService::analyse (Point& point, Frame& frame, int frameEnd) noexcept
+{
+    auto* data = workspace.data();
+    const int mask = point.historySize - 1;
+    const int start = (point.blockStart + frameEnd - fftSize) & mask;
+
+    for (int ch = 0; ch < point.numChannels; ++ch)
+    {
+        const auto* history = point.history.data() + (size_t) ch * (size_t) point.historySize;
+
+        for (int i = 0; i < fftSize; ++i)
+            data[i] = history[(start + i) & mask] * window[(size_t) i];
+
+        fft.performRealOnlyForwardTransform (data, true);
+
+        auto* real = frame.real.data() + (size_t) ch * numBins;
+        auto* imag = frame.imag.data() + (size_t) ch * numBins;
+
+        for (int i = 0; i < numBins; ++i)
+        {
+            real[i] = data[i * 2];
+            imag[i] = data[i * 2 + 1];
+        }
+
+        FastMath::cartesianToPolar (real, imag,
+                                    frame.magnitude.data() + (size_t) ch * numBins,
+                                    frame.phase.data() + (size_t) ch * numBins,
+                                    numBins);
+    }
+
+    frame.analysed = true;
+}
+
+//==============================================================================
+void STFTAnalysisService::Point::prepare (int newNumChannels, int maxBlockSize)
+{
+    numChannels = newNumChannels;
+    historySize = juce::nextPowerOfTwo (fftSize + maxBlockSize);
+    history.assign ((size_t) numChannels * (size_t) historySize, 0.0f);
+
+    const int maxFrames = maxBlockSize / hopSize + 1;
+    frames.resize ((size_t) maxFrames);
+    frameEnds.assign ((size_t) maxFrames, 0);
+
+    for (auto& frame : frames)
+    {
+        const auto size = (size_t) numChannels * numBins;
+        frame.real.assign (size, 0.0f);
+        frame.imag.assign (size, 0.0f);
+        frame.magnitude.assign (size, 0.0f);
+        frame.phase.assign (size, 0.0f);
+    }
+
+    reset();
+}
+
+void STFTAnalysisService::Point::reset() noexcept
+{
+    std::fill (history.begin(), history.end(), 0.0f);
+    writePosition = blockStart = 0;
+    samplesSinceHop = 0;
+    numFrames = 0;
+    skipped = false;
+}
+
+void STFTAnalysisService::Point::pushBlock (const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const int numSamples = (int) block.getNumSamples();
+    const int blockChannels = (int) block.getNumChannels();
+    const int mask = historySize - 1;
+
+    jassert (numSamples + fftSize <= historySize);
+
+    if (skipped)
+        reset();
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* dest = history.data() + (size_t) ch * (size_t) historySize;
+
+        if (ch < blockChannels)
+        {
+            const auto* source = block.getChannelPointer ((size_t) ch);
+            for (int i = 0; i < numSamples; ++i)
+                dest[(writePosition + i) & mask] = source[i];
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+                dest[(writePosition + i) & mask] = 0.0f;
+        }
+    }
+
+    blockStart = writePosition;
+    writePosition = (writePosition + numSamples) & mask;
+
+    // Hop boundaries that fall inside this block; frames are analysed lazily
+    numFrames = 0;
+    int position = 0;
+    while (samplesSinceHop + (numSamples - position) >= hopSize && numFrames < (int) frames.size())
+    {
+        position += hopSize - samplesSinceHop;
+        samplesSinceHop = 0;
+        frameEnds[(size_t) numFrames] = position;
+        frames[(size_t) numFrames].analysed = false;
+        ++numFrames;
+    }
+
+    samplesSinceHop += numSamples - position;
+}
+
+const STFTAnalysisService::Frame& STFTAnalysisService::Point::getFrame (int index) noexcept
+{
+    auto& frame = frames[(size_t) index];
+
+    if (! frame.analysed)
+        service.analyse (*this, frame, frameEnds[(size_t) index]);
+
+    return frame;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+    STFTAnalysisService - Shared forward STFT for points in the processing chain
+
+    The processor owns one service with an analysis point per module slot (the
+    signal entering that slot). Points live as long as the service, so modules
+    can keep a pointer to theirs. Each block, the processor pushes the signal at
+    every point that has a user; nothing else happens until somebody asks for a
+    frame. The first request for a hop runs the windowed FFT for all channels
+    and caches real/imaginary, magnitude and phase, so every later user of the
+    same point and hop gets it for free.
+
+    Frames use a 2048-point periodic Hann window and a hop of 512 samples. Hops
+    are counted from the last prepare()/reset(), so all users of a point agree
+    on where frames fall: getFrameEnd (i) is the number of samples of the
+    current block that frame i covers. A point that goes unused restarts from
+    silence when a user returns. Audio thread only.
+*/
+class STFTAnalysisService
+{
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2 + 1;
+    static constexpr int hopSize = fftSize / 4;
+
+    /** One analysed hop for all channels, split real/imaginary and polar arrays per channel. */
+    class Frame
+    {
+    public:
+        const float* getReal (int channel) const noexcept      { return real.data() + (size_t) channel * numBins; }
+        const float* getImag (int channel) const noexcept      { return imag.data() + (size_t) channel * numBins; }
+        const float* getMagnitude (int channel) const noexcept { return magnitude.data() + (size_t) channel * numBins; }
+        const float* getPhase (int channel) const noexcept     { return phase.data() + (size_t) channel * numBins; }
+
+    private:
+        friend class STFTAnalysisService;
+        std::vector<float> real, imag, magnitude, phase;
+        bool analysed = false;
+    };
+
+    //==============================================================================
+    class Point
+    {
+    public:
+        /** Stores the signal at this point for the current block. Called once per block by the processor. */
+        void pushBlock (const juce::dsp::AudioBlock<float>& block) noexcept;
+
+        /** Called by the processor instead of pushBlock() while nobody uses the point. The block
+            has no frames, and the next pushBlock() starts again from silence, as after a reset. */
+        void skipBlock() noexcept { numFrames = 0; skipped = true; }
+
+        int getNumChannels() const noexcept { return numChannels; }
+
+        /** Number of hops completed during the current block. */
+        int getNumFrames() const noexcept { return numFrames; }
+
+        /** Samples of the current block up to and including the end of frame index. */
+        int getFrameEnd (int index) const noexcept { return frameEnds[(size_t) index]; }
+
+        /** Returns frame index of the current block, analysing it on first use. */
+        const Frame& getFrame (int index) noexcept;
+
+        /** Users register so the processor only feeds points somebody reads. */
+        void addUser() noexcept    { ++numUsers; }
+        void removeUser() noexcept { --numUsers; }
+        bool hasUsers() const noexcept { return numUsers.load() > 0; }
+
+    private:
+        friend class STFTAnalysisService;
+        explicit Point (STFTAnalysisService& owner) : service (owner) {}
+
+        void prepare (int numChannels, int maxBlockSize);
+        void reset() noexcept;
+
+        STFTAnalysisService& service;
+
+        std::vector<float> history;   // Per channel circular buffers of historySize samples
+        int historySize = 0;          // Power of two >= fftSize + maxBlockSize
+        int writePosition = 0;
+        int blockStart = 0;
+        int samplesSinceHop = 0;
+        int numChannels = 0;
+
+        std::vector<Frame> frames;    // One per hop that can complete within a block
+        std::vector<int> frameEnds;
+        int numFrames = 0;
+        bool skipped = false;         // History is missing blocks since the last push
+
+        std::atomic<int> numUsers { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE (Point)
+    };
+
+    //==============================================================================
+    explicit STFTAnalysisService (int numPoints);
+
+    void prepare (const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    int getNumPoints() const noexcept { return (int) points.size(); }
+    Point* getPoint (int index) noexcept;
+
+private:
+    void analyse (Point& point, Frame& frame, int frameEnd) noexcept;
+
+    juce::dsp::FFT fft { fftOrder };
+    std::array<float, fftSize> window;
+    std::vector<float> workspace;
+    std::vector<std::unique_ptr<Point>> points;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (STFTAnalysisService)
+};
@@ -1,15 +1,23 @@
 #include "SpectralMorphingModule.h"
+#include "FastMath.h"
 #include <cmath>
 #include <algorithm>
 
+static_assert (SpectralMorphingModule::getFFTSize() == STFTAnalysisService::fftSize,
+               "Shared analysis frames must match the module's transform size");
+
+namespace
+{
+    // ln of the smallest magnitude FastMath::log resolves (1e-30)
+    constexpr float silentLogMagnitude = -69.0f;
+}
+
 //==============================================================================
 SpectralMorphingModule::SpectralMorphingModule()
 {
-    // Create Hann window for overlap-add (shared across channels)
-    windowBuffer.resize(fftSize);
-    for (int i = 0; i < fftSize; ++i) {
-        windowBuffer[i] = 0.5f * (1.0f - std::cos(2.0f * M_PI * i / (fftSize - 1)));
-    }
+    // Periodic Hann so that overlapped squared windows sum to a constant
+    for (int i = 0; i < fftSize; ++i)
+        window[i] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) fftSize);
 }
 
 void SpectralMorphingModule::prepare(const juce::dsp::ProcessSpec& spec)
@@ -18,52 +26,63 @@ void SpectralMorphingModule::prepare(const juce::dsp::ProcessSpec& spec)
     blockSize = spec.maximumBlockSize;
     numChannels = (int)spec.numChannels;
 
-    // Adjust FFT size based on sample rate for optimal performance
-    // (Keeping original logic for now, but windowSize should ideally be fftSize constant)
-    if (sampleRate >= 88200) {
-        windowSize = 4096;
-    } else if (sampleRate >= 44100) {
-        windowSize = 2048;
-    } else {
-        windowSize = 1024;
-    }
+    hopSize = fftSize / overlapFactor;
 
-    // Resize per-channel buffers and FFT objects
-    inputBuffers.resize(numChannels);
-    outputBuffers.resize(numChannels);
-    frequencyDomains.resize(numChannels);
-    forwardFFTs.clear(); // Clear existing FFTs
-    forwardFFTs.reserve(numChannels);
+    // Hann analysis * Hann synthesis: normalise by the summed squared window
+    float windowSum = 0.0f;
+    for (int i = 0; i < fftSize; i += hopSize)
+        windowSum += window[i] * window[i];
+    overlapAddGain = windowSum > 0.0f ? 1.0f / windowSum : 1.0f;
 
-    for (int ch = 0; ch < numChannels; ++ch)
-    {
-        inputBuffers[ch].resize(windowSize, 0.0f);
-        outputBuffers[ch].resize(windowSize, 0.0f);
-        frequencyDomains[ch].resize(windowSize / 2 + 1, {0.0f, 0.0f});
-        forwardFFTs.emplace_back(fftOrder); // Initialize JUCE FFT
-    }
+    expectedAdvance.resize(numBins);
+    for (int i = 0; i < numBins; ++i)
+        expectedAdvance[i] = FastMath::twoPi * (float)i * (float)hopSize / (float)fftSize;
 
-    // Resize snapshots for each channel
-    for (auto& snapshot : spectralSnapshots)
+    channels.resize(numChannels);
+    for (auto& state : channels)
     {
-        snapshot.magnitude.resize(numChannels);
-        snapshot.phase.resize(numChannels);
-        for (int ch = 0; ch < numChannels; ++ch)
-        {
-            snapshot.magnitude[ch].resize(windowSize / 2 + 1, 1.0f);
-            snapshot.phase[ch].resize(windowSize / 2 + 1, 0.0f);
-        }
+        state.inputFifo.assign(fftSize, 0.0f);
+        state.outputAccumulator.assign(fftSize, 0.0f);
+        state.fftData.assign(fftSize * 2, 0.0f);
+        state.real.assign(numBins, 0.0f);
+        state.imag.assign(numBins, 0.0f);
+        state.magnitude.assign(numBins, 0.0f);
+        state.logMagnitude.assign(numBins, silentLogMagnitude);
+        state.previousLogMagnitude.assign(numBins, silentLogMagnitude);
+        state.phase.assign(numBins, 0.0f);
+        state.previousPhase.assign(numBins, 0.0f);
+        state.frequency.assign(numBins, 0.0f);
+        state.outputMagnitude.assign(numBins, 0.0f);
+        state.synthesisPhase.assign(numBins, 0.0f);
+        state.peaks.assign(numBins, 0);
     }
+
+    // Frequencies are stored per sample so captures survive a hop change
+    snapshotBank.prepare(numChannels, numBins);
+
+    reset();
 }
 
 void SpectralMorphingModule::reset()
 {
-    for (int ch = 0; ch < numChannels; ++ch)
+    for (auto& state : channels)
     {
-        std::fill(inputBuffers[ch].begin(), inputBuffers[ch].end(), 0.0f);
-        std::fill(outputBuffers[ch].begin(), outputBuffers[ch].end(), 0.0f);
+        std::fill(state.inputFifo.begin(), state.inputFifo.end(), 0.0f);
+        std::fill(state.outputAccumulator.begin(), state.outputAccumulator.end(), 0.0f);
+        std::fill(state.logMagnitude.begin(), state.logMagnitude.end(), silentLogMagnitude);
+        std::fill(state.previousLogMagnitude.begin(), state.previousLogMagnitude.end(), silentLogMagnitude);
+        std::fill(state.phase.begin(), state.phase.end(), 0.0f);
+        std::fill(state.frequency.begin(), state.frequency.end(), 0.0f);
+        std::fill(state.synthesisPhase.begin(), state.synthesisPhase.end(), 0.0f);
     }
-    bufferPosition = 0;
+
+    morphAmount = targetMorphAmount;
+    morphX = targetMorphX;
+    morphY = targetMorphY;
+    updateSpectralMorphing();
+
+    fifoPosition = 0;
+    hopCounter = 0;
 }
 
 void SpectralMorphingModule::process(const juce::dsp::ProcessContextReplacing<float>& context)
@@ -71,170 +90,357 @@ void SpectralMorphingModule::process(const juce::dsp::ProcessContextReplacing<fl
     auto& inputBlock = context.getInputBlock();
     auto& outputBlock = context.getOutputBlock();
     auto numSamples = (int)inputBlock.getNumSamples();
-
-    for (int sample = 0; sample < numSamples; ++sample)
+    auto channelsToProcess = juce::jmin(numChannels, (int)outputBlock.getNumChannels());
+
+    // The processor's shared analysis replaces our own forward FFT when its hop matches
+    auto* sharedAnalysis = analysisPoint != nullptr
+                           && hopSize == STFTAnalysisService::hopSize
+                           && analysisPoint->getNumChannels() >= channelsToProcess
+                         ? analysisPoint : nullptr;
+    int sharedFrameIndex = 0;
+
+    // Work in runs that end on hop boundaries so the inner loops stay branch-free
+    int sampleIndex = 0;
+    while (sampleIndex < numSamples)
     {
-        for (int ch = 0; ch < numChannels; ++ch)
-        {
-            float inputSample = inputBlock.getSample(ch, sample);
-            inputBuffers[ch][bufferPosition] = inputSample; // Store per channel
-        }
+        int runLength = juce::jmin(numSamples - sampleIndex, hopSize - hopCounter);
 
-        bufferPosition++;
+        if (sharedAnalysis != nullptr)
+            runLength = sharedFrameIndex < sharedAnalysis->getNumFrames()
+                      ? sharedAnalysis->getFrameEnd(sharedFrameIndex) - sampleIndex
+                      : numSamples - sampleIndex;
 
-        // Process when buffer is full
-        if (bufferPosition >= windowSize)
+        for (int ch = 0; ch < channelsToProcess; ++ch)
         {
-            bufferPosition = 0;
-            performSpectralProcessing(); // This will now process all channels
+            auto& state = channels[ch];
+            auto* input = inputBlock.getChannelPointer(ch) + sampleIndex;
+            auto* output = outputBlock.getChannelPointer(ch) + sampleIndex;
+
+            for (int i = 0; i < runLength; ++i)
+            {
+                const int pos = (fifoPosition + i) & (fftSize - 1);
+                const float inputSample = input[i];
+                state.inputFifo[pos] = inputSample;
+                output[i] = state.outputAccumulator[pos];
+                state.outputAccumulator[pos] = 0.0f;
+            }
         }
 
-        // Output processed sample
-        for (int ch = 0; ch < numChannels; ++ch)
+        fifoPosition = (fifoPosition + runLength) & (fftSize - 1);
+        hopCounter += runLength;
+        sampleIndex += runLength;
+
+        const bool hopComplete = sharedAnalysis != nullptr
+                               ? sharedFrameIndex < sharedAnalysis->getNumFrames()
+                                 && sampleIndex == sharedAnalysis->getFrameEnd(sharedFrameIndex)
+                               : hopCounter == hopSize;
+
+        if (hopComplete)
         {
-            outputBlock.setSample(ch, sample, outputBuffers[ch][bufferPosition]);
+            hopCounter = 0;
+            updateSpectralMorphing();
+
+            const auto* frame = sharedAnalysis != nullptr ? &sharedAnalysis->getFrame(sharedFrameIndex++) : nullptr;
+
+            for (int ch = 0; ch < channelsToProcess; ++ch)
+            {
+                if (frame != nullptr)
+                    processFrame(ch, frame->getMagnitude(ch), frame->getPhase(ch));
+                else
+                    processFrame(ch, nullptr, nullptr);
+            }
+
+            if (snapshotBank.hasPendingWork())
+                serviceSnapshotBank();
         }
     }
 }
 
-void SpectralMorphingModule::performSpectralProcessing()
+void SpectralMorphingModule::processFrame(int ch, const float* sharedMagnitude, const float* sharedPhase)
 {
-    for (int ch = 0; ch < numChannels; ++ch)
+    auto& state = channels[ch];
+    auto* fftData = state.fftData.data();
+    auto* real = state.real.data();
+    auto* imag = state.imag.data();
+
+    // Unroll the circular FIFO (oldest sample first); also the start of the overlap-add below
+    const int oldest = fifoPosition;
+    const int firstPart = fftSize - oldest;
+
+    //==============================================================================
+    // Analysis: log-magnitude, phase and per-bin instantaneous frequency
+    std::swap(state.logMagnitude, state.previousLogMagnitude);
+    std::swap(state.phase, state.previousPhase);
+
+    const float* magnitude = sharedMagnitude;
+
+    if (sharedMagnitude != nullptr)
     {
-        // Apply window and copy to frequency domain buffer
-        std::vector<float> fftInput(windowSize);
-        for (int i = 0; i < windowSize; ++i)
+        std::copy(sharedPhase, sharedPhase + numBins, state.phase.begin());
+    }
+    else
+    {
+        for (int i = 0; i < firstPart; ++i)
+            fftData[i] = state.inputFifo[oldest + i] * window[i];
+        for (int i = 0; i < oldest; ++i)
+            fftData[firstPart + i] = state.inputFifo[i] * window[firstPart + i];
+
+        fft.performRealOnlyForwardTransform(fftData, true);
+
+        for (int i = 0; i < numBins; ++i)
         {
-            fftInput[i] = inputBuffers[ch][i] * windowBuffer[i];
+            real[i] = fftData[i * 2];
+            imag[i] = fftData[i * 2 + 1];
         }
 
-        // FFT analysis using JUCE FFT
-        forwardFFTs[ch].performRealOnlyForwardTransform(fftInput.data());
+        FastMath::cartesianToPolar(real, imag, state.magnitude.data(), state.phase.data(), numBins);
+        magnitude = state.magnitude.data();
+    }
+
+    {
+        float* __restrict logMagnitude = state.logMagnitude.data();
 
-        // Copy to frequencyDomains for magnitude/phase extraction
-        for (int i = 0; i < windowSize / 2 + 1; ++i)
+        for (int i = 0; i < numBins; ++i)
+            logMagnitude[i] = FastMath::log(magnitude[i]);
+    }
+
+    {
+        const float* __restrict phase = state.phase.data();
+        const float* __restrict previousPhase = state.previousPhase.data();
+        const float* __restrict expected = expectedAdvance.data();
+        float* __restrict frequency = state.frequency.data();
+        const float invHop = 1.0f / (float)hopSize;
+
+        for (int i = 0; i < numBins; ++i)
         {
-            frequencyDomains[ch][i] = std::complex<float>(fftInput[i * 2], fftInput[i * 2 + 1]);
+            // The deviation from the bin's centre advance is only known modulo 2*pi
+            const float deviation = FastMath::wrapPhase(phase[i] - previousPhase[i] - expected[i]);
+            frequency[i] = (expected[i] + deviation) * invHop;
         }
+    }
 
-        // Extract magnitude and phase
-        std::vector<float> currentMagnitude(frequencyDomains[ch].size());
-        std::vector<float> currentPhase(frequencyDomains[ch].size());
-
-        for (size_t i = 0; i < frequencyDomains[ch].size(); ++i)
+    //==============================================================================
+    // Morph: one pass over the frame mixing all snapshots and the live input
+    {
+        const float* __restrict inputLogMagnitude = state.logMagnitude.data();
+        const float* __restrict inputFrequency = state.frequency.data();
+        const float* __restrict l0 = snapshotBank.getLogMagnitude(0, ch);
+        const float* __restrict l1 = snapshotBank.getLogMagnitude(1, ch);
+        const float* __restrict l2 = snapshotBank.getLogMagnitude(2, ch);
+        const float* __restrict l3 = snapshotBank.getLogMagnitude(3, ch);
+        const float* __restrict f0 = snapshotBank.getFrequency(0, ch);
+        const float* __restrict f1 = snapshotBank.getFrequency(1, ch);
+        const float* __restrict f2 = snapshotBank.getFrequency(2, ch);
+        const float* __restrict f3 = snapshotBank.getFrequency(3, ch);
+        float* __restrict outputMagnitude = state.outputMagnitude.data();
+        float* __restrict synthesisPhase = state.synthesisPhase.data();
+
+        const float wIn = inputWeight;
+        const float w0 = snapshotWeights[0], w1 = snapshotWeights[1];
+        const float w2 = snapshotWeights[2], w3 = snapshotWeights[3];
+        const float hop = (float)hopSize;
+        const float inputHop = hop * phasePreservation;
+        const float morphHop = hop * (1.0f - phasePreservation);
+
+        for (int i = 0; i < numBins; ++i)
         {
-            currentMagnitude[i] = std::abs(frequencyDomains[ch][i]);
-            currentPhase[i] = std::arg(frequencyDomains[ch][i]);
+            const float logMagnitude = wIn * inputLogMagnitude[i]
+                                     + w0 * l0[i] + w1 * l1[i] + w2 * l2[i] + w3 * l3[i];
+
+            const float morphedFrequency = wIn * inputFrequency[i]
+                                         + w0 * f0[i] + w1 * f1[i] + w2 * f2[i] + w3 * f3[i];
+
+            const float advance = inputHop * inputFrequency[i] + morphHop * morphedFrequency;
+
+            outputMagnitude[i] = FastMath::exp(logMagnitude);
+            synthesisPhase[i] = FastMath::wrapPhase(synthesisPhase[i] + advance);
         }
+    }
 
-        // Update spectral analysis (can be per-channel or averaged later)
-        // For now, let's assume these are still calculated for a single channel or averaged
-        currentCentroid = calculateSpectralCentroid(currentMagnitude);
-        currentSpectralFlux = calculateSpectralFlux(currentMagnitude);
+    if (phaseLocking)
+        lockPhasesToPeaks(ch);
 
-        // Apply spectral morphing
-        updateSpectralMorphing(); // This method needs to be updated to handle per-channel snapshots
+    //==============================================================================
+    // Resynthesis
+    FastMath::polarToCartesian(state.outputMagnitude.data(), state.synthesisPhase.data(), real, imag, numBins);
 
-        // Reconstruct frequency domain
-        for (size_t i = 0; i < frequencyDomains[ch].size(); ++i)
-        {
-            float magnitude = spectralSnapshots[activeSourceSlot].magnitude[ch][i] * (1.0f - morphAmount) +
-                             spectralSnapshots[activeTargetSlot].magnitude[ch][i] * morphAmount;
+    // Apply spectral warping
+    applySpectralWarping(real, imag);
 
-            float phase = spectralSnapshots[activeSourceSlot].phase[ch][i] * (1.0f - morphAmount) +
-                         spectralSnapshots[activeTargetSlot].phase[ch][i] * morphAmount;
+    for (int i = 0; i < numBins; ++i)
+    {
+        fftData[i * 2] = real[i];
+        fftData[i * 2 + 1] = imag[i];
+    }
 
-            // Apply phase preservation
-            phase = currentPhase[i] * phasePreservation + phase * (1.0f - phasePreservation);
+    fft.performRealOnlyInverseTransform(fftData);
 
-            frequencyDomains[ch][i] = std::polar(magnitude, phase);
-        }
+    // Synthesis window and overlap-add back into the circular accumulator
+    for (int i = 0; i < firstPart; ++i)
+        state.outputAccumulator[oldest + i] += fftData[i] * window[i] * overlapAddGain;
+    for (int i = 0; i < oldest; ++i)
+        state.outputAccumulator[i] += fftData[firstPart + i] * window[firstPart + i] * overlapAddGain;
+}
 
-        // Apply spectral warping
-        applySpectralWarping(); // This method needs to be updated to handle per-channel frequency domains
+void SpectralMorphingModule::lockPhasesToPeaks(int ch)
+{
+    auto& state = channels[ch];
+    const float* magnitude = state.outputMagnitude.data();
+    float* synthesisPhase = state.synthesisPhase.data();
+    int* peaks = state.peaks.data();
+
+    // Peaks of the morphed spectrum: larger than two neighbours on each side
+    int numPeaks = 0;
+    for (int i = 2; i < numBins - 2; ++i)
+    {
+        const float m = magnitude[i];
+        if (m > magnitude[i - 1] && m >= magnitude[i + 1] && m > magnitude[i - 2] && m >= magnitude[i + 2])
+            peaks[numPeaks++] = i;
+    }
 
-        // IFFT synthesis using JUCE FFT
-        std::vector<float> ifftOutput(windowSize);
-        for (int i = 0; i < windowSize / 2 + 1; ++i)
+    // Bins around a peak take their phase offsets from whichever source dominates the mix
+    const float* phase = state.phase.data();
+    float largestWeight = inputWeight;
+    for (int slot = 0; slot < numSnapshots; ++slot)
+    {
+        if (snapshotWeights[slot] > largestWeight)
         {
-            ifftOutput[i * 2] = frequencyDomains[ch][i].real();
-            ifftOutput[i * 2 + 1] = frequencyDomains[ch][i].imag();
+            largestWeight = snapshotWeights[slot];
+            phase = snapshotBank.getPhase(slot, ch);
         }
-        forwardFFTs[ch].performRealOnlyInverseTransform(ifftOutput.data());
+    }
 
-        // Apply window and overlap-add
-        for (int i = 0; i < windowSize; ++i)
-        {
-            outputBuffers[ch][i] = outputBuffers[ch][i] * 0.5f + ifftOutput[i] * windowBuffer[i] * 0.5f;
-        }
+    // Each peak owns the bins up to the midpoint with its neighbours. Only peaks keep
+    // their accumulated phase; the rest hold the reference phase offset to their peak.
+    int regionStart = 0;
+    for (int p = 0; p < numPeaks; ++p)
+    {
+        const int peak = peaks[p];
+        const int regionEnd = p + 1 < numPeaks ? (peak + peaks[p + 1]) / 2 + 1 : numBins;
+        const float peakSynthesisPhase = synthesisPhase[peak];
+        const float peakPhase = phase[peak];
+
+        for (int i = regionStart; i < regionEnd; ++i)
+            synthesisPhase[i] = FastMath::wrapPhase(peakSynthesisPhase + (phase[i] - peakPhase));
+
+        regionStart = regionEnd;
     }
 }
 
+void SpectralMorphingModule::serviceSnapshotBank()
+{
+    SpectralSnapshotBank::ScopedUpdate update(snapshotBank);
+    if (! update.isValid())
+        return; // A save holds the bank, or a stale load was dropped; try again next hop
 
+    const auto requests = update.takeCaptureRequests();
+
+    for (int slot = 0; slot < numSnapshots; ++slot)
+    {
+        if ((requests & (1u << slot)) == 0)
+            continue;
+
+        float centroid = 0.0f;
+        float flux = 0.0f;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            // Copy the frame analysed this hop
+            const auto& state = channels[ch];
+            std::copy(state.logMagnitude.begin(), state.logMagnitude.end(), update.getLogMagnitude(slot, ch));
+            std::copy(state.frequency.begin(), state.frequency.end(), update.getFrequency(slot, ch));
+            std::copy(state.phase.begin(), state.phase.end(), update.getPhase(slot, ch));
+
+            centroid += calculateSpectralCentroid(state.logMagnitude);
+            flux += calculateSpectralFlux(state.logMagnitude, state.previousLogMagnitude);
+        }
+
+        // Descriptors are fixed for the lifetime of the snapshot
+        auto& info = update.getSlotInfo(slot);
+        info.captured = true;
+        info.centroid = numChannels > 0 ? centroid / (float)numChannels : 0.0f;
+        info.spectralFlux = numChannels > 0 ? flux / (float)numChannels : 0.0f;
+    }
+}
 
 void SpectralMorphingModule::updateSpectralMorphing()
 {
-    // Smooth morph amount changes
+    // Smooth morph position changes once per hop
     morphAmount = morphAmount + (targetMorphAmount - morphAmount) * morphSpeed;
+    morphX = morphX + (targetMorphX - morphX) * morphSpeed;
+    morphY = morphY + (targetMorphY - morphY) * morphSpeed;
 
-    // Update snapshot analysis (per-channel)
-    for (auto& snapshot : spectralSnapshots)
+    snapshotWeights.fill(0.0f);
+
+    if (useMorphPosition)
     {
-        for (int ch = 0; ch < numChannels; ++ch)
+        // Bilinear weights over the four corners of the XY pad
+        snapshotWeights[0] = (1.0f - morphX) * (1.0f - morphY);
+        snapshotWeights[1] = morphX * (1.0f - morphY);
+        snapshotWeights[2] = (1.0f - morphX) * morphY;
+        snapshotWeights[3] = morphX * morphY;
+    }
+    else
+    {
+        snapshotWeights[activeSourceSlot] += 1.0f - morphAmount;
+        snapshotWeights[activeTargetSlot] += morphAmount;
+    }
+
+    // Empty slots hand their share to the live input
+    inputWeight = 0.0f;
+    for (int slot = 0; slot < numSnapshots; ++slot)
+    {
+        if (! snapshotBank.getSlotInfo(slot).captured)
         {
-            snapshot.centroid = calculateSpectralCentroid(snapshot.magnitude[ch]);
-            snapshot.spectralFlux = calculateSpectralFlux(snapshot.magnitude[ch]);
+            inputWeight += snapshotWeights[slot];
+            snapshotWeights[slot] = 0.0f;
         }
     }
 }
 
-void SpectralMorphingModule::applySpectralWarping()
+void SpectralMorphingModule::applySpectralWarping(float* real, float* imag)
 {
     if (std::abs(spectralWarping) < 0.01f) return;
 
-    for (int ch = 0; ch < numChannels; ++ch)
+    // Apply spectral warping to frequency domain
+    for (int i = 1; i < numBins - 1; ++i)
     {
-        // Apply spectral warping to frequency domain
-        for (size_t i = 1; i < frequencyDomains[ch].size() - 1; ++i)
-        {
-            float normalizedFreq = (float)i / frequencyDomains[ch].size();
-            float warpFactor = 1.0f + spectralWarping * (1.0f - normalizedFreq);
+        float normalizedFreq = (float)i / (float)numBins;
+        float warpFactor = 1.0f + spectralWarping * (1.0f - normalizedFreq);
 
-            // Interpolate with neighboring bins
-            size_t warpedIndex = (size_t)(i * warpFactor);
-            if (warpedIndex < frequencyDomains[ch].size())
-            {
-                frequencyDomains[ch][i] = frequencyDomains[ch][i] * (1.0f - spectralWarping) +
-                                       frequencyDomains[ch][warpedIndex] * spectralWarping;
-            }
+        // Interpolate with neighboring bins
+        int warpedIndex = (int)((float)i * warpFactor);
+        if (warpedIndex >= 0 && warpedIndex < numBins)
+        {
+            real[i] = real[i] * (1.0f - spectralWarping) + real[warpedIndex] * spectralWarping;
+            imag[i] = imag[i] * (1.0f - spectralWarping) + imag[warpedIndex] * spectralWarping;
         }
     }
 }
 
-float SpectralMorphingModule::calculateSpectralCentroid(const std::vector<float>& magnitude)
+float SpectralMorphingModule::calculateSpectralCentroid(const std::vector<float>& logMagnitude) const
 {
+    const float binWidth = (float)sampleRate / (float)fftSize;
     float numerator = 0.0f;
     float denominator = 0.0f;
 
-    for (size_t i = 0; i < magnitude.size(); ++i)
+    for (size_t i = 0; i < logMagnitude.size(); ++i)
     {
-        float freq = (float)i * sampleRate / (2.0f * magnitude.size());
-        numerator += freq * magnitude[i];
-        denominator += magnitude[i];
+        const float magnitude = FastMath::exp(logMagnitude[i]);
+        numerator += (float)i * binWidth * magnitude;
+        denominator += magnitude;
     }
 
     return denominator > 0.0f ? numerator / denominator : 0.0f;
 }
 
-float SpectralMorphingModule::calculateSpectralFlux(const std::vector<float>& magnitude)
+float SpectralMorphingModule::calculateSpectralFlux(const std::vector<float>& logMagnitude,
+                                                    const std::vector<float>& previousLogMagnitude) const
 {
-    // Simplified spectral flux calculation
+    // Half-wave rectified difference to the previous frame
     float flux = 0.0f;
-    for (size_t i = 0; i < magnitude.size(); ++i)
-    {
-        float diff = magnitude[i] - spectralSnapshots[activeSourceSlot].magnitude[i];
-        flux += std::max(0.0f, diff);
-    }
+    for (size_t i = 0; i < logMagnitude.size(); ++i)
+        flux += std::max(0.0f, FastMath::exp(logMagnitude[i]) - FastMath::exp(previousLogMagnitude[i]));
     return flux;
 }
 
@@ -246,6 +452,13 @@ void SpectralMorphingModule::setMorphAmount(float amount)
     targetMorphAmount = juce::jlimit(0.0f, 1.0f, amount);
 }
 
+void SpectralMorphingModule::setMorphPosition(float x, float y)
+{
+    targetMorphX = juce::jlimit(0.0f, 1.0f, x);
+    targetMorphY = juce::jlimit(0.0f, 1.0f, y);
+    useMorphPosition = true;
+}
+
 void SpectralMorphingModule::setMorphSpeed(float speed)
 {
     morphSpeed = juce::jlimit(0.01f, 1.0f, speed);
@@ -261,38 +474,39 @@ void SpectralMorphingModule::setPhasePreservation(float preserve)
     phasePreservation = juce::jlimit(0.0f, 1.0f, preserve);
 }
 
-void SpectralMorphingModule::captureSpectralSnapshot(int slot)
+void SpectralMorphingModule::setPhaseLocking(bool shouldLock)
 {
-    if (slot < 0 || slot >= 4) return;
+    phaseLocking = shouldLock;
+}
 
-    // Resize snapshot vectors for current number of channels
-    spectralSnapshots[slot].magnitude.resize(numChannels);
-    spectralSnapshots[slot].phase.resize(numChannels);
+void SpectralMorphingModule::setOverlap(int newOverlapFactor)
+{
+    // Hann^2 only sums to a constant for 4x overlap and above
+    overlapFactor = newOverlapFactor >= 8 ? 8 : 4;
+}
 
-    for (int ch = 0; ch < numChannels; ++ch)
-    {
-        // Copy current spectral data to snapshot for each channel
-        spectralSnapshots[slot].magnitude[ch].resize(frequencyDomains[ch].size());
-        spectralSnapshots[slot].phase[ch].resize(frequencyDomains[ch].size());
+void SpectralMorphingModule::captureSpectralSnapshot(int slot)
+{
+    snapshotBank.requestCapture(slot);
+}
 
-        for (size_t i = 0; i < frequencyDomains[ch].size(); ++i)
-        {
-            spectralSnapshots[slot].magnitude[ch][i] = std::abs(frequencyDomains[ch][i]);
-            spectralSnapshots[slot].phase[ch][i] = std::arg(frequencyDomains[ch][i]);
-        }
-    }
+bool SpectralMorphingModule::storeSnapshotSet(juce::MemoryBlock& destData)
+{
+    juce::MemoryOutputStream out(destData, true);
+    return snapshotBank.writeToStream(out);
+}
 
-    // Centroid and spectral flux might need to be per-channel or averaged,
-    // keeping as is for now, assuming they are calculated from a single channel or averaged.
-    spectralSnapshots[slot].centroid = currentCentroid;
-    spectralSnapshots[slot].spectralFlux = currentSpectralFlux;
+bool SpectralMorphingModule::restoreSnapshotSet(const void* data, size_t dataSize)
+{
+    return snapshotBank.loadFromData(data, dataSize);
 }
 
 void SpectralMorphingModule::setActiveSnapshots(int sourceSlot, int targetSlot)
 {
-    if (sourceSlot >= 0 && sourceSlot < 4 && targetSlot >= 0 && targetSlot < 4)
+    if (sourceSlot >= 0 && sourceSlot < numSnapshots && targetSlot >= 0 && targetSlot < numSnapshots)
     {
         activeSourceSlot = sourceSlot;
         activeTargetSlot = targetSlot;
+        useMorphPosition = false;
     }
 }
@@ -1,15 +1,39 @@
 #pragma once
 
 #include "Module.h"
+#include "SpectralSnapshotBank.h"
 #include <vector>
 #include <array>
-#include <complex>
 
 //==============================================================================
 /**
     Advanced spectral morphing engine inspired by Xfer Serum 2 and Vital.
     Enables real-time morphing between spectral snapshots with phase preservation
     for natural-sounding transitions between bass timbres.
+
+    Runs a fixed 2048-point STFT with a Hann analysis/synthesis window pair and
+    a configurable hop (75% overlap by default). Input is collected in a circular
+    FIFO per channel and resynthesised by overlap-add; all frame buffers are
+    allocated in prepare(). The module reports fftSize samples of latency.
+    When the processor provides a shared analysis point with the same hop, its
+    frames are used and the module's own forward FFT is skipped.
+
+    Resynthesis is a phase vocoder: every bin carries its measured instantaneous
+    frequency, snapshots store log-magnitude and frequency, and the morph mixes
+    both in one pass over the frame. Magnitudes are interpolated in the log
+    domain so a morph sweeps through timbres instead of crossfading them. Phases
+    are accumulated from the morphed advance at spectral peaks and the bins
+    around each peak keep the phase offsets of the dominant source (identity
+    phase locking), which keeps partials coherent instead of smearing them.
+
+    The morph position is either an A/B amount between two active snapshots or
+    a bilinear XY position over all four (0 = bottom-left, 1 = bottom-right,
+    2 = top-left, 3 = top-right). Weight on a slot that has not been captured
+    falls through to the live input.
+
+    Snapshots live in a SpectralSnapshotBank: captures are requested from any
+    thread and taken on the audio thread at the next hop, and the set is
+    stored with the plugin state so sessions reopen without re-capturing.
 */
 class SpectralMorphingModule : public FilterModule
 {
@@ -20,65 +44,105 @@ public:
     void process (const juce::dsp::ProcessContextReplacing<float>& context) override;
     void reset() override;
 
+    int getLatencySamples() const override { return fftSize; }
+    bool usesSharedAnalysis() const override { return true; }
+
     const juce::String getName() const override { return "Spectral Morpher"; }
 
     //==============================================================================
     // Spectral Morphing Parameters
     void setMorphAmount (float amount);        // 0.0 = Source A, 1.0 = Source B
+    void setMorphPosition (float x, float y);  // XY pad, 0..1 each; switches to four-way morphing
     void setMorphSpeed (float speed);          // Transition speed (0.0 to 1.0)
     void setSpectralWarping (float warp);      // Spectral shape modification
-    void setPhasePreservation (float preserve); // 0.0 = Free phase, 1.0 = Preserve phase
+    void setPhasePreservation (float preserve); // 0.0 = Snapshot phase motion, 1.0 = Input phase motion
+    void setPhaseLocking (bool shouldLock);    // Identity phase locking around spectral peaks
+
+    // STFT configuration
+    void setOverlap (int overlapFactor);       // 4 = 75% (default) or 8 = 87.5%, applied on next prepare()
 
     // Spectral snapshot management
-    void captureSpectralSnapshot (int slot);   // Capture current spectral state
-    void setActiveSnapshots (int sourceSlot, int targetSlot);
+    void captureSpectralSnapshot (int slot);   // Captures the next analysed frame; safe from any thread
+    void setActiveSnapshots (int sourceSlot, int targetSlot); // Switches back to A/B morphing
+
+    // Snapshot persistence (not the audio thread). storeSnapshotSet() appends the captured set
+    // to destData, or returns false if nothing has been captured; restoreSnapshotSet() loads
+    // one back and hands it to the audio thread at the next hop.
+    bool storeSnapshotSet (juce::MemoryBlock& destData);
+    bool restoreSnapshotSet (const void* data, size_t dataSize);
+
+    static constexpr int numSnapshots = SpectralSnapshotBank::numSlots;
+    static constexpr int getFFTSize() { return fftSize; }
 
 private:
-    void performFFT();
-    void performIFFT();
+    void processFrame (int channel, const float* sharedMagnitude, const float* sharedPhase);
     void updateSpectralMorphing();
-    void applySpectralWarping();
+    void lockPhasesToPeaks (int channel);
+    void serviceSnapshotBank();
+    void applySpectralWarping (float* real, float* imag);
+
+    float calculateSpectralCentroid (const std::vector<float>& logMagnitude) const;
+    float calculateSpectralFlux (const std::vector<float>& logMagnitude, const std::vector<float>& previousLogMagnitude) const;
 
     double sampleRate = 44100.0;
     int blockSize = 512;
 
-    // FFT processing
-    std::vector<std::vector<float>> inputBuffers;
-    std::vector<std::vector<float>> outputBuffers;
-    std::vector<std::vector<std::complex<float>>> frequencyDomains;
-    std::vector<float> windowBuffer; // Window can be shared across channels
-
-    // Spectral snapshots (A and B for morphing)
-    struct SpectralSnapshot {
-        std::vector<std::vector<float>> magnitude; // magnitude[channel][bin]
-        std::vector<std::vector<float>> phase;     // phase[channel][bin]
-        float centroid = 0.0f; // Consider if per-channel centroid/flux is needed
-        float spectralFlux = 0.0f;
+    // FFT utilities
+    static constexpr int fftOrder = 11; // Corresponds to fftSize = 2048
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    juce::dsp::FFT fft { fftOrder };
+    std::array<float, fftSize> window; // Periodic Hann, used for analysis and synthesis
+    std::vector<float> expectedAdvance; // 2*pi*k*hop/N, the phase advance of a bin-centred sinusoid
+
+    // Per-channel STFT state, all sized in prepare(). Per-bin data is kept as
+    // split arrays so the frame kernels run over contiguous floats.
+    struct ChannelState
+    {
+        std::vector<float> inputFifo;          // Circular, fftSize samples
+        std::vector<float> outputAccumulator;  // Circular overlap-add buffer, fftSize samples
+        std::vector<float> fftData;            // In-place FFT workspace, fftSize * 2
+        std::vector<float> real, imag;
+        std::vector<float> magnitude;          // Own analysis, when no shared frame is available
+
+        std::vector<float> logMagnitude;       // Analysis of the latest input frame
+        std::vector<float> previousLogMagnitude; // For spectral flux at capture time
+        std::vector<float> phase;
+        std::vector<float> previousPhase;
+        std::vector<float> frequency;          // Instantaneous frequency per bin, radians per sample
+
+        std::vector<float> outputMagnitude;    // Morphed frame
+        std::vector<float> synthesisPhase;     // Accumulated output phase
+        std::vector<int> peaks;                // Scratch for phase locking
     };
 
-    std::array<SpectralSnapshot, 4> spectralSnapshots; // 4 snapshot slots
+    std::vector<ChannelState> channels;
+    int numChannels = 0;
+
+    int overlapFactor = 4;
+    int hopSize = fftSize / 4;
+    int fifoPosition = 0;     // Next write position, also the oldest sample in the FIFO
+    int hopCounter = 0;
+    float overlapAddGain = 1.0f;
+
+    // Spectral snapshots: log-magnitude, frequency (radians per sample) and phase per channel
+    SpectralSnapshotBank snapshotBank;
     int activeSourceSlot = 0;
     int activeTargetSlot = 1;
 
     // Morphing parameters
+    bool useMorphPosition = false;   // XY (four-way) rather than A/B morphing
     float morphAmount = 0.0f;        // Current morph position
     float targetMorphAmount = 0.0f;  // Target morph position
+    float morphX = 0.5f, morphY = 0.5f;
+    float targetMorphX = 0.5f, targetMorphY = 0.5f;
     float morphSpeed = 0.1f;         // Morph transition speed
     float spectralWarping = 0.0f;    // Spectral shape modification
-    float phasePreservation = 0.8f;  // How much to preserve phase
-
-    // Analysis data (consider if per-channel is needed)
-    float currentCentroid = 0.0f;
-    float currentSpectralFlux = 0.0f;
-
-    // FFT utilities
-    static constexpr int fftOrder = 11; // Corresponds to fftSize = 2048
-    static constexpr int fftSize = 1 << fftOrder;
-    static constexpr int hopSize = fftSize / 4; // Example hop size
-
-    std::vector<juce::dsp::FFT> forwardFFTs; // One FFT object per channel
+    float phasePreservation = 0.8f;  // How much to follow the input's phase motion
+    bool phaseLocking = true;
 
-    int bufferPosition = 0;
-    int windowSize = fftSize;
-    int numChannels = 0; // To store the number of channels
+    // Per-hop mix weights, derived from the smoothed morph position
+    std::array<float, numSnapshots> snapshotWeights {};
+    float inputWeight = 1.0f;
 };
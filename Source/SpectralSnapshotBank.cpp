@@ -0,0 +1,213 @@
+#include "SpectralSnapshotBank.h"
+#include <algorithm>
+#include <cstring>
+
+//==============================================================================
+void SpectralSnapshotBank::prepare (int newNumChannels, int newNumBins)
+{
+    const juce::SpinLock::ScopedLockType sl (lock);
+
+    const auto size = (size_t) numSlots * (size_t) newNumChannels * numFields * (size_t) newNumBins;
+    if (newNumChannels == numChannels && newNumBins == numBins && buffers[0].data.size() == size)
+        return;
+
+    // Carry published captures across a channel count change
+    Buffer previous = std::move (buffers[(size_t) frontIndex.load()]);
+    const int previousChannels = numChannels;
+    const bool keepPrevious = previousChannels > 0 && numBins == newNumBins;
+
+    numChannels = newNumChannels;
+    numBins = newNumBins;
+
+    for (auto& buffer : buffers)
+    {
+        buffer.data.assign (size, 0.0f);
+        buffer.slots = {};
+    }
+
+    frontIndex = 0;
+
+    if (keepPrevious)
+        copySet (previous.data.data(), previousChannels, previous.slots, buffers[0]);
+}
+
+//==============================================================================
+const float* SpectralSnapshotBank::getField (int slot, int channel, int field) const noexcept
+{
+    const auto index = (((size_t) slot * (size_t) numChannels + (size_t) channel) * numFields + (size_t) field) * (size_t) numBins;
+    return getFront().data.data() + index;
+}
+
+float* SpectralSnapshotBank::getField (int bufferIndex, int slot, int channel, int field) noexcept
+{
+    const auto index = (((size_t) slot * (size_t) numChannels + (size_t) channel) * numFields + (size_t) field) * (size_t) numBins;
+    return buffers[(size_t) bufferIndex].data.data() + index;
+}
+
+void SpectralSnapshotBank::copySet (const float* source, int sourceChannels,
+                                    const std::array<SlotInfo, numSlots>& sourceSlots, Buffer& dest) const
+{
+    const auto frameSize = (size_t) numFields * (size_t) numBins;
+
+    for (int slot = 0; slot < numSlots; ++slot)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const int sourceChannel = juce::jmin (ch, sourceChannels - 1);
+            const auto* from = source + ((size_t) slot * (size_t) sourceChannels + (size_t) sourceChannel) * frameSize;
+            auto* to = dest.data.data() + ((size_t) slot * (size_t) numChannels + (size_t) ch) * frameSize;
+            std::copy (from, from + frameSize, to);
+        }
+    }
+
+    dest.slots = sourceSlots;
+}
+
+//==============================================================================
+SpectralSnapshotBank::ScopedUpdate::ScopedUpdate (SpectralSnapshotBank& bankToUpdate)
+    : bank (bankToUpdate), lock (bankToUpdate.lock)
+{
+    if (! lock.isLocked())
+        return;
+
+    const int front = bank.frontIndex.load (std::memory_order_acquire);
+    back = 1 - front;
+
+    auto& backBuffer = bank.buffers[(size_t) back];
+
+    if ((bank.pendingWork.load (std::memory_order_acquire) & stagedLoadFlag) != 0)
+    {
+        // A loaded set replaces everything; staging was validated against numBins on load,
+        // but the bank may have been prepared again since. One that no longer fits is dropped
+        // and nothing is published, so the back buffer's stale contents never go live
+        const bool fits = bank.stagingChannels > 0
+                       && bank.staging.data.size() == (size_t) numSlots * (size_t) bank.stagingChannels * numFields * (size_t) bank.numBins;
+
+        bank.pendingWork.fetch_and (~(std::uint32_t) stagedLoadFlag, std::memory_order_acq_rel);
+
+        if (! fits)
+            return;
+
+        bank.copySet (bank.staging.data.data(), bank.stagingChannels, bank.staging.slots, backBuffer);
+    }
+    else
+    {
+        const auto& frontBuffer = bank.buffers[(size_t) front];
+        std::copy (frontBuffer.data.begin(), frontBuffer.data.end(), backBuffer.data.begin());
+        backBuffer.slots = frontBuffer.slots;
+    }
+
+    valid = true;
+}
+
+SpectralSnapshotBank::ScopedUpdate::~ScopedUpdate()
+{
+    if (valid)
+        bank.frontIndex.store (back, std::memory_order_release);
+}
+
+std::uint32_t SpectralSnapshotBank::ScopedUpdate::takeCaptureRequests() noexcept
+{
+    return bank.pendingWork.fetch_and ((std::uint32_t) stagedLoadFlag, std::memory_order_acq_rel)
+         & ((std::uint32_t) stagedLoadFlag - 1);
+}
+
+//==============================================================================
+void SpectralSnapshotBank::requestCapture (int slot) noexcept
+{
+    if (slot >= 0 && slot < numSlots)
+        pendingWork.fetch_or (1u << slot, std::memory_order_acq_rel);
+}
+
+bool SpectralSnapshotBank::writeToStream (juce::OutputStream& out)
+{
+    // The audio thread only try-locks, so writing under the lock just defers its next update
+    const juce::SpinLock::ScopedLockType sl (lock);
+    const auto& front = getFront();
+
+    Header header {};
+    std::memcpy (header.magic, "WFSN", 4);
+    header.version = formatVersion;
+    header.numSlots = (std::uint32_t) numSlots;
+    header.numChannels = (std::uint32_t) numChannels;
+    header.numBins = (std::uint32_t) numBins;
+
+    std::array<float, numSlots * 2> descriptors;
+    for (int slot = 0; slot < numSlots; ++slot)
+    {
+        header.capturedMask |= front.slots[(size_t) slot].captured ? (1u << slot) : 0u;
+        descriptors[(size_t) slot * 2]     = front.slots[(size_t) slot].centroid;
+        descriptors[(size_t) slot * 2 + 1] = front.slots[(size_t) slot].spectralFlux;
+    }
+
+    if (header.capturedMask == 0 || front.data.empty())
+        return false;
+
+    return out.write (&header, sizeof (header))
+        && out.write (descriptors.data(), sizeof (descriptors))
+        && out.write (front.data.data(), front.data.size() * sizeof (float));
+}
+
+bool SpectralSnapshotBank::loadFromData (const void* data, size_t dataSize)
+{
+    constexpr auto descriptorBytes = numSlots * 2 * sizeof (float);
+    if (data == nullptr || dataSize < sizeof (Header) + descriptorBytes)
+        return false;
+
+    Header header;
+    std::memcpy (&header, data, sizeof (Header));
+
+    if (std::memcmp (header.magic, "WFSN", 4) != 0
+        || header.version != formatVersion
+        || header.numSlots != (std::uint32_t) numSlots
+        || header.numChannels == 0 || header.numChannels > 64
+        || header.numBins == 0 || header.numBins > 65537)
+        return false;
+
+    const auto count = (size_t) numSlots * header.numChannels * numFields * header.numBins;
+    if (dataSize < sizeof (Header) + descriptorBytes + count * sizeof (float))
+        return false;
+
+    // State data carries no alignment guarantee, so both parts are copied out bytewise
+    const auto* bytes = static_cast<const char*> (data);
+    std::array<float, numSlots * 2> descriptors;
+    std::memcpy (descriptors.data(), bytes + sizeof (Header), descriptorBytes);
+
+    // Build the staging copy off the lock; the old one is freed when this goes out of scope
+    Buffer loaded;
+    loaded.data.resize (count);
+    std::memcpy (loaded.data.data(), bytes + sizeof (Header) + descriptorBytes, count * sizeof (float));
+
+    for (int slot = 0; slot < numSlots; ++slot)
+    {
+        loaded.slots[(size_t) slot].captured = (header.capturedMask & (1u << slot)) != 0;
+        loaded.slots[(size_t) slot].centroid = descriptors[(size_t) slot * 2];
+        loaded.slots[(size_t) slot].spectralFlux = descriptors[(size_t) slot * 2 + 1];
+    }
+
+    {
+        const juce::SpinLock::ScopedLockType sl (lock);
+
+        if (numBins != 0 && header.numBins != (std::uint32_t) numBins)
+            return false;
+
+        // Not prepared yet: publish directly, nothing is reading
+        if (numChannels == 0)
+        {
+            numChannels = (int) header.numChannels;
+            numBins = (int) header.numBins;
+            buffers[0].data = loaded.data;
+            buffers[0].slots = loaded.slots;
+            buffers[1].data.assign (count, 0.0f);
+            frontIndex = 0;
+        }
+        else
+        {
+            std::swap (staging, loaded);
+            stagingChannels = (int) header.numChannels;
+            pendingWork.fetch_or ((std::uint32_t) stagedLoadFlag, std::memory_order_acq_rel);
+        }
+    }
+
+    return true;
+}
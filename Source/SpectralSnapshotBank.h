@@ -0,0 +1,145 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+//==============================================================================
+/**
+    SpectralSnapshotBank - Double-buffered snapshot storage for spectral morphing
+
+    Holds numSlots captured STFT frames (log-magnitude, instantaneous frequency
+    and phase for every channel and bin). Two copies of the set exist: the audio
+    thread reads the front one without locking and all writes go to the back
+    one, which is then published by flipping an atomic index.
+
+    Only the audio thread ever writes. Other threads request captures through
+    an atomic bit mask and hand over loaded sets through a staging buffer; the
+    audio thread applies both at the next hop inside a ScopedUpdate, which only
+    try-locks, so a save in progress simply defers the update by one hop.
+
+    Serialised layout (native-endian float32, stored in plugin state):
+        Header      (32 bytes) - magic, version, slots, channels, bins, captured mask
+        Descriptors (numSlots * 2 floats) - centroid and flux per slot
+        Frames      ([slot][channel][logMagnitude | frequency | phase][bin] floats)
+*/
+class SpectralSnapshotBank
+{
+public:
+    static constexpr int numSlots = 4;
+
+    struct SlotInfo
+    {
+        bool captured = false;
+        float centroid = 0.0f;
+        float spectralFlux = 0.0f;
+    };
+
+    SpectralSnapshotBank() = default;
+
+    /** Sizes both buffers. Not real-time safe; applies any set loaded before preparation. */
+    void prepare (int numChannels, int numBins);
+
+    //==============================================================================
+    // Audio thread: reads from the published set
+    const float* getLogMagnitude (int slot, int channel) const noexcept { return getField (slot, channel, 0); }
+    const float* getFrequency (int slot, int channel) const noexcept    { return getField (slot, channel, 1); }
+    const float* getPhase (int slot, int channel) const noexcept        { return getField (slot, channel, 2); }
+    const SlotInfo& getSlotInfo (int slot) const noexcept               { return getFront().slots[(size_t) slot]; }
+
+    /** True when a capture or a loaded set is waiting for the audio thread. A single atomic check. */
+    bool hasPendingWork() const noexcept { return pendingWork.load (std::memory_order_acquire) != 0; }
+
+    /**
+        Audio thread only. Prepares the back buffer (a copy of the front, or a staged
+        load) and publishes it on destruction. isValid() is false if a save holds the
+        lock, in which case nothing changes and the work stays pending, or if a staged
+        load turns out not to fit the bank, in which case it is dropped and the
+        published set is left as it was.
+    */
+    class ScopedUpdate
+    {
+    public:
+        explicit ScopedUpdate (SpectralSnapshotBank& bankToUpdate);
+        ~ScopedUpdate();
+
+        bool isValid() const noexcept { return valid; }
+
+        /** Returns and clears the slots whose capture was requested. */
+        std::uint32_t takeCaptureRequests() noexcept;
+
+        float* getLogMagnitude (int slot, int channel) noexcept { return bank.getField (back, slot, channel, 0); }
+        float* getFrequency (int slot, int channel) noexcept    { return bank.getField (back, slot, channel, 1); }
+        float* getPhase (int slot, int channel) noexcept        { return bank.getField (back, slot, channel, 2); }
+        SlotInfo& getSlotInfo (int slot) noexcept               { return bank.buffers[(size_t) back].slots[(size_t) slot]; }
+
+    private:
+        SpectralSnapshotBank& bank;
+        juce::SpinLock::ScopedTryLockType lock;
+        int back = 0;
+        bool valid = false;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedUpdate)
+    };
+
+    //==============================================================================
+    // Any thread
+    /** Asks the audio thread to capture its next analysed frame into a slot. */
+    void requestCapture (int slot) noexcept;
+
+    /** Writes the published set to a stream. Returns false, writing nothing, if no slot
+        has been captured. Never call this from the audio thread. */
+    bool writeToStream (juce::OutputStream& out);
+
+    /** Reads a set written by writeToStream() and stages it for the audio thread. */
+    bool loadFromData (const void* data, size_t dataSize);
+
+private:
+    struct Buffer
+    {
+        std::vector<float> data; // [slot][channel][field][bin]
+        std::array<SlotInfo, numSlots> slots;
+    };
+
+    struct Header
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t numSlots;
+        std::uint32_t numChannels;
+        std::uint32_t numBins;
+        std::uint32_t capturedMask;
+        std::uint32_t reserved[2];
+    };
+
+    static_assert (sizeof (Header) == 32, "Header must stay 32 bytes, the size earlier states were written with");
+    static constexpr std::uint32_t formatVersion = 1;
+    static constexpr int numFields = 3;
+
+    enum PendingWork : std::uint32_t
+    {
+        stagedLoadFlag = 1u << numSlots // Bits below this are capture requests per slot
+    };
+
+    const Buffer& getFront() const noexcept { return buffers[(size_t) frontIndex.load (std::memory_order_acquire)]; }
+    const float* getField (int slot, int channel, int field) const noexcept;
+    float* getField (int bufferIndex, int slot, int channel, int field) noexcept;
+
+    /** Copies a set with sourceChannels channels into dest, reusing the last channel if dest has more. */
+    void copySet (const float* source, int sourceChannels, const std::array<SlotInfo, numSlots>& sourceSlots, Buffer& dest) const;
+
+    std::array<Buffer, 2> buffers;
+    std::atomic<int> frontIndex { 0 };
+    int numChannels = 0;
+    int numBins = 0;
+
+    Buffer staging;
+    int stagingChannels = 0;
+
+    std::atomic<std::uint32_t> pendingWork { 0 };
+    juce::SpinLock lock; // Held by savers/loaders; the audio thread only try-locks
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectralSnapshotBank)
+};
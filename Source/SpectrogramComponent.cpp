@@ -1,9 +1,12 @@
 #include "SpectrogramComponent.h"
+#include <algorithm>
 #include <cmath>
 
 //==============================================================================
 SpectrogramComponent::SpectrogramComponent()
 {
+    setOpaque(true);
+    updateColourTable();
     updateBuffers();
     startTimerHz(updateRateHz);
 }
@@ -21,7 +24,7 @@ void SpectrogramComponent::paint (juce::Graphics& g)
     // Fill background
     g.fillAll(juce::Colours::black);
 
-    if (!enabled || magnitudeHistory.empty() || magnitudeHistory[0].empty())
+    if (!enabled || !hasData || !historyImage.isValid())
     {
         // Draw placeholder text
         g.setColour(juce::Colours::white.withAlpha(0.5f));
@@ -31,66 +34,18 @@ void SpectrogramComponent::paint (juce::Graphics& g)
         return;
     }
 
-    // Find maximum magnitude in history for normalization
-    float maxMagnitude = 0.0f;
-    for (const auto& freqSlice : magnitudeHistory)
-        for (float mag : freqSlice)
-            maxMagnitude = std::max(maxMagnitude, mag);
-
-    if (maxMagnitude <= 0.0f)
-        maxMagnitude = 1.0f; // Avoid division by zero
-
-    // Draw spectrogram
     int width = bounds.getWidth();
     int height = bounds.getHeight();
 
-    int freqBins = magnitudeHistory.size();
-    int timeSlices = magnitudeHistory[0].size();
-
-    if (timeSlices == 0 || freqBins == 0)
-        return;
-
-    // Calculate logarithmic frequency mapping
-    auto freqToY = [this, height](float frequency) -> int {
-        if (frequency <= minFrequency)
-            return height - 1;
-
-        // Logarithmic mapping from minFrequency to maxFrequency
-        float logMin = std::log10(minFrequency);
-        float logMax = std::log10(maxFrequency);
-        float logFreq = std::log10(frequency);
-
-        float normalizedY = 1.0f - (logFreq - logMin) / (logMax - logMin);
-        return juce::jlimit(0, height - 1, (int)(normalizedY * height));
-    };
-
-    // Draw each column (time slice)
-    for (int timeIndex = 0; timeIndex < timeSlices; ++timeIndex)
-    {
-        int x = timeIndex * width / timeSlices;
-
-        for (int freqIndex = 0; freqIndex < freqBins; ++freqIndex)
-        {
-            float magnitude = magnitudeHistory[freqIndex][timeIndex];
-            float freq = binToFreq(freqIndex);
-
-            // Skip frequencies outside our range
-            if (freq < minFrequency || freq > maxFrequency)
-                continue;
-
-            juce::Colour colour = getColourFromMagnitude(magnitude, maxMagnitude);
-
-            int yStart = freqToY(freq);
-            int yEnd = freqToY(binToFreq(freqIndex + 1));
+    // Blit the ring oldest first: [writeColumn, end) on the left, then [0, writeColumn)
+    const int olderColumns = historyLength - writeColumn;
+    const int splitX = olderColumns * width / historyLength;
 
-            // Ensure minimum pixel height for visibility
-            int pixelHeight = std::max(1, yEnd - yStart);
-            g.setColour(colour);
+    g.setImageResamplingQuality(juce::Graphics::lowResamplingQuality);
+    g.drawImage(historyImage, 0, 0, splitX, height, writeColumn, 0, olderColumns, historyImage.getHeight());
 
-            // Draw vertical line for this frequency bin
-            g.fillRect(x, yStart, 1, pixelHeight);
-        }
-    }
+    if (writeColumn > 0)
+        g.drawImage(historyImage, splitX, 0, width - splitX, height, 0, 0, writeColumn, historyImage.getHeight());
 
     // Draw frequency labels
     g.setColour(juce::Colours::white.withAlpha(0.8f));
@@ -102,7 +57,7 @@ void SpectrogramComponent::paint (juce::Graphics& g)
         float freq = std::pow(2.0f, octave) * 16.0f / 16.0f; // Start from 16Hz
         if (freq >= minFrequency && freq <= maxFrequency)
         {
-            int y = freqToY(freq);
+            int y = freqToY(freq, height);
             g.drawLine(0, y, width, y, 1.0f);
 
             juce::String label;
@@ -117,7 +72,6 @@ void SpectrogramComponent::paint (juce::Graphics& g)
     }
 
     // Draw time markers
-    float timePerSlice = timeWindow / timeSlices;
     g.setFont(9.0f);
     for (int marker = 0; marker <= 4; ++marker)
     {
@@ -130,42 +84,81 @@ void SpectrogramComponent::paint (juce::Graphics& g)
     }
 }
 
+void SpectrogramComponent::resized()
+{
+    updateBuffers();
+}
+
 //==============================================================================
 void SpectrogramComponent::pushSpectrumData(const float* magnitudeData, int size, double sampleRate)
 {
-    if (!enabled || magnitudeData == nullptr || size <= 0)
+    if (!enabled || magnitudeData == nullptr || size <= 0 || !historyImage.isValid())
         return;
 
-    currentSampleRate = sampleRate;
-
-    // Resize our history buffer if spectrum size changed
-    if (spectrumSize != size)
+    // Evenly spaced bins: rebuild the frequency table only when the layout changes
+    if (!evenlySpacedBins || spectrumSize != size || currentSampleRate != sampleRate)
     {
         spectrumSize = size;
-        updateBuffers();
+        currentSampleRate = sampleRate;
+        evenlySpacedBins = true;
+
+        binFrequencies.resize((size_t) size);
+        for (int bin = 0; bin < size; ++bin)
+            binFrequencies[(size_t) bin] = (float) (bin * sampleRate / (2.0 * size));
+
+        updateRowMap();
     }
 
-    // Shift existing data to the left (older data)
-    for (auto& freqSlice : magnitudeHistory)
+    drawColumn(magnitudeData);
+}
+
+void SpectrogramComponent::pushSpectrumData(const float* magnitudeData, const float* frequencies, int size)
+{
+    if (!enabled || magnitudeData == nullptr || frequencies == nullptr || size <= 0 || !historyImage.isValid())
+        return;
+
+    // The row map depends only on where the bins are, which rarely changes between frames
+    if ((int) binFrequencies.size() != size || !std::equal(frequencies, frequencies + size, binFrequencies.begin()))
     {
-        if (!freqSlice.empty())
-        {
-            for (size_t i = 0; i < freqSlice.size() - 1; ++i)
-                freqSlice[i] = freqSlice[i + 1];
-        }
+        spectrumSize = size;
+        evenlySpacedBins = false;
+        binFrequencies.assign(frequencies, frequencies + size);
+        updateRowMap();
     }
 
-    // Add new data to the end
-    for (int i = 0; i < size; ++i)
+    drawColumn(magnitudeData);
+}
+
+void SpectrogramComponent::drawColumn(const float* magnitudeData)
+{
+    // Write one column: the loudest bin feeding each row, mapped through the colour table
+    const float decibelsToIndex = 255.0f / -floorDecibels;
+    const int rows = historyImage.getHeight();
+
+    juce::Image::BitmapData column(historyImage, writeColumn, 0, 1, rows, juce::Image::BitmapData::writeOnly);
+
+    for (int y = 0; y < rows; ++y)
     {
-        if (i < (int)magnitudeHistory.size())
+        const int start = rowBinStart[(size_t) y];
+        const int end = rowBinEnd[(size_t) y];
+
+        float peak = 0.0f;
+        for (int bin = start; bin < end; ++bin)
+            peak = std::max(peak, magnitudeData[bin]);
+
+        int index = 0;
+        if (peak > 0.0f)
         {
-            if (!magnitudeHistory[i].empty())
-                magnitudeHistory[i].back() = magnitudeData[i];
+            const float decibels = 20.0f * std::log10(peak);
+            index = juce::jlimit(0, 255, (int) ((decibels - floorDecibels) * decibelsToIndex));
         }
+
+        column.setPixelColour(0, y, colourTable[(size_t) index]);
     }
 
-    // Repaint will be handled by the timer callback
+    writeColumn = (writeColumn + 1) % historyLength;
+    hasData = true;
+    needsRepaint = true;
 }
 
 //==============================================================================
@@ -179,17 +172,20 @@ void SpectrogramComponent::setFreqRange(float minFreq, float maxFreq)
 {
     minFrequency = juce::jmax(10.0f, minFreq);
     maxFrequency = juce::jmin(22000.0f, juce::jmax(minFrequency + 100.0f, maxFreq));
+    updateRowMap();
 }
 
 void SpectrogramComponent::setColourMap(int mapType)
 {
     colourMap = juce::jlimit(0, 2, mapType);
+    updateColourTable();
 }
 
 void SpectrogramComponent::setUpdateRateHz(int rate)
 {
     updateRateHz = juce::jlimit(5, 60, rate);
-    startTimer(1000 / 60); // 60 FPS refresh rate
+    startTimerHz(updateRateHz);
+    updateBuffers();
 }
 
 void SpectrogramComponent::setEnabled(bool shouldBeEnabled)
@@ -200,22 +196,92 @@ void SpectrogramComponent::setEnabled(bool shouldBeEnabled)
 //==============================================================================
 void SpectrogramComponent::timerCallback()
 {
-    repaint();
+    // Only repaint when a column has been added since the last frame
+    if (needsRepaint)
+    {
+        needsRepaint = false;
+        repaint();
+    }
 }
 
 void SpectrogramComponent::updateBuffers()
 {
-    if (spectrumSize <= 0)
-        return;
-
     // Calculate history length based on time window and update rate
     historyLength = juce::jmax(32, (int)(timeWindow * updateRateHz));
 
-    // Resize the magnitude history buffer
-    magnitudeHistory.resize(spectrumSize);
+    // One image row per pixel of height; columns are stretched to the width when blitting
+    const int rows = getHeight();
+    if (rows <= 0)
+    {
+        historyImage = {};
+        return;
+    }
+
+    if (historyImage.getWidth() != historyLength || historyImage.getHeight() != rows)
+    {
+        historyImage = juce::Image(juce::Image::RGB, historyLength, rows, true);
+        writeColumn = 0;
+        hasData = false;
+    }
 
-    for (auto& freqSlice : magnitudeHistory)
-        freqSlice.resize(historyLength, 0.0f);
+    updateRowMap();
+}
+
+void SpectrogramComponent::updateRowMap()
+{
+    const int rows = historyImage.getHeight();
+    rowBinStart.assign((size_t) juce::jmax(0, rows), 0);
+    rowBinEnd.assign((size_t) juce::jmax(0, rows), 0);
+
+    if (binFrequencies.empty())
+        return;
+
+    const float logMin = std::log(minFrequency);
+    const float logRange = std::log(maxFrequency) - logMin;
+
+    const auto first = binFrequencies.begin();
+    const auto last = binFrequencies.end();
+    const int numFrequencies = (int) binFrequencies.size();
+
+    // Rows past the top bin stay black, allowing for half a bin spacing above it
+    const float spacing = numFrequencies > 1 ? binFrequencies.back() - binFrequencies[binFrequencies.size() - 2] : 0.0f;
+    const float highestFrequency = binFrequencies.back() + 0.5f * spacing;
+
+    for (int y = 0; y < rows; ++y)
+    {
+        // Row y covers the frequencies between its bottom and top edges
+        const float topFreq = std::exp(logMin + logRange * (1.0f - (float) y / rows));
+        const float bottomFreq = std::exp(logMin + logRange * (1.0f - (float) (y + 1) / rows));
+
+        int start = (int) (std::lower_bound(first, last, bottomFreq) - first);
+        int end = (int) (std::lower_bound(first, last, topFreq) - first);
+
+        // Rows narrower than a bin take the nearest one, so sparse bins repeat instead of leaving gaps
+        if (end <= start)
+        {
+            const float centreFreq = std::sqrt(bottomFreq * topFreq);
+            if (centreFreq > highestFrequency)
+                continue;
+
+            start = juce::jlimit(0, numFrequencies - 1, start);
+            if (start > 0 && centreFreq - binFrequencies[(size_t) start - 1] < binFrequencies[(size_t) start] - centreFreq)
+                --start;
+
+            end = start + 1;
+        }
+
+        rowBinStart[(size_t) y] = start;
+        rowBinEnd[(size_t) y] = end;
+    }
+}
+
+void SpectrogramComponent::updateColourTable()
+{
+    for (int i = 0; i < (int) colourTable.size(); ++i)
+        colourTable[(size_t) i] = getColourFromMagnitude((float) i / 255.0f, 1.0f);
+
+    // Silence stays black whatever the map
+    colourTable[0] = juce::Colours::black;
 }
 
 //==============================================================================
@@ -243,14 +309,16 @@ juce::Colour SpectrogramComponent::getColourFromMagnitude(float magnitude, float
 }
 
 //==============================================================================
-float SpectrogramComponent::freqToBin(float frequency) const
+int SpectrogramComponent::freqToY(float frequency, int height) const
 {
-    // Convert frequency to FFT bin index
-    return frequency * spectrumSize / currentSampleRate;
-}
+    if (frequency <= minFrequency)
+        return height - 1;
 
-float SpectrogramComponent::binToFreq(int bin) const
-{
-    // Convert FFT bin index to frequency
-    return (float)bin * currentSampleRate / spectrumSize;
+    // Logarithmic mapping from minFrequency to maxFrequency
+    float logMin = std::log10(minFrequency);
+    float logMax = std::log10(maxFrequency);
+    float logFreq = std::log10(frequency);
+
+    float normalizedY = 1.0f - (logFreq - logMin) / (logMax - logMin);
+    return juce::jlimit(0, height - 1, (int)(normalizedY * height));
 }
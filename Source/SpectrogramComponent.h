@@ -1,6 +1,7 @@
 #pragma once
 
 #include <juce_gui_basics/juce_gui_basics.h>
+#include <array>
 #include <vector>
 
 //==============================================================================
@@ -12,6 +13,14 @@
     - Logarithmic frequency scaling and magnitude color mapping
     - Configurable display settings (time window, frequency range)
     - Optimized for real-time performance with audio plugins
+
+    History is kept in an image used as a ring buffer: each pushed frame writes
+    one column at the write position, using a precomputed row-to-bin range map
+    for the log frequency axis and a 256-entry colour table indexed by level in
+    dB. The map is built from the frequency of every bin, so evenly spaced FFT
+    frames and constant-Q frames from the bass analyser draw the same way.
+    paint() only blits the two halves of the ring (oldest first) and draws the
+    labels, so its cost does not grow with the number of bins.
 */
 class SpectrogramComponent : public juce::Component,
                            private juce::Timer
@@ -22,10 +31,14 @@ public:
 
     //==============================================================================
     void paint (juce::Graphics&) override;
+    void resized() override;
 
     //==============================================================================
     // Data input methods
+    // size bins spanning DC up to the Nyquist frequency of sampleRate
     void pushSpectrumData(const float* magnitudeData, int size, double sampleRate);
+    // size bins at arbitrary ascending frequencies in Hz (e.g. the multirate bass analyser)
+    void pushSpectrumData(const float* magnitudeData, const float* binFrequencies, int size);
 
     // Display configuration
     void setTimeWindow(float seconds);
@@ -42,6 +55,9 @@ private:
     //==============================================================================
     void timerCallback() override;
     void updateBuffers();
+    void updateRowMap();
+    void drawColumn(const float* magnitudeData);
+    void updateColourTable();
 
     //==============================================================================
     // Display parameters
@@ -49,26 +65,38 @@ private:
     float minFrequency = 20.0f;   // Minimum frequency to display
     float maxFrequency = 20000.0f; // Maximum frequency to display
     int colourMap = 0;            // 0=Viridis, 1=Plasma, 2=Hot
+    float floorDecibels = -90.0f; // Level drawn as the bottom of the colour map (0 dB is the top)
 
     // Performance settings
-    int updateRateHz = 30;        // Update rate for visualization
+    int updateRateHz = 60;        // Columns per second the history is sized for, and repaint rate
     bool enabled = true;
 
     // Data storage
-    int spectrumSize = 512;       // FFT size
+    int spectrumSize = 512;       // Number of bins per pushed frame
     int historyLength = 128;      // Number of time frames to store
     double currentSampleRate = 44100.0;
 
-    // Spectral history buffer [frequency][time]
-    std::vector<std::vector<float>> magnitudeHistory;
+    // Spectral history: one column per frame, written at writeColumn and wrapping around
+    juce::Image historyImage;
+    int writeColumn = 0;
+    bool hasData = false;
+    bool needsRepaint = false;
+
+    // Centre frequency of every bin of the pushed frames, ascending
+    std::vector<float> binFrequencies;
+    bool evenlySpacedBins = false; // Table was generated from a size and sample rate
+
+    // Bins [rowBinStart[y], rowBinEnd[y]) feed image row y (top row = highest frequency);
+    // an empty range leaves the row black
+    std::vector<int> rowBinStart, rowBinEnd;
 
     //==============================================================================
     // Colour mapping
+    std::array<juce::Colour, 256> colourTable;
     juce::Colour getColourFromMagnitude(float magnitude, float maxMagnitude);
 
     // Helpers
-    float freqToBin(float frequency) const;
-    float binToFreq(int bin) const;
+    int freqToY(float frequency, int height) const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrogramComponent)
 };
@@ -0,0 +1,328 @@
+#include "SpectrumAnalyzerTap.h"
+#include <algorithm>
+#include <cmath>
+
+//==============================================================================
+void SpectrumAnalyzerTap::TripleBuffer::publish() noexcept
+{
+    // Hand the finished frame over as the middle one and take back whatever was there
+    writeIndex = state.exchange (writeIndex | freshFlag, std::memory_order_acq_rel) & 3;
+}
+
+bool SpectrumAnalyzerTap::TripleBuffer::acquireLatest() noexcept
+{
+    if ((state.load (std::memory_order_acquire) & freshFlag) == 0)
+        return false;
+
+    readIndex = state.exchange (readIndex, std::memory_order_acq_rel) & 3;
+    return true;
+}
+
+//==============================================================================
+SpectrumAnalyzerTap::SpectrumAnalyzerTap()
+{
+    // Coherent gain of each window, doubled for the one-sided spectrum
+    auto getScale = [] (juce::dsp::WindowingFunction<float>& w, int size)
+    {
+        std::vector<float> ones ((size_t) size, 1.0f);
+        w.multiplyWithWindowingTable (ones.data(), (size_t) size);
+
+        float windowSum = 0.0f;
+        for (auto value : ones)
+            windowSum += value;
+
+        return 2.0f / windowSum;
+    };
+
+    magnitudeScale = getScale (window, fftSize);
+    bassMagnitudeScale = getScale (bassWindow, bassFFTSize);
+
+    // Blackman-windowed sinc at a quarter of the stage rate: flat over the octave the next
+    // stage displays, and everything that would alias into that octave is in the stopband
+    constexpr int centre = decimationTaps / 2;
+    float sum = 0.0f;
+
+    for (int n = 0; n < decimationTaps; ++n)
+    {
+        const float x = (float) (n - centre) * 0.5f;
+        const float sinc = n == centre ? 1.0f : std::sin (juce::MathConstants<float>::pi * x) / (juce::MathConstants<float>::pi * x);
+        const float phase = juce::MathConstants<float>::twoPi * (float) n / (float) (decimationTaps - 1);
+        const float blackman = 0.42f - 0.5f * std::cos (phase) + 0.08f * std::cos (2.0f * phase);
+
+        decimationFilter[(size_t) n] = sinc * blackman;
+        sum += decimationFilter[(size_t) n];
+    }
+
+    for (auto& coefficient : decimationFilter)
+        coefficient /= sum;
+}
+
+void SpectrumAnalyzerTap::prepare (double sampleRate, int maxBlockSize)
+{
+    const juce::ScopedLock sl (analysisLock);
+
+    decimation = juce::jmax (1, (int) (sampleRate / 44100.0));
+    analysisSampleRate = sampleRate / decimation;
+
+    // Room for a few hops plus a block, so the analysis thread can run at UI rate
+    const int capacity = (int) juce::nextPowerOfTwo (hopSize * 8 + maxBlockSize / decimation + 1);
+    fifoBuffer.assign ((size_t) capacity, 0.0f);
+    fifo.setTotalSize (capacity);
+
+    decimationSum = 0.0f;
+    decimationCount = 0;
+
+    // Bass frame layout: the lowest stage first so frequencies ascend
+    bassFrameSize = 0;
+    for (int stage = numBassStages - 1; stage >= 0; --stage)
+    {
+        const double binWidth = analysisSampleRate / (double) (1 << stage) / bassFFTSize;
+
+        for (int bin = getFirstBin (stage); bin < getEndBin (stage); ++bin)
+            bassFrequencies[(size_t) bassFrameSize++] = (float) (bin * binWidth);
+    }
+
+    resetAnalysis();
+}
+
+void SpectrumAnalyzerTap::resetAnalysis() noexcept
+{
+    history.fill (0.0f);
+    historyPosition = 0;
+    samplesSinceHop = 0;
+
+    for (auto& stage : bassStages)
+        stage = {};
+}
+
+//==============================================================================
+void SpectrumAnalyzerTap::push (const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    if (! active.load (std::memory_order_relaxed))
+        return;
+
+    const int numChannels = (int) block.getNumChannels();
+    const int numSamples = (int) block.getNumSamples();
+    if (numChannels == 0 || fifoBuffer.empty())
+        return;
+
+    const float channelGain = 1.0f / (float) (numChannels * decimation);
+
+    // Box filter and decimate straight into the FIFO; whatever does not fit is dropped
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite ((numSamples + decimationCount) / decimation, start1, size1, start2, size2);
+
+    int written = 0;
+    const int capacity = size1 + size2;
+
+    for (int i = 0; i < numSamples && written < capacity; ++i)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            decimationSum += block.getSample (ch, i);
+
+        if (++decimationCount == decimation)
+        {
+            const int index = written < size1 ? start1 + written : start2 + (written - size1);
+            fifoBuffer[(size_t) index] = decimationSum * channelGain;
+            decimationSum = 0.0f;
+            decimationCount = 0;
+            ++written;
+        }
+    }
+
+    fifo.finishedWrite (written);
+}
+
+//==============================================================================
+int SpectrumAnalyzerTap::useTimeSlice()
+{
+    // Nothing to do while no editor is watching; check back at a relaxed rate
+    if (! isActive())
+        return 100;
+
+    const juce::ScopedTryLock sl (analysisLock);
+    if (! sl.isLocked())
+        return 10;
+
+    // Start a resolution change from silence rather than from the other mode's stale state
+    if (const auto requested = requestedResolution.load(); requested != resolution)
+    {
+        resolution = requested;
+        resetAnalysis();
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+    bool hopCompleted = false;
+
+    for (const auto [start, size] : { std::pair<int, int> { start1, size1 }, std::pair<int, int> { start2, size2 } })
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            const float sample = fifoBuffer[(size_t) (start + i)];
+
+            if (resolution == Resolution::bass)
+            {
+                pushBassSample (0, sample);
+                continue;
+            }
+
+            history[(size_t) historyPosition] = sample;
+            historyPosition = (historyPosition + 1) & (fftSize - 1);
+
+            if (++samplesSinceHop == hopSize)
+            {
+                samplesSinceHop = 0;
+                hopCompleted = true;
+            }
+        }
+    }
+
+    fifo.finishedRead (size1 + size2);
+
+    // Several hops may have completed since the last slice; only the newest one is ever shown
+    if (resolution == Resolution::bass)
+    {
+        for (auto& stage : bassStages)
+        {
+            if (stage.hopPending)
+            {
+                analyseBassStage (stage);
+                hopCompleted = true;
+            }
+        }
+
+        if (hopCompleted)
+            publishBassFrame();
+    }
+    else if (hopCompleted)
+    {
+        analyseFrame();
+    }
+
+    // Roughly one hop at the analysis rate, but never slower than the UI refresh
+    return juce::jlimit (5, 30, (int) (1000.0 * hopSize / getAnalysisSampleRate()));
+}
+
+void SpectrumAnalyzerTap::analyseFrame() noexcept
+{
+    // Unroll the circular history, oldest sample first
+    const int tail = fftSize - historyPosition;
+    std::copy (history.begin() + historyPosition, history.end(), fftData.begin());
+    std::copy (history.begin(), history.begin() + historyPosition, fftData.begin() + tail);
+
+    window.multiplyWithWindowingTable (fftData.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform (fftData.data(), true);
+
+    auto& frame = frames.getWriteFrame();
+    const float binWidth = (float) (getAnalysisSampleRate() / fftSize);
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        frame.magnitudes[(size_t) bin] = fftData[(size_t) bin] * magnitudeScale;
+        frame.frequencies[(size_t) bin] = (float) bin * binWidth;
+    }
+
+    frame.size = numBins;
+    frames.publish();
+}
+
+//==============================================================================
+void SpectrumAnalyzerTap::pushBassSample (int stageIndex, float sample) noexcept
+{
+    auto& stage = bassStages[(size_t) stageIndex];
+
+    stage.history[(size_t) stage.position] = sample;
+    stage.position = (stage.position + 1) & (bassFFTSize - 1);
+
+    if (++stage.samplesSinceHop == bassHopSize)
+    {
+        stage.samplesSinceHop = 0;
+        stage.hopPending = true;
+    }
+
+    if (stageIndex == numBassStages - 1)
+        return;
+
+    // Lowpass and keep every second output for the next octave down
+    stage.delayLine[(size_t) stage.delayPosition] = sample;
+    stage.delayLine[(size_t) (stage.delayPosition + decimationTaps)] = sample;
+    stage.delayPosition = stage.delayPosition + 1 == decimationTaps ? 0 : stage.delayPosition + 1;
+
+    stage.skipNextOutput = ! stage.skipNextOutput;
+    if (! stage.skipNextOutput)
+        return;
+
+    // The filter is symmetric, so running it oldest-first gives the same result
+    const auto* taps = stage.delayLine.data() + stage.delayPosition;
+    float filtered = 0.0f;
+
+    for (int n = 0; n < decimationTaps; ++n)
+        filtered += taps[n] * decimationFilter[(size_t) n];
+
+    pushBassSample (stageIndex + 1, filtered);
+}
+
+void SpectrumAnalyzerTap::analyseBassStage (BassStage& stage) noexcept
+{
+    stage.hopPending = false;
+
+    const int tail = bassFFTSize - stage.position;
+    std::copy (stage.history.begin() + stage.position, stage.history.end(), fftData.begin());
+    std::copy (stage.history.begin(), stage.history.begin() + stage.position, fftData.begin() + tail);
+
+    bassWindow.multiplyWithWindowingTable (fftData.data(), (size_t) bassFFTSize);
+    bassFFT.performFrequencyOnlyForwardTransform (fftData.data(), true);
+
+    for (size_t bin = 0; bin < stage.magnitudes.size(); ++bin)
+        stage.magnitudes[bin] = fftData[bin] * bassMagnitudeScale;
+}
+
+void SpectrumAnalyzerTap::publishBassFrame() noexcept
+{
+    auto& frame = frames.getWriteFrame();
+    int index = 0;
+
+    for (int stage = numBassStages - 1; stage >= 0; --stage)
+    {
+        const auto& magnitudes = bassStages[(size_t) stage].magnitudes;
+
+        for (int bin = getFirstBin (stage); bin < getEndBin (stage); ++bin)
+            frame.magnitudes[(size_t) index++] = magnitudes[(size_t) bin];
+    }
+
+    std::copy (bassFrequencies.begin(), bassFrequencies.begin() + bassFrameSize, frame.frequencies.begin());
+    frame.size = bassFrameSize;
+    frames.publish();
+}
+
+//==============================================================================
+bool SpectrumAnalyzerTap::readLatestFrame (float* magnitudes, int maxSize) const
+{
+    if (magnitudes == nullptr || maxSize <= 0)
+        return false;
+
+    const bool isNew = frames.acquireLatest();
+    const auto& latest = frames.getReadFrame();
+
+    const int count = juce::jmin (maxSize, latest.size);
+    std::copy (latest.magnitudes.begin(), latest.magnitudes.begin() + count, magnitudes);
+    std::fill (magnitudes + count, magnitudes + maxSize, 0.0f);
+
+    return isNew;
+}
+
+int SpectrumAnalyzerTap::readLatestFrame (float* magnitudes, float* binFrequencies, int maxSize) const
+{
+    if (magnitudes == nullptr || binFrequencies == nullptr || maxSize <= 0 || ! frames.acquireLatest())
+        return 0;
+
+    const auto& latest = frames.getReadFrame();
+    const int count = juce::jmin (maxSize, latest.size);
+
+    std::copy (latest.magnitudes.begin(), latest.magnitudes.begin() + count, magnitudes);
+    std::copy (latest.frequencies.begin(), latest.frequencies.begin() + count, binFrequencies);
+
+    return count;
+}
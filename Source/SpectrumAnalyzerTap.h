@@ -0,0 +1,192 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/**
+    SpectrumAnalyzerTap - Wait-free handoff of a signal point from the audio thread to the UI
+
+    The audio thread only ever calls push(). While the tap is inactive (no editor
+    open) that is a single relaxed atomic load. While active, the block is summed
+    to mono, decimated to roughly 44.1 kHz with a box filter and written to a
+    single-producer/single-consumer FIFO - no FFT, window or magnitude work ever
+    runs inside processBlock.
+
+    The analysis runs on a background TimeSliceThread owned by the processor. It
+    drains the FIFO, transforms the newest samples once per hop and publishes the
+    magnitudes through a triple buffer, so the message thread always reads a
+    complete frame without locking or waiting.
+
+    Two resolutions are available:
+    - linear: one 2048-point FFT, numBins evenly spaced bins
+    - bass:   a multirate zoom FFT. The signal runs through a cascade of octave
+              stages, each lowpassed and downsampled by two from the one above
+              with the same halfband filter, and every stage is transformed with
+              the same 512-point FFT. Each stage contributes the octave it
+              resolves best, giving a near constant-Q frame (about 100 bins per
+              octave, 2.7 Hz spacing in the lowest one at 44.1 kHz) for roughly
+              twice the cost of a single small FFT.
+    Frames carry a frequency for every bin, so readers need not know which
+    resolution produced them.
+*/
+class SpectrumAnalyzerTap : public juce::TimeSliceClient
+{
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2; // DC up to, but not including, Nyquist
+    static constexpr int hopSize = fftSize / 4;
+
+    static constexpr int maxFrameBins = numBins; // Largest frame either resolution publishes
+
+    enum class Resolution
+    {
+        linear,
+        bass
+    };
+
+    SpectrumAnalyzerTap();
+
+    /** Sizes the FIFO and picks the decimation factor. Not real-time safe. */
+    void prepare (double sampleRate, int maxBlockSize);
+
+    /** Enables or disables the tap. Any thread; the audio thread checks it once per block. */
+    void setActive (bool shouldBeActive) noexcept { active.store (shouldBeActive, std::memory_order_relaxed); }
+    bool isActive() const noexcept { return active.load (std::memory_order_relaxed); }
+
+    /** Any thread; the analysis thread switches at its next time slice. */
+    void setResolution (Resolution newResolution) noexcept { requestedResolution.store (newResolution); }
+    Resolution getResolution() const noexcept { return requestedResolution.load(); }
+
+    //==============================================================================
+    /** Audio thread. Copies the decimated block into the FIFO, dropping samples if the analysis falls behind. */
+    void push (const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    /** Analysis thread. Drains the FIFO and publishes a frame for each completed hop. */
+    int useTimeSlice() override;
+
+    //==============================================================================
+    /**
+        Message thread (a single reader). Copies the latest magnitudes, scaled so a
+        full-scale sine reads 1.0, and zero-fills the rest of the buffer. Returns
+        true only if a frame newer than the previous call has been published.
+        Intended for linear frames, whose bin k sits at k * getAnalysisSampleRate() / fftSize.
+    */
+    bool readLatestFrame (float* magnitudes, int maxSize) const;
+
+    /**
+        As above, but also copies the centre frequency in Hz of every bin, ascending.
+        Returns the number of bins copied, or 0 if nothing new has been published.
+    */
+    int readLatestFrame (float* magnitudes, float* binFrequencies, int maxSize) const;
+
+    /** Rate of the analysed signal, so bin k sits at k * getAnalysisSampleRate() / fftSize. */
+    double getAnalysisSampleRate() const noexcept { return analysisSampleRate.load(); }
+
+private:
+    struct Frame
+    {
+        std::array<float, maxFrameBins> magnitudes {};
+        std::array<float, maxFrameBins> frequencies {};
+        int size = 0;
+    };
+
+    /** Three frames rotated between one writer and one reader; the writer never blocks. */
+    class TripleBuffer
+    {
+    public:
+        Frame& getWriteFrame() noexcept { return frames[(size_t) writeIndex]; }
+        void publish() noexcept;
+
+        /** Swaps in the newest frame if there is one; returns false if nothing new was published. */
+        bool acquireLatest() noexcept;
+        const Frame& getReadFrame() const noexcept { return frames[(size_t) readIndex]; }
+
+    private:
+        static constexpr int freshFlag = 4; // Set in state when the middle frame has not been read yet
+
+        std::array<Frame, 3> frames {};
+        std::atomic<int> state { 1 }; // Index of the middle frame, plus freshFlag
+        int writeIndex = 0;
+        int readIndex = 2;
+    };
+
+    //==============================================================================
+    // Bass resolution: octave stages sharing one decimation filter and one FFT size
+    static constexpr int bassFFTOrder = 9;
+    static constexpr int bassFFTSize = 1 << bassFFTOrder;
+    static constexpr int bassHopSize = bassFFTSize / 4;
+    static constexpr int numBassStages = 6;
+    static constexpr int decimationTaps = 63;
+
+    // Bins of each stage that make up the frame: the octave [0.2, 0.4) of its rate,
+    // extended up to Nyquist for the first stage and down to DC for the last
+    static constexpr int octaveStartBin = bassFFTSize / 5;
+    static constexpr int octaveEndBin = bassFFTSize * 2 / 5;
+
+    struct BassStage
+    {
+        std::array<float, bassFFTSize> history {};          // Circular, newest sample just before position
+        int position = 0;
+        int samplesSinceHop = 0;
+        bool hopPending = false;
+
+        std::array<float, decimationTaps * 2> delayLine {}; // Doubled so the filter reads one contiguous run
+        int delayPosition = 0;
+        bool skipNextOutput = false;                       // Keeps every second filter output
+
+        std::array<float, bassFFTSize / 2> magnitudes {};   // Latest analysis of this stage
+    };
+
+    static int getFirstBin (int stage) noexcept { return stage == numBassStages - 1 ? 1 : octaveStartBin; }
+    static int getEndBin (int stage) noexcept   { return stage == 0 ? bassFFTSize / 2 : octaveEndBin; }
+
+    static_assert ((bassFFTSize / 2 - octaveStartBin) + (numBassStages - 2) * (octaveEndBin - octaveStartBin)
+                       + (octaveEndBin - 1) <= maxFrameBins, "Bass frames must fit in a published frame");
+
+    void pushBassSample (int stage, float sample) noexcept;
+    void analyseBassStage (BassStage& stage) noexcept;
+    void publishBassFrame() noexcept;
+    void resetAnalysis() noexcept;
+
+    void analyseFrame() noexcept;
+
+    std::atomic<bool> active { false };
+    std::atomic<Resolution> requestedResolution { Resolution::linear };
+    std::atomic<double> analysisSampleRate { 44100.0 };
+
+    // Audio thread -> analysis thread
+    juce::AbstractFifo fifo { 1 };
+    std::vector<float> fifoBuffer;
+    int decimation = 1;
+    float decimationSum = 0.0f;
+    int decimationCount = 0;
+
+    // Analysis thread
+    Resolution resolution = Resolution::linear;
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+    std::array<float, fftSize> history {};   // Circular, newest sample just before historyPosition
+    std::array<float, fftSize * 2> fftData {};
+    int historyPosition = 0;
+    int samplesSinceHop = 0;
+    float magnitudeScale = 1.0f;
+
+    juce::dsp::FFT bassFFT { bassFFTOrder };
+    juce::dsp::WindowingFunction<float> bassWindow { (size_t) bassFFTSize, juce::dsp::WindowingFunction<float>::hann, false };
+    std::array<float, decimationTaps> decimationFilter {}; // Halfband lowpass, shared by every stage
+    std::array<BassStage, numBassStages> bassStages;
+    std::array<float, maxFrameBins> bassFrequencies {};    // Frame layout, lowest stage first
+    int bassFrameSize = 0;
+    float bassMagnitudeScale = 1.0f;
+
+    juce::CriticalSection analysisLock;      // prepare() vs the analysis thread; never taken by audio
+
+    // Analysis thread -> message thread
+    mutable TripleBuffer frames;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyzerTap)
+};
@@ -0,0 +1,357 @@
+/*
+    WubForgeUIBenchmark - Headless paint benchmark for the editor and spectrogram
+
+    Renders SpectrogramComponent and WubForgeAudioProcessorEditor into offscreen
+    images (see OffscreenRenderer) and reports paint time per frame, so UI cost
+    can be tracked on build agents without a display.
+
+    Usage:
+        WubForgeUIBenchmark [--frames=N] [--sizes=800x600,1920x1080]
+                            [--bins=512,1024,4096] [--sequence=file.wfsq]
+                            [--record=audio.wav] [--png-dir=directory] [--skip-editor]
+
+        --frames    Timed frames per configuration (default 300)
+        --sizes     Component sizes to render (default 800x600,1920x1080,3840x2160)
+        --bins      Spectrum resolutions for synthetic frames (default 512,1024,4096)
+        --sequence  Stored analysis sequence to replay instead of synthetic frames.
+                    With --record, the sequence is written there first.
+        --record    Analyses an audio file with SpectrumAnalyzerTap into --sequence
+        --png-dir   Writes every spectrogram frame of the first size, plus one
+                    editor frame per size, as PNG files
+        --skip-editor  Only benchmark the spectrogram
+*/
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "OffscreenRenderer.h"
+#include "SpectrogramComponent.h"
+#include "SpectrumAnalyzerTap.h"
+#include "PluginProcessor.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+namespace
+{
+//==============================================================================
+/**
+    A recorded series of analyser frames. File layout (native-endian):
+        "WFSQ", uint32 version, uint32 numBins, uint32 numFrames, float64 sampleRate,
+        then numFrames * numBins float32 magnitudes
+*/
+struct SpectrumSequence
+{
+    int numBins = 0;
+    double sampleRate = 44100.0;
+    std::vector<std::vector<float>> frames;
+
+    static constexpr juce::uint32 version = 1;
+
+    bool save (const juce::File& file) const
+    {
+        file.deleteFile();
+        juce::FileOutputStream out (file);
+        if (! out.openedOk())
+            return false;
+
+        out.write ("WFSQ", 4);
+        out.writeInt ((int) version);
+        out.writeInt (numBins);
+        out.writeInt ((int) frames.size());
+        out.writeDouble (sampleRate);
+
+        for (const auto& frame : frames)
+            out.write (frame.data(), frame.size() * sizeof (float));
+
+        return out.getStatus().wasOk();
+    }
+
+    bool load (const juce::File& file)
+    {
+        juce::FileInputStream in (file);
+        char magic[4] {};
+        if (! in.openedOk() || in.read (magic, 4) != 4 || std::memcmp (magic, "WFSQ", 4) != 0
+            || (juce::uint32) in.readInt() != version)
+            return false;
+
+        numBins = in.readInt();
+        const int numFrames = in.readInt();
+        sampleRate = in.readDouble();
+
+        if (numBins <= 0 || numFrames <= 0 || sampleRate <= 0.0)
+            return false;
+
+        frames.assign ((size_t) numFrames, std::vector<float> ((size_t) numBins));
+        for (auto& frame : frames)
+            if (in.read (frame.data(), numBins * (int) sizeof (float)) != numBins * (int) sizeof (float))
+                return false;
+
+        return true;
+    }
+
+    /** Runs an audio file through the same tap the plugin uses, keeping one frame per hop. */
+    bool record (const juce::File& audioFile)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (audioFile));
+        if (reader == nullptr)
+            return false;
+
+        constexpr int blockSize = 512;
+        SpectrumAnalyzerTap tap;
+        tap.prepare (reader->sampleRate, blockSize);
+        tap.setActive (true);
+
+        numBins = SpectrumAnalyzerTap::numBins;
+        sampleRate = tap.getAnalysisSampleRate();
+        frames.clear();
+
+        juce::AudioBuffer<float> buffer ((int) juce::jmax (1u, reader->numChannels), blockSize);
+        std::vector<float> frame ((size_t) numBins);
+
+        for (juce::int64 position = 0; position < reader->lengthInSamples; position += blockSize)
+        {
+            const int numSamples = (int) juce::jmin ((juce::int64) blockSize, reader->lengthInSamples - position);
+            buffer.clear();
+            reader->read (&buffer, 0, numSamples, position, true, true);
+
+            tap.push (juce::dsp::AudioBlock<float> (buffer).getSubBlock (0, (size_t) numSamples));
+            tap.useTimeSlice();
+
+            if (tap.readLatestFrame (frame.data(), numBins))
+                frames.push_back (frame);
+        }
+
+        return ! frames.empty();
+    }
+
+    /** Harmonic series sweeping over a noise floor, so the benchmark has something to draw. */
+    static SpectrumSequence synthesise (int numBins, int numFrames)
+    {
+        SpectrumSequence sequence;
+        sequence.numBins = numBins;
+        sequence.frames.assign ((size_t) numFrames, std::vector<float> ((size_t) numBins));
+
+        juce::Random random (1234);
+        const double binWidth = sequence.sampleRate / (2.0 * numBins);
+
+        for (int f = 0; f < numFrames; ++f)
+        {
+            auto& frame = sequence.frames[(size_t) f];
+            for (auto& magnitude : frame)
+                magnitude = 1.0e-4f * (0.5f + random.nextFloat());
+
+            const double fundamental = 40.0 * std::pow (8.0, 0.5 + 0.5 * std::sin (juce::MathConstants<double>::twoPi * f / numFrames));
+
+            for (int harmonic = 1; harmonic * fundamental < sequence.sampleRate * 0.5; ++harmonic)
+            {
+                const int bin = (int) std::round (harmonic * fundamental / binWidth);
+                if (bin < numBins)
+                    frame[(size_t) bin] = juce::jmax (frame[(size_t) bin], 0.5f / (float) harmonic);
+            }
+        }
+
+        return sequence;
+    }
+};
+
+//==============================================================================
+struct Timings
+{
+    std::vector<double> milliseconds;
+
+    void report (const juce::String& label) const
+    {
+        auto sorted = milliseconds;
+        std::sort (sorted.begin(), sorted.end());
+
+        const auto at = [&sorted] (double fraction) { return sorted[(size_t) (fraction * (double) (sorted.size() - 1))]; };
+        const double mean = std::accumulate (sorted.begin(), sorted.end(), 0.0) / (double) sorted.size();
+
+        std::cout << label.paddedRight (' ', 36)
+                  << "  mean " << juce::String (mean, 3).paddedLeft (' ', 8)
+                  << "  median " << juce::String (at (0.5), 3).paddedLeft (' ', 8)
+                  << "  p95 " << juce::String (at (0.95), 3).paddedLeft (' ', 8)
+                  << "  max " << juce::String (sorted.back(), 3).paddedLeft (' ', 8) << " ms" << std::endl;
+    }
+};
+
+template <typename Function>
+double timeMilliseconds (Function&& function)
+{
+    const auto start = juce::Time::getMillisecondCounterHiRes();
+    function();
+    return juce::Time::getMillisecondCounterHiRes() - start;
+}
+
+juce::Array<juce::Rectangle<int>> parseSizes (const juce::String& text)
+{
+    juce::Array<juce::Rectangle<int>> sizes;
+    for (const auto& token : juce::StringArray::fromTokens (text, ",", {}))
+    {
+        const int width = token.upToFirstOccurrenceOf ("x", false, true).getIntValue();
+        const int height = token.fromFirstOccurrenceOf ("x", false, true).getIntValue();
+        if (width > 0 && height > 0)
+            sizes.add ({ width, height });
+    }
+    return sizes;
+}
+
+juce::String describe (juce::Rectangle<int> size)
+{
+    return juce::String (size.getWidth()) + "x" + juce::String (size.getHeight());
+}
+
+//==============================================================================
+void benchmarkSpectrogram (const SpectrumSequence& sequence, juce::Rectangle<int> size, int numFrames,
+                           const juce::File& pngDirectory)
+{
+    SpectrogramComponent spectrogram;
+    spectrogram.setSize (size.getWidth(), size.getHeight());
+
+    juce::Image frame;
+    Timings push, paint;
+    const auto label = describe (size) + ", " + juce::String (sequence.numBins) + " bins";
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        const auto& magnitudes = sequence.frames[(size_t) i % sequence.frames.size()];
+
+        push.milliseconds.push_back (timeMilliseconds ([&] {
+            spectrogram.pushSpectrumData (magnitudes.data(), sequence.numBins, sequence.sampleRate);
+        }));
+
+        paint.milliseconds.push_back (timeMilliseconds ([&] {
+            OffscreenRenderer::renderInto (spectrogram, frame);
+        }));
+
+        if (pngDirectory != juce::File())
+            OffscreenRenderer::writePNG (frame, pngDirectory.getChildFile ("spectrogram_" + juce::String (i).paddedLeft ('0', 5) + ".png"));
+    }
+
+    push.report ("spectrogram push   " + label);
+    paint.report ("spectrogram paint  " + label);
+}
+
+void benchmarkEditor (juce::Rectangle<int> size, int numFrames, const juce::File& pngDirectory)
+{
+    // 60 frames per second worth of audio per painted frame, so the output tap keeps publishing
+    constexpr double sampleRate = 44100.0;
+    constexpr int blockSize = 735;
+
+    WubForgeAudioProcessor processor;
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    std::unique_ptr<juce::AudioProcessorEditor> editor (processor.createEditor());
+    editor->setSize (size.getWidth(), size.getHeight());
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    juce::MidiBuffer midi;
+    double phase = 0.0;
+
+    juce::Image frame;
+    Timings paint;
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        for (int s = 0; s < blockSize; ++s)
+        {
+            const auto sample = (float) (0.5 * std::sin (phase) + 0.25 * std::sin (3.0 * phase));
+            buffer.setSample (0, s, sample);
+            buffer.setSample (1, s, sample);
+            phase = std::fmod (phase + juce::MathConstants<double>::twoPi * 55.0 / sampleRate, juce::MathConstants<double>::twoPi * 100.0);
+        }
+
+        processor.processBlock (buffer, midi);
+
+        // Let the editor's timer pull analyser frames as it would in a host
+        juce::MessageManager::getInstance()->runDispatchLoopUntil (2);
+
+        paint.milliseconds.push_back (timeMilliseconds ([&] {
+            OffscreenRenderer::renderInto (*editor, frame);
+        }));
+    }
+
+    paint.report ("editor paint       " + describe (size));
+
+    if (pngDirectory != juce::File())
+        OffscreenRenderer::writePNG (frame, pngDirectory.getChildFile ("editor_" + describe (size) + ".png"));
+
+    editor.reset();
+}
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    const int numFrames = juce::jmax (1, args.containsOption ("--frames") ? args.getValueForOption ("--frames").getIntValue() : 300);
+    auto sizes = parseSizes (args.containsOption ("--sizes") ? args.getValueForOption ("--sizes") : "800x600,1920x1080,3840x2160");
+    const auto binCounts = juce::StringArray::fromTokens (args.containsOption ("--bins") ? args.getValueForOption ("--bins") : "512,1024,4096", ",", {});
+
+    if (sizes.isEmpty())
+    {
+        std::cerr << "No valid --sizes given" << std::endl;
+        return 1;
+    }
+
+    juce::File pngDirectory;
+    if (args.containsOption ("--png-dir"))
+    {
+        pngDirectory = args.getExistingFolderForOptionAndCreateIfNeeded ("--png-dir");
+        std::cout << "Writing PNG frames to " << pngDirectory.getFullPathName() << std::endl;
+    }
+
+    // Stored sequence, optionally recorded from audio first; otherwise synthetic frames
+    std::vector<SpectrumSequence> sequences;
+
+    if (args.containsOption ("--sequence"))
+    {
+        const auto sequenceFile = args.getFileForOption ("--sequence");
+        SpectrumSequence sequence;
+
+        if (args.containsOption ("--record"))
+        {
+            if (! sequence.record (args.getExistingFileForOption ("--record")) || ! sequence.save (sequenceFile))
+            {
+                std::cerr << "Could not record " << args.getValueForOption ("--record") << std::endl;
+                return 1;
+            }
+
+            std::cout << "Recorded " << sequence.frames.size() << " frames to " << sequenceFile.getFullPathName() << std::endl;
+        }
+        else if (! sequence.load (sequenceFile))
+        {
+            std::cerr << "Could not load sequence " << sequenceFile.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        sequences.push_back (std::move (sequence));
+    }
+    else
+    {
+        for (const auto& bins : binCounts)
+            if (bins.getIntValue() > 0)
+                sequences.push_back (SpectrumSequence::synthesise (bins.getIntValue(), 256));
+    }
+
+    for (const auto& size : sizes)
+    {
+        for (const auto& sequence : sequences)
+        {
+            const bool dumpFrames = size == sizes.getFirst() && &sequence == &sequences.front();
+            benchmarkSpectrogram (sequence, size, numFrames, dumpFrames ? pngDirectory : juce::File());
+        }
+    }
+
+    if (! args.containsOption ("--skip-editor"))
+        for (const auto& size : sizes)
+            benchmarkEditor (size, numFrames, pngDirectory);
+
+    return 0;
+}
@@ -1,4 +1,131 @@
 #include "UniversalDistortionModule.h"
+#include "BiquadCoefficientCache.h"
+#include "FastMath.h"
+
+namespace
+{
+    /** Digital model over one channel. The fold gain, the fold's share of the output
+        and the number of quantiser levels ramp linearly across the block; each variant
+        is a branch-free loop the compiler turns into packed SIMD. */
+    template <bool fold, bool crush>
+    void processDigitalChannel (float* __restrict samples, int numSamples,
+                                float drive, float driveStep, float foldMix, float foldMixStep,
+                                float levels, float levelsStep) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float s = samples[i];
+
+            if (fold)
+            {
+                const float t = (float) i;
+                s += (foldMix + t * foldMixStep) * (FastMath::sin (s * (drive + t * driveStep)) - s);
+            }
+
+            if (crush)
+            {
+                const float l = levels + (float) i * levelsStep;
+                s = FastMath::roundNearest (s * l) / l;
+            }
+
+            samples[i] = s;
+        }
+    }
+
+    /** FM over one channel. The carrier increment and the index ramp linearly across
+        the block; the carrier phase is evaluated in closed form within short chunks
+        (so float precision holds) and the loop vectorises. Returns the end phase. */
+    float processFmChannel (float* __restrict samples, int numSamples, float phase,
+                            float delta, float deltaStep, float index, float indexStep) noexcept
+    {
+        constexpr int chunkSize = 64;
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            const int n = juce::jmin (chunkSize, numSamples - start);
+            float* chunk = samples + start;
+
+            for (int i = 0; i < n; ++i)
+            {
+                // Sum of the ramped increments of the samples before i
+                const float t = (float) i;
+                const float carrier = phase + t * delta + 0.5f * t * (t - 1.0f) * deltaStep;
+                chunk[i] = FastMath::sin (carrier + chunk[i] * (index + t * indexStep));
+            }
+
+            const float m = (float) n;
+            phase = FastMath::wrapPhase (phase + m * delta + 0.5f * m * (m - 1.0f) * deltaStep);
+            delta += m * deltaStep;
+            index += m * indexStep;
+        }
+
+        return phase;
+    }
+
+    /** Runs processFrame (group, frame, sample) on every sample, channels as the lanes
+        of frame, numLanes at a time. Missing channels run as silent lanes. */
+    template <int numLanes, typename Group, typename Function>
+    void forEachFrame (const juce::dsp::AudioBlock<float>& block, std::vector<Group>& groups, Function&& processFrame)
+    {
+        const int numSamples = static_cast<int>(block.getNumSamples());
+        const int numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), static_cast<int>(groups.size()) * numLanes);
+
+        for (int first = 0; first < numChannels; first += numLanes)
+        {
+            auto& group = groups[static_cast<size_t>(first / numLanes)];
+            const int activeLanes = juce::jmin(numLanes, numChannels - first);
+
+            std::array<float*, numLanes> channels {};
+            for (int lane = 0; lane < activeLanes; ++lane)
+                channels[static_cast<size_t>(lane)] = block.getChannelPointer(static_cast<size_t>(first + lane));
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                alignas (16) std::array<float, numLanes> frame {};
+                for (int lane = 0; lane < activeLanes; ++lane)
+                    frame[static_cast<size_t>(lane)] = channels[static_cast<size_t>(lane)][i];
+
+                processFrame(group, frame, i);
+
+                for (int lane = 0; lane < activeLanes; ++lane)
+                    channels[static_cast<size_t>(lane)][i] = frame[static_cast<size_t>(lane)];
+            }
+        }
+    }
+
+    /** One-pole lowpass coefficient for a cutoff in Hz. */
+    float onePoleCoefficient(float cutoff, double sampleRate) noexcept
+    {
+        return 1.0f - FastMath::exp(-juce::MathConstants<float>::twoPi * cutoff / static_cast<float>(sampleRate));
+    }
+
+    // ProCo RAT: the LM308 (about 1 MHz gain-bandwidth with its 30 pF compensation, rails
+    // near 4.5 V) drives 1k into the 1N914 pair. The 3.3 nF across the diodes puts a pole
+    // near 48 kHz, above the audio band, so the clipper is modelled without it
+    constexpr float ratGainBandwidth = 1.0e6f;
+    constexpr float ratRail = 4.5f;
+    constexpr float ratClipResistance = 1000.0f;
+
+    // Tube Screamer: the 4.7k + 47 nF ground leg (720 Hz) sets the current through the
+    // feedback network, 51 pF across the drive resistance and the 1N914 pair
+    constexpr float screamerGroundResistance = 4700.0f;
+    constexpr float screamerGroundCutoff = 720.0f;
+    constexpr float screamerFeedbackCapacitance = 51.0e-12f;
+    constexpr float screamerFeedbackResistance = 51000.0f;
+    constexpr float screamerDrivePot = 500000.0f;
+    constexpr double screamerDriveSmoothingSeconds = 0.05;
+
+    // Below this wavefold amount the fold is crossfaded with the dry signal, so turning
+    // it off lands on the dry signal instead of jumping from sin (x) to x
+    constexpr float digitalFoldFadeAmount = 0.05f;
+
+    /** Moves a smoothed value one block towards its target, snapping once it is close. */
+    float glide (float current, float target, float coefficient) noexcept
+    {
+        current += coefficient * (target - current);
+        return std::abs (target - current) < 1.0e-4f ? target : current;
+    }
+}
 
 UniversalDistortionModule::UniversalDistortionModule()
 {
@@ -8,16 +135,25 @@ UniversalDistortionModule::UniversalDistortionModule()
 void UniversalDistortionModule::prepare (const juce::dsp::ProcessSpec& spec)
 {
     sampleRate = spec.sampleRate;
+    fmPhases.assign(spec.numChannels, 0.0f);
 
     rodentInputGain.prepare(spec);
     rodentToneFilter.prepare(spec);
     rodentOutputGain.prepare(spec);
 
-    screamerInputGain.prepare(spec);
-    screamerMidBoostFilter.prepare(spec);
     screamerToneFilter.prepare(spec);
     screamerOutputGain.prepare(spec);
 
+    rodentOpAmps.assign(spec.numChannels, 0.0f);
+    rodentClipper.prepare(ratClipResistance);
+
+    // Every table the drive pot can need is built here, so turning it never solves anything
+    screamerClipper.prepare(sampleRate, screamerFeedbackResistance, screamerFeedbackResistance + screamerDrivePot,
+                            screamerFeedbackCapacitance);
+    screamerGroups.resize((spec.numChannels + screamerLanes - 1) / screamerLanes);
+    screamerSettings.resize(juce::jmax<size_t>(1, spec.maximumBlockSize));
+    screamerResistanceSmoother.reset(sampleRate, screamerDriveSmoothingSeconds);
+
     reset();
 }
 
@@ -27,12 +163,16 @@ void UniversalDistortionModule::reset()
     rodentToneFilter.reset();
     rodentOutputGain.reset();
 
-    screamerInputGain.reset();
-    screamerMidBoostFilter.reset();
     screamerToneFilter.reset();
     screamerOutputGain.reset();
 
-    fmPhase = 0.0f;
+    std::fill(rodentOpAmps.begin(), rodentOpAmps.end(), 0.0f);
+    std::fill(screamerGroups.begin(), screamerGroups.end(), ScreamerGroup {});
+    screamerResistanceSmoother.setCurrentAndTargetValue(screamerDriveResistance);
+
+    std::fill(fmPhases.begin(), fmPhases.end(), 0.0f);
+    fmRampPrimed = false;
+    resetDigitalSmoothing();
     updateFilters();
 }
 
@@ -67,8 +207,25 @@ void UniversalDistortionModule::setModel (Model newModel)
     }
 }
 
-void UniversalDistortionModule::setDigitalWavefold(float amount) { digitalWavefold = amount; }
-void UniversalDistortionModule::setDigitalBitcrush(float amount) { digitalBitcrush = amount; }
+void UniversalDistortionModule::setDigitalWavefold(float amount)
+{
+    digitalWavefold = amount;
+    digitalFoldDrive = 1.0f + juce::jmax(0.0f, amount) * 5.0f;
+    digitalFoldMix = juce::jlimit(0.0f, 1.0f, amount / digitalFoldFadeAmount);
+}
+
+void UniversalDistortionModule::setDigitalBitcrush(float amount)
+{
+    digitalBitcrush = amount;
+    digitalBits = amount > 0.0f ? juce::jmap(amount, 16.0f, 2.0f) : 16.0f;
+}
+
+void UniversalDistortionModule::resetDigitalSmoothing()
+{
+    smoothedFoldDrive = digitalFoldDrive;
+    smoothedFoldMix = digitalFoldMix;
+    smoothedBits = digitalBits;
+}
 
 void UniversalDistortionModule::setFmRatio(float ratio) 
 {
@@ -93,7 +250,8 @@ void UniversalDistortionModule::setRodentLevel(float level)
 
 void UniversalDistortionModule::setScreamerDrive(float drive)
 {
-    screamerInputGain.setGainDecibels(drive * 30.0f);
+    // The drive pot in series with the 51k feedback resistor; the clipper glides to it
+    screamerDriveResistance = screamerFeedbackResistance + juce::jlimit(0.0f, 1.0f, drive) * screamerDrivePot;
 }
 
 void UniversalDistortionModule::setScreamerTone(float tone)
@@ -112,23 +270,49 @@ void UniversalDistortionModule::setScreamerLevel(float level)
 void UniversalDistortionModule::processDigital(const juce::dsp::ProcessContextReplacing<float>& context)
 {
     auto& block = context.getOutputBlock();
+    const int numSamples = static_cast<int>(block.getNumSamples());
+
+    if (numSamples == 0)
+        return;
+
+    // Parameters glide with a 20 ms time constant, stepped once per block and ramped across it
+    const float smoothing = 1.0f - FastMath::exp(-static_cast<float>(numSamples) / (0.02f * static_cast<float>(sampleRate)));
+    const float driveStart = smoothedFoldDrive;
+    const float foldMixStart = smoothedFoldMix;
+    const float bitsStart = smoothedBits;
+    smoothedFoldDrive = glide(smoothedFoldDrive, digitalFoldDrive, smoothing);
+    smoothedFoldMix = glide(smoothedFoldMix, digitalFoldMix, smoothing);
+    smoothedBits = glide(smoothedBits, digitalBits, smoothing);
+
+    // Stages stay on while they are still gliding back to neutral; the fold fades
+    // out through its mix, so switching it off here does not step the output
+    const bool fold = foldMixStart > 0.0f || smoothedFoldMix > 0.0f;
+    const bool crush = digitalBitcrush > 0.0f || bitsStart != 16.0f;
+
+    if (! fold && ! crush)
+        return;
+
+    const float inverseLength = 1.0f / static_cast<float>(numSamples);
+    const float driveStep = (smoothedFoldDrive - driveStart) * inverseLength;
+    const float foldMixStep = (smoothedFoldMix - foldMixStart) * inverseLength;
+
+    // Level counts for the whole block: two exps here instead of a pow per sample
+    const float levelsStart = FastMath::exp(bitsStart * FastMath::ln2);
+    const float levelsStep = (FastMath::exp(smoothedBits * FastMath::ln2) - levelsStart) * inverseLength;
+
     for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
     {
         auto* samples = block.getChannelPointer(ch);
-        for (size_t i = 0; i < block.getNumSamples(); ++i)
-        {
-            float s = samples[i];
-            // Wavefolding
-            if (digitalWavefold > 0.0f)
-                s = std::sin(s * (1.0f + digitalWavefold * 5.0f));
-            // Bitcrushing
-            if (digitalBitcrush > 0.0f)
-            {
-                float totalLevels = std::pow(2.0f, juce::jmap(digitalBitcrush, 16.0f, 2.0f));
-                s = std::round(s * totalLevels) / totalLevels;
-            }
-            samples[i] = s;
-        }
+
+        if (fold && crush)
+            processDigitalChannel<true, true>(samples, numSamples, driveStart, driveStep, foldMixStart, foldMixStep,
+                                              levelsStart, levelsStep);
+        else if (fold)
+            processDigitalChannel<true, false>(samples, numSamples, driveStart, driveStep, foldMixStart, foldMixStep,
+                                               levelsStart, levelsStep);
+        else
+            processDigitalChannel<false, true>(samples, numSamples, driveStart, driveStep, foldMixStart, foldMixStep,
+                                               levelsStart, levelsStep);
     }
 }
 
@@ -136,63 +320,147 @@ void UniversalDistortionModule::processFM(const juce::dsp::ProcessContextReplaci
 {
     if (keyTracker == nullptr) return;
 
-    auto currentFreq = keyTracker->getCurrentFrequency();
-    auto targetFreq = juce::jlimit(20.0, 20000.0, currentFreq * fmRatio);
-    fmPhaseDelta = (targetFreq * juce::MathConstants<float>::twoPi) / static_cast<float>(sampleRate);
-
     auto& block = context.getOutputBlock();
-    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+    const int numSamples = static_cast<int>(block.getNumSamples());
+    const size_t numChannels = juce::jmin(block.getNumChannels(), fmPhases.size());
+
+    if (numSamples == 0)
+        return;
+
+    const float rate = static_cast<float>(sampleRate);
+    const float keyFrequency = juce::jmax(20.0f, static_cast<float>(keyTracker->getCurrentFrequency()));
+    const float targetFrequency = juce::jlimit(20.0f, juce::jmin(20000.0f, 0.45f * rate), keyFrequency * fmRatio);
+
+    // Limit the index so the upper Carson sideband (carrier + (index + 1) * modulator) stays
+    // below 0.45 of the sample rate, taking the played note as the modulator's fundamental
+    const float maxIndex = juce::jmax(0.0f, (0.45f * rate - targetFrequency) / keyFrequency - 1.0f);
+    const float targetIndex = juce::jlimit(0.0f, maxIndex, fmIndex);
+
+    if (! fmRampPrimed)
     {
-        auto* samples = block.getChannelPointer(ch);
-        for (size_t i = 0; i < block.getNumSamples(); ++i)
-        {
-            const float modulatedPhase = fmPhase + (samples[i] * fmIndex);
-            samples[i] = std::sin(modulatedPhase);
-            fmPhase += fmPhaseDelta;
-        }
+        fmCarrierFrequency = targetFrequency;
+        fmAppliedIndex = targetIndex;
+        fmRampPrimed = true;
     }
-    fmPhase = std::fmod(fmPhase, juce::MathConstants<float>::twoPi);
+
+    // Ramp from the last block's key and index to this one's, so note changes glide instead of stepping
+    const float inverseLength = 1.0f / static_cast<float>(numSamples);
+    const float radiansPerHz = juce::MathConstants<float>::twoPi / rate;
+    const float delta = fmCarrierFrequency * radiansPerHz;
+    const float deltaStep = (targetFrequency - fmCarrierFrequency) * radiansPerHz * inverseLength;
+    const float indexStep = (targetIndex - fmAppliedIndex) * inverseLength;
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+        fmPhases[ch] = processFmChannel(block.getChannelPointer(ch), numSamples, fmPhases[ch],
+                                        delta, deltaStep, fmAppliedIndex, indexStep);
+
+    fmCarrierFrequency = targetFrequency;
+    fmAppliedIndex = targetIndex;
 }
 
 void UniversalDistortionModule::processRodent(const juce::dsp::ProcessContextReplacing<float>& context)
 {
     rodentInputGain.process(context);
+
+    // The op-amp's bandwidth shrinks as its gain rises, which is much of the RAT's character
+    const float opAmpPole = onePoleCoefficient(juce::jmin(ratGainBandwidth / juce::jmax(1.0f, rodentInputGain.getGainLinear()),
+                                                          0.45f * static_cast<float>(sampleRate)), sampleRate);
+    const float opAmpHold = 1.0f - opAmpPole;
+
     auto& block = context.getOutputBlock();
-    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+    const int numSamples = static_cast<int>(block.getNumSamples());
+
+    for (size_t ch = 0; ch < juce::jmin(block.getNumChannels(), rodentOpAmps.size()); ++ch)
     {
         auto* samples = block.getChannelPointer(ch);
-        for (size_t i = 0; i < block.getNumSamples(); ++i)
-            samples[i] = juce::jlimit(-1.0f, 1.0f, samples[i]);
+        float opAmp = rodentOpAmps[ch];
+
+        // Written so that only one multiply-add is on the recursive path
+        for (int i = 0; i < numSamples; ++i)
+        {
+            opAmp = opAmp * opAmpHold + opAmpPole * samples[i];
+            samples[i] = juce::jlimit(-ratRail, ratRail, opAmp);
+        }
+
+        rodentOpAmps[ch] = opAmp;
+
+        // The diode clipper has no memory, so it runs over the whole block at once
+        rodentClipper.process(samples, numSamples);
     }
+
     rodentToneFilter.process(context);
     rodentOutputGain.process(context);
 }
 
 void UniversalDistortionModule::processScreamer(const juce::dsp::ProcessContextReplacing<float>& context)
 {
-    screamerMidBoostFilter.process(context);
-    screamerInputGain.process(context);
+    const float groundPole = onePoleCoefficient(screamerGroundCutoff, sampleRate);
+    const float groundHold = 1.0f - groundPole;
+
     auto& block = context.getOutputBlock();
-    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+    const int numSamples = static_cast<int>(block.getNumSamples());
+    const int maxSamples = static_cast<int>(screamerSettings.size());
+
+    screamerResistanceSmoother.setTargetValue(screamerDriveResistance);
+
+    for (int start = 0; start < numSamples; start += maxSamples)
     {
-        auto* samples = block.getChannelPointer(ch);
-        for (size_t i = 0; i < block.getNumSamples(); ++i)
-            samples[i] = std::tanh(samples[i]);
+        const int n = juce::jmin(maxSamples, numSamples - start);
+
+        // The drive resistance ramps sample by sample; the clipper interpolates between
+        // the tables either side of it, and the gain into it follows
+        if (screamerResistanceSmoother.isSmoothing())
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                const float resistance = screamerResistanceSmoother.getNextValue();
+                screamerSettings[static_cast<size_t>(i)] = { screamerClipper.locate(resistance), resistance / screamerGroundResistance };
+            }
+        }
+        else
+        {
+            const float resistance = screamerResistanceSmoother.getCurrentValue();
+            std::fill_n(screamerSettings.begin(), n, ScreamerSetting { screamerClipper.locate(resistance), resistance / screamerGroundResistance });
+        }
+
+        // The op-amp holds its inverting input at the input voltage, so the ground-leg current
+        // (a 720 Hz highpass of the input) flows through the feedback network and the output
+        // is the input plus the voltage across the clipping diodes
+        forEachFrame<screamerLanes>(block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(n)), screamerGroups,
+                                    [this, groundPole, groundHold](ScreamerGroup& group, ScreamerLanes& frame, int i)
+        {
+            const auto& setting = screamerSettings[static_cast<size_t>(i)];
+            alignas (16) ScreamerLanes source;
+
+            for (int lane = 0; lane < screamerLanes; ++lane)
+            {
+                auto& groundLeg = group.groundLeg[static_cast<size_t>(lane)];
+                groundLeg = groundLeg * groundHold + groundPole * frame[static_cast<size_t>(lane)];
+
+                // Norton current through the drive resistance, as its Thevenin voltage
+                source[static_cast<size_t>(lane)] = (frame[static_cast<size_t>(lane)] - groundLeg) * setting.feedbackGain;
+            }
+
+            screamerClipper.process(setting.clipper, group.clipper, source);
+
+            for (int lane = 0; lane < screamerLanes; ++lane)
+                frame[static_cast<size_t>(lane)] += source[static_cast<size_t>(lane)];
+        });
     }
+
     screamerToneFilter.process(context);
     screamerOutputGain.process(context);
 }
 
 void UniversalDistortionModule::updateFilters()
 {
+    // Coefficients come from the shared cache and are written into the existing filter states
+
     // Rodent Tone: A reverse low-pass filter.
     auto rodentCutoff = juce::jmap(rodentTone, 0.0f, 1.0f, 20000.0f, 500.0f);
-    *rodentToneFilter.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, rodentCutoff, 0.707f);
-
-    // Screamer Mid-Boost: A high-pass filter to cut lows before clipping.
-    *screamerMidBoostFilter.state = *juce::dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, 720.0f);
+    BiquadCoefficientCache::assign(*rodentToneFilter.state, BiquadCoefficientCache::get(Biquad::Type::lowpass, sampleRate, rodentCutoff, Biquad::butterworthQ));
 
     // Screamer Tone: A simple low-pass filter.
     auto screamerCutoff = juce::jmap(screamerTone, 0.0f, 1.0f, 15000.0f, 400.0f);
-    *screamerToneFilter.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, screamerCutoff, 0.707f);
+    BiquadCoefficientCache::assign(*screamerToneFilter.state, BiquadCoefficientCache::get(Biquad::Type::lowpass, sampleRate, screamerCutoff, Biquad::butterworthQ));
 }
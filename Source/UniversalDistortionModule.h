@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Module.h"
+#include "WaveDigitalFilter.h"
 
 //==============================================================================
 /**
@@ -14,8 +15,8 @@ public:
     {
         Digital,    // Wavefolder, Bitcrusher
         FM,         // FM Synthesis-based distortion
-        Rodent,     // ProCo RAT-style hard clipping
-        Screamer    // Tube Screamer-style soft clipping
+        Rodent,     // ProCo RAT clipping stage (wave digital model)
+        Screamer    // Tube Screamer clipping stage (wave digital model)
     };
 
     UniversalDistortionModule();
@@ -60,6 +61,7 @@ private:
     void processScreamer (const juce::dsp::ProcessContextReplacing<float>& context);
 
     void updateFilters();
+    void resetDigitalSmoothing();
 
     //==============================================================================
     // --- State & Parameters ---
@@ -68,26 +70,57 @@ private:
 
     // --- DSP Components for All Models ---
 
-    // Digital
+    // Digital - targets are worked out by the setters, the smoothed values glide towards them per block
     float digitalWavefold = 0.0f;
     float digitalBitcrush = 0.0f;
-
-    // FM
-    float fmPhase = 0.0f;
-    float fmPhaseDelta = 0.0f;
+    float digitalFoldDrive = 1.0f;      // Gain into the sine fold
+    float digitalFoldMix = 0.0f;        // Folded share of the output, fading to dry near zero
+    float digitalBits = 16.0f;          // Quantiser depth, log2 of the number of levels
+    float smoothedFoldDrive = 1.0f;
+    float smoothedFoldMix = 0.0f;
+    float smoothedBits = 16.0f;
+
+    // FM - each channel keeps its own carrier phase; frequency and index ramp from the previous block
+    std::vector<float> fmPhases;
+    float fmCarrierFrequency = 0.0f;    // Carrier at the end of the last block, in Hz
+    float fmAppliedIndex = 0.0f;        // Index after the alias limit, at the end of the last block
+    bool fmRampPrimed = false;          // The first block after a reset starts at its targets
     float fmRatio = 1.0f;
     float fmIndex = 0.0f;
 
-    // Rodent
-    juce::dsp::Gain<float> rodentInputGain;
+    // Rodent - LM308 gain stage into the 1N914 clipper, then the tone control
+    juce::dsp::Gain<float> rodentInputGain;     // Closed-loop gain of the op-amp stage
+    std::vector<float> rodentOpAmps;            // Op-amp output per channel, band-limited by its gain-bandwidth
+    WaveDigitalFilter::ResistiveClipper rodentClipper;
     juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>> rodentToneFilter;
     juce::dsp::Gain<float> rodentOutputGain;
     float rodentTone = 0.5f;
 
-    // Screamer
-    juce::dsp::Gain<float> screamerInputGain;
-    juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>> screamerMidBoostFilter;
+    // Screamer - op-amp stage with the 1N914 pair in its feedback loop, then the tone control
     juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>> screamerToneFilter;
     juce::dsp::Gain<float> screamerOutputGain;
+    float screamerDriveResistance = 51000.0f;   // Feedback resistance: 51k plus the 500k drive pot
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> screamerResistanceSmoother;
     float screamerTone = 0.5f;
+
+    // The Screamer's clipping stage runs channels as lanes, screamerLanes at a time
+    static constexpr int screamerLanes = 4;
+    using ScreamerLanes = std::array<float, screamerLanes>;
+
+    struct ScreamerGroup
+    {
+        alignas (16) ScreamerLanes groundLeg {};    // Lowpass part of the input across the 4.7k + 47n leg
+        alignas (16) ScreamerLanes clipper {};      // Capacitor waves of the clipper
+    };
+
+    /** The drive resistance at one sample, shared by every group of lanes. */
+    struct ScreamerSetting
+    {
+        WaveDigitalFilter::DiodeClipper<screamerLanes>::Setting clipper;
+        float feedbackGain = 1.0f;
+    };
+
+    WaveDigitalFilter::DiodeClipper<screamerLanes> screamerClipper;
+    std::vector<ScreamerGroup> screamerGroups;
+    std::vector<ScreamerSetting> screamerSettings;  // One per sample of the block, ramped with the drive
 };
\ No newline at end of file
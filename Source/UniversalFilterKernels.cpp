@@ -0,0 +1,894 @@
+#include "UniversalFilterKernels.h"
+
+namespace UniversalFilterKernels
+{
+
+//==============================================================================
+SpectralKernel::SpectralKernel()
+{
+    // Periodic Hann, matching STFTAnalysisService so shared frames resynthesise identically.
+    // Hann squared sums to 1.5 across four overlapping frames.
+    for (int i = 0; i < fftSize; ++i)
+    {
+        analysisWindow[(size_t) i] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) fftSize);
+        synthesisWindow[(size_t) i] = analysisWindow[(size_t) i] / 1.5f;
+    }
+}
+
+void SpectralKernel::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    numChannels = (int) spec.numChannels;
+
+    inputHistory.assign ((size_t) (numChannels * fftSize), 0.0f);
+    accumulators.assign ((size_t) (numChannels * accumulatorSize), 0.0f);
+    gainsMode = -1;
+
+    reset();
+}
+
+void SpectralKernel::reset() noexcept
+{
+    std::fill (inputHistory.begin(), inputHistory.end(), 0.0f);
+    std::fill (accumulators.begin(), accumulators.end(), 0.0f);
+    position = 0;
+    samplesSinceHop = 0;
+}
+
+void SpectralKernel::updateGains (const Parameters& p) noexcept
+{
+    if (p.spectralMode == gainsMode && p.spectralFrequency == gainsFrequency && p.spectralBandwidth == gainsBandwidth)
+        return;
+
+    const float binWidth = (float) sampleRate / fftSize;
+    const float centre = juce::jmax (1.0f, p.spectralFrequency);
+    const float halfBandwidth = p.spectralBandwidth * 0.5f;
+    const bool notch = p.spectralMode == 0;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        const float frequency = (float) bin * binWidth;
+
+        // Notch: remove bins within half a bandwidth of the centre.
+        // Comb: lift bins near a harmonic of the centre and cut the rest.
+        const float ratio = frequency / centre;
+        const float harmonicDistance = std::abs (ratio - FastMath::roundNearest (ratio)) * centre;
+
+        const float notchGain = FastMath::select (std::abs (frequency - centre) < halfBandwidth, 0.0f, 1.0f);
+        const float combGain = FastMath::select (harmonicDistance < halfBandwidth, 1.5f, 0.5f);
+        const float gain = FastMath::select (notch, notchGain, combGain);
+
+        binGains[(size_t) (bin * 2)] = gain;
+        binGains[(size_t) (bin * 2 + 1)] = gain;
+    }
+
+    gainsMode = p.spectralMode;
+    gainsFrequency = p.spectralFrequency;
+    gainsBandwidth = p.spectralBandwidth;
+}
+
+void SpectralKernel::pushInput (const juce::dsp::AudioBlock<float>& block, int start, int length) noexcept
+{
+    // A run never crosses a hop, which is a quarter of the history, so it wraps at most once
+    const int writeStart = position & (fftSize - 1);
+    const int firstPart = juce::jmin (length, fftSize - writeStart);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* input = block.getChannelPointer ((size_t) juce::jmin (ch, (int) block.getNumChannels() - 1)) + start;
+        float* history = inputHistory.data() + (size_t) ch * fftSize;
+
+        std::copy (input, input + firstPart, history + writeStart);
+        std::copy (input + firstPart, input + length, history);
+    }
+}
+
+void SpectralKernel::analyseChannel (int channel, int nextPosition) noexcept
+{
+    // The newest sample sits just before the next write position; unroll oldest first
+    const float* history = inputHistory.data() + (size_t) channel * fftSize;
+    const int oldest = nextPosition & (fftSize - 1);
+
+    std::copy (history + oldest, history + fftSize, workspace.begin());
+    std::copy (history, history + oldest, workspace.begin() + (fftSize - oldest));
+
+    juce::FloatVectorOperations::multiply (workspace.data(), analysisWindow.data(), fftSize);
+    fft.performRealOnlyForwardTransform (workspace.data());
+}
+
+void SpectralKernel::resynthesiseChannel (int channel, int lastPosition) noexcept
+{
+    juce::FloatVectorOperations::multiply (workspace.data(), binGains.data(), numBins * 2);
+    fft.performRealOnlyInverseTransform (workspace.data());
+    juce::FloatVectorOperations::multiply (workspace.data(), synthesisWindow.data(), fftSize);
+
+    // The frame's oldest sample comes out when the read position reaches its newest one
+    float* accumulator = accumulators.data() + (size_t) channel * accumulatorSize;
+    const int writeStart = lastPosition & (accumulatorSize - 1);
+    const int firstPart = juce::jmin (fftSize, accumulatorSize - writeStart);
+
+    juce::FloatVectorOperations::add (accumulator + writeStart, workspace.data(), firstPart);
+    juce::FloatVectorOperations::add (accumulator, workspace.data() + firstPart, fftSize - firstPart);
+}
+
+void SpectralKernel::writeOutput (const juce::dsp::AudioBlock<float>& block, int start, int length) noexcept
+{
+    const int readStart = position & (accumulatorSize - 1);
+    const int firstPart = juce::jmin (length, accumulatorSize - readStart);
+    const int channels = juce::jmin (numChannels, (int) block.getNumChannels());
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        float* output = block.getChannelPointer ((size_t) ch) + start;
+        float* accumulator = accumulators.data() + (size_t) ch * accumulatorSize;
+
+        std::copy (accumulator + readStart, accumulator + readStart + firstPart, output);
+        std::copy (accumulator, accumulator + (length - firstPart), output + firstPart);
+        std::fill (accumulator + readStart, accumulator + readStart + firstPart, 0.0f);
+        std::fill (accumulator, accumulator + (length - firstPart), 0.0f);
+    }
+
+    position = (position + length) & (accumulatorSize - 1);
+}
+
+void SpectralKernel::process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    updateGains (context.parameters);
+
+    auto* analysisPoint = context.analysisPoint;
+    const int numSamples = (int) block.getNumSamples();
+
+    // The processor's shared analysis already holds every channel's spectrum, so skip our own forward FFTs
+    const bool useSharedFrames = analysisPoint != nullptr && hopSize == STFTAnalysisService::hopSize
+                                 && fftSize == STFTAnalysisService::fftSize
+                                 && analysisPoint->getNumChannels() >= numChannels;
+
+    int start = 0, frameIndex = 0;
+
+    // Runs end at a hop (where a frame completes) or at the end of the block
+    while (start < numSamples)
+    {
+        int length = numSamples - start;
+        bool frameCompleted = false;
+
+        if (useSharedFrames)
+        {
+            if (frameIndex < analysisPoint->getNumFrames())
+            {
+                length = analysisPoint->getFrameEnd (frameIndex) - start;
+                frameCompleted = true;
+            }
+        }
+        else
+        {
+            length = juce::jmin (length, hopSize - samplesSinceHop);
+            samplesSinceHop += length;
+            frameCompleted = samplesSinceHop == hopSize;
+
+            pushInput (block, start, length);
+        }
+
+        if (frameCompleted)
+        {
+            const int lastPosition = position + length - 1;
+
+            if (useSharedFrames)
+            {
+                const auto& frame = analysisPoint->getFrame (frameIndex++);
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    const float* real = frame.getReal (ch);
+                    const float* imag = frame.getImag (ch);
+
+                    for (int bin = 0; bin < numBins; ++bin)
+                    {
+                        workspace[(size_t) (bin * 2)] = real[bin];
+                        workspace[(size_t) (bin * 2 + 1)] = imag[bin];
+                    }
+
+                    resynthesiseChannel (ch, lastPosition);
+                }
+            }
+            else
+            {
+                samplesSinceHop = 0;
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    analyseChannel (ch, lastPosition + 1);
+                    resynthesiseChannel (ch, lastPosition);
+                }
+            }
+        }
+
+        writeOutput (block, start, length);
+        start += length;
+    }
+}
+
+//==============================================================================
+void UptoneKernel::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    states.assign (spec.numChannels, {});
+    designedCutoff = -1.0f;
+
+    // DC blocker pole for a 10 Hz corner; rectification leaves a large offset behind
+    dcCoefficient = 1.0f - (float) (juce::MathConstants<double>::twoPi * 10.0 / sampleRate);
+}
+
+void UptoneKernel::reset() noexcept
+{
+    std::fill (states.begin(), states.end(), ChannelState {});
+}
+
+void UptoneKernel::process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto& p = context.parameters;
+    if (p.cutoff != designedCutoff)
+    {
+        svf.set (sampleRate, p.cutoff, 0.707f);
+        designedCutoff = p.cutoff;
+    }
+
+    const float mix = 2.0f * juce::jlimit (0.0f, 1.0f, p.amount);
+    const int numSamples = (int) block.getNumSamples();
+    const size_t numChannels = juce::jmin (block.getNumChannels(), states.size());
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* samples = block.getChannelPointer (ch);
+        auto state = states[ch];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float x = samples[i];
+
+            float band, low;
+            state.band.tick (svf, x, band, low);
+
+            // |x| of a sine is a sum of its even harmonics, led by the octave
+            const float rectified = std::abs (svf.k * band);
+            const float octave = rectified - state.dcInput + dcCoefficient * state.dcOutput;
+            state.dcInput = rectified;
+            state.dcOutput = octave;
+
+            samples[i] = x + mix * octave;
+        }
+
+        states[ch] = state;
+    }
+}
+
+//==============================================================================
+void SubBassKernel::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    lowpass.set (spec.sampleRate, 60.0f, 0.707f);
+    highpass.set (spec.sampleRate, 20.0f, 0.707f);
+    states.assign (spec.numChannels, {});
+}
+
+void SubBassKernel::reset() noexcept
+{
+    std::fill (states.begin(), states.end(), ChannelState {});
+}
+
+void SubBassKernel::process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const float mix = 2.0f * juce::jlimit (0.0f, 1.0f, context.parameters.amount);
+    const int numSamples = (int) block.getNumSamples();
+    const size_t numChannels = juce::jmin (block.getNumChannels(), states.size());
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* samples = block.getChannelPointer (ch);
+        auto state = states[ch];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float x = samples[i];
+
+            float band, low, subBand, subLow;
+            state.lowpass.tick (lowpass, x, band, low);
+            state.highpass.tick (highpass, low, subBand, subLow);
+
+            const float sub = low - highpass.k * subBand - subLow;
+            samples[i] = x + mix * sub;
+        }
+
+        states[ch] = state;
+    }
+}
+
+//==============================================================================
+void FormantKernel::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    states.assign (spec.numChannels, {});
+    designedKeyFrequency = -1.0f;
+}
+
+void FormantKernel::reset() noexcept
+{
+    for (auto& state : states)
+        state.fill (0.0f);
+}
+
+void FormantKernel::process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto& p = context.parameters;
+    const float keyFrequency = context.keyTracker != nullptr ? context.keyTracker->getCurrentFrequency()
+                                                             : (float) p.formantBaseFrequency;
+
+    if (keyFrequency != designedKeyFrequency || p.formantKeyTrack != designedKeyTrack || p.formantGain != designedGain
+        || p.formantQ != designedQ || p.formantBaseFrequency != designedBaseFrequency)
+    {
+        // Slide the formants with the played key, by formantKeyTrack of the way
+        const double baseFrequencyRatio = keyFrequency / juce::jmax (1.0, p.formantBaseFrequency);
+        const double tracking = juce::jlimit (0.0, 1.0, (double) p.formantKeyTrack);
+        const double scaleFactor = juce::jmap (tracking, 1.0, baseFrequencyRatio);
+
+        const BiquadCoefficientCache::Curve curve (Biquad::Type::peak, p.formantQ, p.formantGain);
+
+        for (int i = 0; i < numFormants; ++i)
+        {
+            const double formantFrequency = juce::jlimit (20.0, sampleRate / 2.1, baseFormants[(size_t) i] * scaleFactor);
+            coefficients[(size_t) i] = curve.get (sampleRate, (float) formantFrequency);
+        }
+
+        designedKeyFrequency = keyFrequency;
+        designedKeyTrack = p.formantKeyTrack;
+        designedGain = p.formantGain;
+        designedQ = p.formantQ;
+        designedBaseFrequency = p.formantBaseFrequency;
+    }
+
+    const int numSamples = (int) block.getNumSamples();
+    const size_t numChannels = juce::jmin (block.getNumChannels(), states.size());
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < numFormants; ++i)
+            processBiquad (coefficients[(size_t) i], states[ch].data() + i * 2, block.getChannelPointer (ch), numSamples);
+}
+
+//==============================================================================
+void TiltKernel::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    states.assign (spec.numChannels, 0.0f);
+    designedCutoff = -1.0f;
+}
+
+void TiltKernel::reset() noexcept
+{
+    std::fill (states.begin(), states.end(), 0.0f);
+}
+
+void TiltKernel::process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto& p = context.parameters;
+    if (p.cutoff != designedCutoff || p.amount != designedAmount)
+    {
+        const double pivot = juce::jlimit (10.0, sampleRate * 0.45, (double) p.cutoff);
+        const float g = (float) std::tan (juce::MathConstants<double>::pi * pivot / sampleRate);
+        coefficient = g / (1.0f + g);
+
+        const float tiltDecibels = (juce::jlimit (0.0f, 1.0f, p.amount) - 0.5f) * 12.0f;
+        lowGain = juce::Decibels::decibelsToGain (-tiltDecibels);
+        highGain = juce::Decibels::decibelsToGain (tiltDecibels);
+
+        designedCutoff = p.cutoff;
+        designedAmount = p.amount;
+    }
+
+    const int numSamples = (int) block.getNumSamples();
+    const size_t numChannels = juce::jmin (block.getNumChannels(), states.size());
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* samples = block.getChannelPointer (ch);
+        float state = states[ch];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // Trapezoidal one-pole split at the pivot
+            const float x = samples[i];
+            const float v = (x - state) * coefficient;
+            const float low = v + state;
+            state = low + v;
+
+            samples[i] = lowGain * low + highGain * (x - low);
+        }
+
+        states[ch] = state;
+    }
+}
+
+//==============================================================================
+void EnvelopeTrackKernel::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    states.assign (spec.numChannels, {});
+}
+
+void EnvelopeTrackKernel::reset() noexcept
+{
+    std::fill (states.begin(), states.end(), ChannelState {});
+}
+
+void EnvelopeTrackKernel::process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto& p = context.parameters;
+    const float attack = timeToCoefficient (p.attackMs, sampleRate);
+    const float release = timeToCoefficient (p.releaseMs, sampleRate);
+    const float octaves = 4.0f * juce::jlimit (0.0f, 1.0f, p.amount);
+    const float q = mapQ (p.resonance, 0.7f, 6.0f);
+
+    const int numSamples = (int) block.getNumSamples();
+    const size_t numChannels = juce::jmin (block.getNumChannels(), states.size());
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* samples = block.getChannelPointer (ch);
+        auto state = states[ch];
+
+        for (int start = 0; start < numSamples; start += controlPeriod)
+        {
+            const int end = juce::jmin (numSamples, start + controlPeriod);
+
+            // Cutoff follows the envelope at control rate; the loop below only runs the filter
+            Svf svf;
+            svf.set (sampleRate, p.cutoff * FastMath::exp (FastMath::ln2 * octaves * juce::jmin (1.0f, state.envelope)), q);
+
+            for (int i = start; i < end; ++i)
+            {
+                const float x = samples[i];
+
+                float band, low;
+                state.svf.tick (svf, x, band, low);
+
+                const float level = std::abs (x);
+                state.envelope += FastMath::select (level > state.envelope, attack, release) * (level - state.envelope);
+
+                samples[i] = low;
+            }
+        }
+
+        states[ch] = state;
+    }
+}
+
+//==============================================================================
+void PluckKernel::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+
+    // Long enough for a 20 Hz string plus the interpolator taps
+    lineLength = juce::nextPowerOfTwo ((int) (sampleRate / 20.0) + 8);
+    mask = lineLength - 1;
+    maxDelay = (float) (lineLength - 4);
+
+    lines.assign ((size_t) (lineLength * numVoices), 0.0f);
+    reset();
+}
+
+void PluckKernel::reset() noexcept
+{
+    std::fill (lines.begin(), lines.end(), 0.0f);
+    writePosition = 0;
+    gains.fill (0.0f);
+    losses.fill (0.0f);
+    peaks.fill (0.0f);
+    startTimes.fill (0);
+    numSounding = 0;
+}
+
+void PluckKernel::startVoice (float frequency, float velocity) noexcept
+{
+    // An idle voice if there is one, otherwise the one plucked longest ago
+    int voice = 0;
+    for (int v = 1; v < numVoices; ++v)
+    {
+        const bool idle = gains[(size_t) v] == 0.0f;
+        const bool voiceIdle = gains[(size_t) voice] == 0.0f;
+
+        if ((idle && ! voiceIdle) || (idle == voiceIdle && startTimes[(size_t) v] < startTimes[(size_t) voice]))
+            voice = v;
+    }
+
+    if (gains[(size_t) voice] == 0.0f)
+        ++numSounding;
+
+    // The one-pole loss filter adds (1 - c) / c samples to the loop at low frequencies
+    const float period = (float) sampleRate / juce::jlimit (20.0f, 20000.0f, frequency);
+    delays[(size_t) voice] = juce::jlimit (2.0f, maxDelay, period - (1.0f - damping) / damping);
+
+    // Fill the stretch the interpolator will read with fresh noise
+    const int excitationLength = (int) delays[(size_t) voice] + 4;
+    for (int j = 1; j <= excitationLength; ++j)
+        lines[(size_t) (((writePosition - j) & mask) * numVoices + voice)] = nextNoise();
+
+    gains[(size_t) voice] = juce::jmax (0.05f, velocity);
+    losses[(size_t) voice] = 0.0f;
+    peaks[(size_t) voice] = 1.0f;
+    startTimes[(size_t) voice] = ++clock;
+}
+
+void PluckKernel::render (const juce::dsp::AudioBlock<float>& block, int start, int length) noexcept
+{
+    if (numSounding == 0 || length <= 0)
+        return;
+
+    const size_t numChannels = block.getNumChannels();
+
+    for (int i = start; i < start + length; ++i)
+    {
+        alignas (32) Lanes outputs {};
+
+        for (int voice = 0; voice < numVoices; ++voice)
+            outputs[(size_t) voice] = readLagrange<numVoices> (lines.data(), mask, writePosition, voice, delays[(size_t) voice]);
+
+        // Averaging lowpass in the loop darkens each pass, as in the original algorithm
+        float* frame = lines.data() + writePosition * numVoices;
+        float output = 0.0f;
+
+        for (int voice = 0; voice < numVoices; ++voice)
+        {
+            const float y = outputs[(size_t) voice];
+            losses[(size_t) voice] += damping * (y - losses[(size_t) voice]);
+            frame[voice] = losses[(size_t) voice] * feedback;
+            peaks[(size_t) voice] = juce::jmax (peaks[(size_t) voice], std::abs (y));
+            output += gains[(size_t) voice] * y;
+        }
+
+        writePosition = (writePosition + 1) & mask;
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+            block.getChannelPointer (ch)[i] += mix * output;
+    }
+}
+
+void PluckKernel::process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto& p = context.parameters;
+    feedback = juce::jmap (juce::jlimit (0.0f, 1.0f, p.pluckDecay), 0.9f, 0.999f);
+    damping = juce::jmap (juce::jlimit (0.0f, 1.0f, p.pluckDamping), 1.0f, 0.2f);
+    mix = juce::jlimit (0.0f, 1.0f, p.amount);
+
+    const int numSamples = (int) block.getNumSamples();
+
+    // As in TriggerWatch, a kernel created after pluck() calls does not fire for them;
+    // note-ons are taken from the block's list below instead
+    if (manualTriggerArmed && p.triggerCount != lastManualTrigger)
+        startVoice (context.keyTracker != nullptr ? context.keyTracker->getCurrentFrequency() : 440.0f, 1.0f);
+
+    lastManualTrigger = p.triggerCount;
+    manualTriggerArmed = true;
+
+    // Render up to each note-on, then pluck its string, so attacks land on the right sample
+    int position = 0;
+    if (context.keyTracker != nullptr)
+    {
+        for (int n = 0; n < context.keyTracker->getNumBlockNoteOns(); ++n)
+        {
+            const auto& noteOn = context.keyTracker->getBlockNoteOn (n);
+            const int notePosition = juce::jlimit (position, numSamples, noteOn.samplePosition);
+
+            render (block, position, notePosition - position);
+            startVoice (KeyTracker::midiNoteToFrequency (noteOn.noteNumber), noteOn.velocity);
+            position = notePosition;
+        }
+    }
+
+    render (block, position, numSamples - position);
+
+    // Strings that stayed below -80 dB for the whole block go idle
+    for (int voice = 0; voice < numVoices; ++voice)
+    {
+        if (gains[(size_t) voice] > 0.0f && peaks[(size_t) voice] < 1.0e-4f)
+        {
+            gains[(size_t) voice] = 0.0f;
+            --numSounding;
+        }
+
+        peaks[(size_t) voice] = 0.0f;
+    }
+}
+
+//==============================================================================
+void DuckerKernel::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    gains.assign ((size_t) juce::jmax (1, (int) spec.maximumBlockSize), 1.0f);
+    reset();
+}
+
+void DuckerKernel::reset() noexcept
+{
+    target = 0.0f;
+    duck = 0.0f;
+}
+
+void DuckerKernel::process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto& p = context.parameters;
+
+    if (trigger.poll (context))
+        target = 1.0f;
+
+    const float attack = timeToCoefficient (p.attackMs, sampleRate);
+    const float releaseDecay = 1.0f - timeToCoefficient (p.releaseMs, sampleRate);
+    const float depth = juce::jlimit (0.0f, 1.0f, p.amount);
+
+    const int numSamples = (int) block.getNumSamples();
+    const int chunkSize = (int) gains.size();
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int length = juce::jmin (chunkSize, numSamples - start);
+
+        // The trigger jumps the target; the applied duck follows it with the attack time
+        for (int i = 0; i < length; ++i)
+        {
+            target *= releaseDecay;
+            duck += attack * (target - duck);
+            gains[(size_t) i] = 1.0f - depth * duck;
+        }
+
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+            juce::FloatVectorOperations::multiply (block.getChannelPointer (ch) + start, gains.data(), length);
+    }
+}
+
+//==============================================================================
+void LevelMatchKernel::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    gains.assign ((size_t) juce::jmax (1, (int) spec.maximumBlockSize), 1.0f);
+    reset();
+}
+
+void LevelMatchKernel::reset() noexcept
+{
+    meanSquare = 0.0f;
+    gain = 1.0f;
+}
+
+void LevelMatchKernel::process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    constexpr float targetLevel = 0.125893f;  // -18 dBFS RMS
+    constexpr float silence = 1.0e-6f;        // -60 dBFS mean square
+    constexpr float minGain = 0.0630957f, maxGain = 15.848932f;
+
+    const float averaging = timeToCoefficient (300.0f, sampleRate);
+    const float smoothing = timeToCoefficient (50.0f, sampleRate);
+    const float blend = juce::jlimit (0.0f, 1.0f, context.parameters.amount);
+
+    const int numSamples = (int) block.getNumSamples();
+    const size_t numChannels = block.getNumChannels();
+    const float channelScale = 1.0f / (float) juce::jmax ((size_t) 1, numChannels);
+    const int chunkSize = (int) gains.size();
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int length = juce::jmin (chunkSize, numSamples - start);
+
+        for (int i = 0; i < length; ++i)
+        {
+            float power = 0.0f;
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                const float x = block.getChannelPointer (ch)[start + i];
+                power += x * x;
+            }
+
+            meanSquare += averaging * (power * channelScale - meanSquare);
+
+            const float wanted = FastMath::select (meanSquare > silence, targetLevel / std::sqrt (meanSquare + silence), gain);
+            gain += smoothing * (juce::jlimit (minGain, maxGain, wanted) - gain);
+            gains[(size_t) i] = 1.0f + blend * (gain - 1.0f);
+        }
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::multiply (block.getChannelPointer (ch) + start, gains.data(), length);
+    }
+}
+
+//==============================================================================
+void RezFilterKernel::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    numChannels = (int) spec.numChannels;
+    groups.assign ((size_t) ((numChannels + numLanes - 1) / numLanes), {});
+}
+
+void RezFilterKernel::reset() noexcept
+{
+    std::fill (groups.begin(), groups.end(), LaneGroup {});
+}
+
+void RezFilterKernel::process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto& p = context.parameters;
+
+    const float cutoff = juce::jlimit (20.0f, (float) sampleRate * 0.45f, p.shaperCutoff);
+    const float g = std::tan (juce::MathConstants<float>::pi * cutoff / (float) sampleRate);
+    const float drive = 1.0f + juce::jmax (0.0f, p.shaperDrive) * 5.0f;
+    const float outputGain = 1.0f / drive;
+    const float baseResonance = juce::jlimit (0.0f, 1.0f, p.shaperResonance);
+    const float envelopeResonance = juce::jlimit (0.0f, 1.0f, p.amount) * (1.0f - baseResonance);
+    const float attack = timeToCoefficient (p.attackMs, sampleRate);
+    const float release = timeToCoefficient (p.releaseMs, sampleRate);
+
+    const int numSamples = (int) block.getNumSamples();
+    const int channelsToProcess = juce::jmin ((int) block.getNumChannels(), numChannels);
+
+    for (int first = 0; first < channelsToProcess; first += numLanes)
+    {
+        auto& group = groups[(size_t) (first / numLanes)];
+        const int activeLanes = juce::jmin (numLanes, channelsToProcess - first);
+
+        std::array<float*, numLanes> channels {};
+        for (int lane = 0; lane < activeLanes; ++lane)
+            channels[(size_t) lane] = block.getChannelPointer ((size_t) (first + lane));
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // Missing channels run as silent lanes so the lane loop keeps its fixed width
+            alignas (16) Lanes frame {};
+            for (int lane = 0; lane < activeLanes; ++lane)
+                frame[(size_t) lane] = channels[(size_t) lane][i];
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                const float input = frame[(size_t) lane];
+
+                auto& envelope = group.envelope[(size_t) lane];
+                const float level = std::abs (input);
+                envelope += FastMath::select (level > envelope, attack, release) * (level - envelope);
+
+                // Damping 1 / Q, with the envelope pushing it towards self-oscillation
+                const float k = juce::jlimit (0.01f, 1.0f, 1.0f - baseResonance - envelopeResonance * envelope);
+                const float a1 = 1.0f / (1.0f + g * (g + k));
+                const float a2 = g * a1;
+                const float a3 = g * a2;
+
+                auto& ic1 = group.ic1[(size_t) lane];
+                auto& ic2 = group.ic2[(size_t) lane];
+
+                const float v3 = input * drive - ic2;
+                const float band = a1 * ic1 + a2 * v3;
+                const float low = ic2 + a2 * ic1 + a3 * v3;
+
+                // The bandpass integrator is updated through the saturator. Only its
+                // nonlinear part tanh(x) - x is anti-aliased, so the half-sample delay of
+                // the antiderivative form stays out of the linear loop and the small-signal
+                // response is exactly the linear SVF's.
+                const float previousBand = group.previousBand[(size_t) lane];
+                const float saturated = band + Waveshapers::firstOrder<Waveshapers::Tanh> (band, previousBand) - 0.5f * (band + previousBand);
+                group.previousBand[(size_t) lane] = band;
+
+                ic1 = 2.0f * saturated - ic1;
+                ic2 = 2.0f * low - ic2;
+
+                frame[(size_t) lane] = low * outputGain;
+            }
+
+            for (int lane = 0; lane < activeLanes; ++lane)
+                channels[(size_t) lane][i] = frame[(size_t) lane];
+        }
+    }
+}
+
+//==============================================================================
+void CombBankKernel::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    numChannels = (int) spec.numChannels;
+
+    // Room for a 20 Hz key period plus a 50 ms base delay, the LFO swing and the interpolator taps
+    lineLength = juce::nextPowerOfTwo ((int) (sampleRate * 0.1) + 64);
+    mask = lineLength - 1;
+    maxDelay = (float) (lineLength - 4);
+
+    lines.assign ((size_t) (numChannels * lineLength * maxCombCount), 0.0f);
+    writePositions.assign ((size_t) numChannels, 0);
+    reset();
+}
+
+void CombBankKernel::reset() noexcept
+{
+    std::fill (lines.begin(), lines.end(), 0.0f);
+    std::fill (writePositions.begin(), writePositions.end(), 0);
+    delaysValid = false;
+    lfoPhase = 0.0f;
+}
+
+void CombBankKernel::process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto& p = context.parameters;
+    const int numCombs = juce::jlimit (1, maxCombCount, p.combCount);
+    const float feedback = juce::jlimit (-0.98f, 0.98f, p.combFeedback);
+    const float keyPeriod = context.keyTracker != nullptr
+                              ? (float) sampleRate / juce::jlimit (20.0f, 20000.0f, context.keyTracker->getCurrentFrequency())
+                              : 0.0f;
+    const float centreDelay = p.combDelay * 0.001f * (float) sampleRate + keyPeriod;
+    const float swing = p.combLfoDepth * 20.0f;
+    const float phaseIncrement = FastMath::twoPi * p.combLfoRate / (float) sampleRate;
+
+    // Unused combs stay in the loop with no output, so the lane count never changes
+    alignas (32) Lanes laneGains {};
+    alignas (32) Lanes lanePhases {};
+    for (int lane = 0; lane < maxCombCount; ++lane)
+    {
+        laneGains[(size_t) lane] = FastMath::select (lane < numCombs, 1.0f / (float) numCombs, 0.0f);
+        lanePhases[(size_t) lane] = FastMath::twoPi * (float) lane / (float) numCombs;
+    }
+
+    auto getTargetDelays = [&] (float phase, Lanes& targets)
+    {
+        // Same tuning for every comb, with the LFO phase spread across the bank so they beat against each other
+        for (int lane = 0; lane < maxCombCount; ++lane)
+            targets[(size_t) lane] = juce::jlimit (2.0f, maxDelay, centreDelay + swing * FastMath::sin (phase + lanePhases[(size_t) lane]));
+    };
+
+    if (! delaysValid)
+    {
+        getTargetDelays (lfoPhase, delays);
+        delaysValid = true;
+    }
+
+    const int numSamples = (int) block.getNumSamples();
+    const size_t channels = juce::jmin (block.getNumChannels(), (size_t) numChannels);
+
+    for (int start = 0; start < numSamples; start += controlPeriod)
+    {
+        const int length = juce::jmin (controlPeriod, numSamples - start);
+        lfoPhase = FastMath::wrapPhase (lfoPhase + phaseIncrement * (float) length);
+
+        alignas (32) Lanes targets {}, slopes {};
+        getTargetDelays (lfoPhase, targets);
+
+        for (int lane = 0; lane < maxCombCount; ++lane)
+            slopes[(size_t) lane] = (targets[(size_t) lane] - delays[(size_t) lane]) / (float) length;
+
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            float* samples = block.getChannelPointer (ch) + start;
+            float* line = lines.data() + ch * (size_t) (lineLength * maxCombCount);
+            int writePosition = writePositions[ch];
+
+            alignas (32) Lanes delay = delays;
+            alignas (32) Lanes delayed {};
+
+            for (int i = 0; i < length; ++i)
+            {
+                for (int lane = 0; lane < maxCombCount; ++lane)
+                {
+                    delayed[(size_t) lane] = readLagrange<maxCombCount> (line, mask, writePosition, lane, delay[(size_t) lane]);
+                    delay[(size_t) lane] += slopes[(size_t) lane];
+                }
+
+                const float x = samples[i];
+                float* frame = line + writePosition * maxCombCount;
+                float output = 0.0f;
+
+                for (int lane = 0; lane < maxCombCount; ++lane)
+                {
+                    frame[lane] = x + feedback * delayed[(size_t) lane];
+                    output += laneGains[(size_t) lane] * delayed[(size_t) lane];
+                }
+
+                samples[i] = output;
+                writePosition = (writePosition + 1) & mask;
+            }
+
+            writePositions[ch] = writePosition;
+        }
+
+        delays = targets;
+    }
+}
+
+} // namespace UniversalFilterKernels
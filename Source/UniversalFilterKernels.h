@@ -0,0 +1,665 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "BiquadCascade.h"
+#include "BiquadCoefficientCache.h"
+#include "FastMath.h"
+#include "KeyTracker.h"
+#include "STFTAnalysisService.h"
+#include "Waveshapers.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+//==============================================================================
+/**
+    UniversalFilterKernels - One processing kernel per UniversalFilterModule algorithm
+
+    Every kernel is a plain type with the same non-virtual interface:
+
+        void prepare (const juce::dsp::ProcessSpec&);  // allocates, not real-time safe
+        void reset() noexcept;
+        void process (const Context&, const juce::dsp::AudioBlock<float>&) noexcept;
+
+    UniversalFilterModule instantiates a table of these at compile time, one entry
+    per FilterAlgorithm, and only ever creates the kernel of the active algorithm.
+    Kernels redesign their coefficients once per block (or once per control period
+    when modulated) if the parameters they read have changed, so the per-sample
+    loops are straight-line arithmetic. Selections that differ between algorithms
+    sharing a kernel are template parameters resolved with if constexpr.
+*/
+namespace UniversalFilterKernels
+{
+    //==============================================================================
+    /** Every setting of the module; each kernel reads the ones it needs. */
+    struct Parameters
+    {
+        // Tone shaping, harmonic enhancement and dynamics
+        float cutoff = 1000.0f, resonance = 0.5f, amount = 0.5f;
+        float attackMs = 5.0f, releaseMs = 150.0f;
+        float modulationRate = 0.25f, modulationDepth = 0.5f;
+        int triggerCount = 0; // Bumped by UniversalFilterModule::pluck()
+
+        // Fractal
+        int fractalType = 0; float fractalFrequency = 1000.0f, fractalQ = 1.0f; int fractalDepth = 4; float fractalRatio = 0.5f;
+        // Spectral
+        int spectralMode = 0; float spectralFrequency = 1000.0f, spectralBandwidth = 100.0f;
+        // Pluck
+        float pluckDecay = 0.5f, pluckDamping = 0.5f;
+        // Formant
+        float formantKeyTrack = 1.0f, formantGain = 8.0f, formantQ = 8.0f; double formantBaseFrequency = 100.0;
+        // Comb
+        int combCount = 6; float combDelay = 1.0f, combFeedback = 0.7f, combLfoRate = 1.0f, combLfoDepth = 0.5f;
+        // Shaper
+        float shaperCutoff = 1000.0f, shaperResonance = 0.5f, shaperDrive = 0.0f;
+    };
+
+    /** Everything a kernel sees each block besides the audio. */
+    struct Context
+    {
+        const Parameters& parameters;
+        const KeyTracker* keyTracker;               // Null outside the processor
+        STFTAnalysisService::Point* analysisPoint;  // Shared STFT of the slot input, may be null
+    };
+
+    /** Common base so the module can own whichever kernel is active. */
+    struct Kernel
+    {
+        virtual ~Kernel() = default;
+
+        static constexpr int latencySamples = 0; // Hidden by kernels that delay the signal
+    };
+
+    //==============================================================================
+    // Building blocks
+
+    /** One-pole smoothing coefficient for a time constant in milliseconds. */
+    inline float timeToCoefficient (float milliseconds, double sampleRate) noexcept
+    {
+        return 1.0f - std::exp (-1.0f / (juce::jmax (0.01f, milliseconds) * 0.001f * (float) sampleRate));
+    }
+
+    /** Maps 0..1 onto minQ..maxQ logarithmically. */
+    inline float mapQ (float resonance, float minQ, float maxQ) noexcept
+    {
+        return minQ * std::pow (maxQ / minQ, juce::jlimit (0.0f, 1.0f, resonance));
+    }
+
+    /** Transposed direct form II over one channel of samples; state holds two floats. */
+    inline void processBiquad (const Biquad& c, float* state, float* samples, int numSamples) noexcept
+    {
+        float s1 = state[0], s2 = state[1];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float x = samples[i];
+            const float y = c.b0 * x + s1;
+            s1 = c.b1 * x - c.a1 * y + s2;
+            s2 = c.b2 * x - c.a2 * y;
+            samples[i] = y;
+        }
+
+        state[0] = s1;
+        state[1] = s2;
+    }
+
+    /** Zero-delay-feedback state variable filter coefficients (trapezoidal integrators). */
+    struct Svf
+    {
+        float k = 1.4142135f, a1 = 0.0f, a2 = 0.0f, a3 = 0.0f;
+
+        void set (double sampleRate, float frequency, float q) noexcept
+        {
+            const double limited = juce::jlimit (10.0, sampleRate * 0.45, (double) frequency);
+            const float g = (float) std::tan (juce::MathConstants<double>::pi * limited / sampleRate);
+            k = 1.0f / q;
+            a1 = 1.0f / (1.0f + g * (g + k));
+            a2 = g * a1;
+            a3 = g * a2;
+        }
+    };
+
+    struct SvfState
+    {
+        float ic1 = 0.0f, ic2 = 0.0f;
+
+        /** One tick; band is scaled so k * band is the unity-gain bandpass. */
+        void tick (const Svf& c, float x, float& band, float& low) noexcept
+        {
+            const float v3 = x - ic2;
+            band = c.a1 * ic1 + c.a2 * v3;
+            low = ic2 + c.a2 * ic1 + c.a3 * v3;
+            ic1 = 2.0f * band - ic1;
+            ic2 = 2.0f * low - ic2;
+        }
+    };
+
+    /**
+        Third-order Lagrange read from one lane of interleaved delay lines
+        ([position][lane], length mask + 1). The delay must be at least 2 samples;
+        taps n..n+3 are chosen so the fraction stays in [1, 2), where the
+        interpolator is flattest. Branch-free, so lane loops vectorise.
+    */
+    template <int numLanes>
+    inline float readLagrange (const float* lines, int mask, int writePosition, int lane, float delay) noexcept
+    {
+        const int n = (int) delay - 1;
+        const float f = delay - (float) n;
+
+        const float h0 = -(f - 1.0f) * (f - 2.0f) * (f - 3.0f) * (1.0f / 6.0f);
+        const float h1 = f * (f - 2.0f) * (f - 3.0f) * 0.5f;
+        const float h2 = -f * (f - 1.0f) * (f - 3.0f) * 0.5f;
+        const float h3 = f * (f - 1.0f) * (f - 2.0f) * (1.0f / 6.0f);
+
+        const int tap = writePosition - n;
+        return h0 * lines[((tap)     & mask) * numLanes + lane]
+             + h1 * lines[((tap - 1) & mask) * numLanes + lane]
+             + h2 * lines[((tap - 2) & mask) * numLanes + lane]
+             + h3 * lines[((tap - 3) & mask) * numLanes + lane];
+    }
+
+    /** Detects note-ons and manual triggers between blocks; a kernel created mid-note does not fire. */
+    struct TriggerWatch
+    {
+        bool poll (const Context& context) noexcept
+        {
+            const int noteOns = context.keyTracker != nullptr ? context.keyTracker->getNoteOnCount() : 0;
+            const int manual = context.parameters.triggerCount;
+            const bool fired = armed && (noteOns != lastNoteOns || manual != lastManual);
+
+            lastNoteOns = noteOns;
+            lastManual = manual;
+            armed = true;
+            return fired;
+        }
+
+        int lastNoteOns = 0, lastManual = 0;
+        bool armed = false;
+    };
+
+    //==============================================================================
+    // Tone shaping: one or two cascaded state variable stages
+
+    enum class Response { lowpass, highpass, bell };
+
+    struct WarmLowpass    { static constexpr Response response = Response::lowpass;  static constexpr int stages = 1; static constexpr float minQ = 0.5f,   maxQ = 1.5f; };
+    struct BrightLowpass  { static constexpr Response response = Response::lowpass;  static constexpr int stages = 2; static constexpr float minQ = 0.707f, maxQ = 4.0f; };
+    struct GentleHighpass { static constexpr Response response = Response::highpass; static constexpr int stages = 1; static constexpr float minQ = 0.5f,   maxQ = 0.5f; };
+    struct PunchHighpass  { static constexpr Response response = Response::highpass; static constexpr int stages = 1; static constexpr float minQ = 0.707f, maxQ = 3.0f; };
+    struct EmphasisBell   { static constexpr Response response = Response::bell;     static constexpr int stages = 1; static constexpr float minQ = 0.7f,   maxQ = 8.0f; };
+
+    /** cutoff and resonance set the corner; amount is the bell boost, up to +12 dB. */
+    template <typename Tuning>
+    class StateVariableKernel : public Kernel
+    {
+    public:
+        void prepare (const juce::dsp::ProcessSpec& spec)
+        {
+            sampleRate = spec.sampleRate;
+            states.assign (spec.numChannels, {});
+            designedCutoff = -1.0f;
+        }
+
+        void reset() noexcept
+        {
+            std::fill (states.begin(), states.end(), ChannelState {});
+        }
+
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+        {
+            const auto& p = context.parameters;
+            if (p.cutoff != designedCutoff || p.resonance != designedResonance || p.amount != designedAmount)
+                design (p);
+
+            const int numSamples = (int) block.getNumSamples();
+            const size_t numChannels = juce::jmin (block.getNumChannels(), states.size());
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                auto* samples = block.getChannelPointer (ch);
+                auto stageStates = states[ch];
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    float y = samples[i];
+
+                    for (auto& state : stageStates)
+                    {
+                        float band, low;
+                        state.tick (svf, y, band, low);
+
+                        if constexpr (Tuning::response == Response::lowpass)  y = low;
+                        if constexpr (Tuning::response == Response::highpass) y = y - svf.k * band - low;
+                        if constexpr (Tuning::response == Response::bell)     y = y + bellGain * svf.k * band;
+                    }
+
+                    samples[i] = y;
+                }
+
+                states[ch] = stageStates;
+            }
+        }
+
+    private:
+        using ChannelState = std::array<SvfState, Tuning::stages>;
+
+        void design (const Parameters& p) noexcept
+        {
+            svf.set (sampleRate, p.cutoff, mapQ (p.resonance, Tuning::minQ, Tuning::maxQ));
+            bellGain = 3.0f * juce::jlimit (0.0f, 1.0f, p.amount);
+
+            designedCutoff = p.cutoff;
+            designedResonance = p.resonance;
+            designedAmount = p.amount;
+        }
+
+        double sampleRate = 44100.0;
+        Svf svf;
+        float bellGain = 0.0f; // Linear boost minus one
+        float designedCutoff = -1.0f, designedResonance = -1.0f, designedAmount = -1.0f;
+        std::vector<ChannelState> states;
+    };
+
+    //==============================================================================
+    /**
+        Surgical FFT notch (spectralMode 0) or harmonic comb (1) around spectralFrequency.
+
+        True stereo: every channel has its own circular input history and
+        overlap-add accumulator, read and written at moving positions instead of
+        shifting buffers. The per-bin gains are precomputed (interleaved to match
+        the FFT's complex layout) and rebuilt only when the mode, frequency or
+        bandwidth change, then applied with one vector multiply per frame. Frames
+        are Hann windowed on analysis and synthesis and normalised for the 75%
+        overlap, so an all-pass mask reproduces the input fftSize - 1 samples late.
+    */
+    class SpectralKernel : public Kernel
+    {
+    public:
+        static constexpr int fftOrder = 11, fftSize = 1 << fftOrder, hopSize = fftSize / 4;
+        static constexpr int numBins = fftSize / 2 + 1;
+
+        // A frame is resynthesised once its newest sample is in, so its oldest comes out a frame later
+        static constexpr int latencySamples = fftSize - 1;
+
+        SpectralKernel();
+
+        void prepare (const juce::dsp::ProcessSpec& spec);
+        void reset() noexcept;
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    private:
+        static constexpr int accumulatorSize = fftSize * 2; // Keeps a frame's future clear of the run being output
+
+        void updateGains (const Parameters& p) noexcept;
+        void pushInput (const juce::dsp::AudioBlock<float>& block, int start, int length) noexcept;
+        void analyseChannel (int channel, int nextPosition) noexcept;
+        void resynthesiseChannel (int channel, int lastPosition) noexcept;
+        void writeOutput (const juce::dsp::AudioBlock<float>& block, int start, int length) noexcept;
+
+        double sampleRate = 44100.0;
+        juce::dsp::FFT fft { fftOrder };
+        std::array<float, fftSize> analysisWindow {}, synthesisWindow {}; // Synthesis includes the overlap normalisation
+        std::array<float, fftSize * 2> workspace {};
+
+        std::array<float, numBins * 2> binGains {}; // Same gain for the real and imaginary part of each bin
+        int gainsMode = -1;
+        float gainsFrequency = -1.0f, gainsBandwidth = -1.0f;
+
+        int numChannels = 0;
+        std::vector<float> inputHistory; // [channel][fftSize], newest sample at position & (fftSize - 1)
+        std::vector<float> accumulators; // [channel][accumulatorSize], read and cleared at position
+        int position = 0, samplesSinceHop = 0;
+    };
+
+    //==============================================================================
+    /** Full-wave rectified band around cutoff (an octave up), DC blocked and mixed in by amount. */
+    class UptoneKernel : public Kernel
+    {
+    public:
+        void prepare (const juce::dsp::ProcessSpec& spec);
+        void reset() noexcept;
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    private:
+        struct ChannelState { SvfState band; float dcInput = 0.0f, dcOutput = 0.0f; };
+
+        double sampleRate = 44100.0;
+        Svf svf;
+        float designedCutoff = -1.0f;
+        float dcCoefficient = 0.999f;
+        std::vector<ChannelState> states;
+    };
+
+    /** Isolates 20-60 Hz with a highpass/lowpass pair and adds it back, up to +9.5 dB at amount 1. */
+    class SubBassKernel : public Kernel
+    {
+    public:
+        void prepare (const juce::dsp::ProcessSpec& spec);
+        void reset() noexcept;
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    private:
+        struct ChannelState { SvfState lowpass, highpass; };
+
+        Svf lowpass, highpass;
+        std::vector<ChannelState> states;
+    };
+
+    /** Three key-tracked peaking resonances at vowel-like formant frequencies. */
+    class FormantKernel : public Kernel
+    {
+    public:
+        void prepare (const juce::dsp::ProcessSpec& spec);
+        void reset() noexcept;
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    private:
+        static constexpr int numFormants = 3;
+        static constexpr std::array<float, numFormants> baseFormants { 350.0f, 1200.0f, 2400.0f };
+
+        double sampleRate = 44100.0;
+        std::array<Biquad, numFormants> coefficients;
+        std::vector<std::array<float, numFormants * 2>> states;
+
+        float designedKeyFrequency = -1.0f, designedKeyTrack = -1.0f, designedGain = 0.0f, designedQ = 0.0f;
+        double designedBaseFrequency = 0.0;
+    };
+
+    /** First-order tilt around cutoff: amount 0 tilts 6 dB towards the lows, 1 towards the highs. */
+    class TiltKernel : public Kernel
+    {
+    public:
+        void prepare (const juce::dsp::ProcessSpec& spec);
+        void reset() noexcept;
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    private:
+        double sampleRate = 44100.0;
+        float designedCutoff = -1.0f, designedAmount = -1.0f;
+        float coefficient = 0.0f, lowGain = 1.0f, highGain = 1.0f;
+        std::vector<float> states;
+    };
+
+    //==============================================================================
+    // Dynamics
+
+    /** Lowpass whose cutoff rises with each channel's envelope, by up to four octaves at amount 1. */
+    class EnvelopeTrackKernel : public Kernel
+    {
+    public:
+        void prepare (const juce::dsp::ProcessSpec& spec);
+        void reset() noexcept;
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    private:
+        static constexpr int controlPeriod = 16; // Samples between cutoff updates
+
+        struct ChannelState { SvfState svf; float envelope = 0.0f; };
+
+        double sampleRate = 44100.0;
+        std::vector<ChannelState> states;
+    };
+
+    /**
+        Pool of Karplus-Strong strings mixed in by amount. Every note-on plucks a
+        string at its own pitch and velocity, at its sample position in the block;
+        pluck() plucks one at the tracked key.
+
+        The voices are lanes of one loop over interleaved delay lines
+        ([position][voice]), read through the comb bank's Lagrange interpolator
+        with the loop filter's delay subtracted, so strings are in tune to a
+        fraction of a cent. A note takes an idle voice or steals the oldest.
+        Strings that decay below -80 dB go idle, and while every voice is idle
+        the kernel returns without touching the block. Excitation noise comes
+        from a per-instance xorshift generator.
+    */
+    class PluckKernel : public Kernel
+    {
+    public:
+        static constexpr int numVoices = 8;
+
+        void prepare (const juce::dsp::ProcessSpec& spec);
+        void reset() noexcept;
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    private:
+        using Lanes = std::array<float, numVoices>;
+
+        void startVoice (float frequency, float velocity) noexcept;
+        void render (const juce::dsp::AudioBlock<float>& block, int start, int length) noexcept;
+
+        float nextNoise() noexcept
+        {
+            noiseState ^= noiseState << 13;
+            noiseState ^= noiseState >> 17;
+            noiseState ^= noiseState << 5;
+            return (float) (std::int32_t) noiseState * (1.0f / 2147483648.0f);
+        }
+
+        double sampleRate = 44100.0;
+        int lineLength = 0, mask = 0, writePosition = 0;
+        float maxDelay = 2.0f;
+        std::vector<float> lines; // [lineLength][voice]
+
+        alignas (32) Lanes delays {};     // Loop length minus the loss filter's delay
+        alignas (32) Lanes gains {};      // Velocity while sounding, zero while idle
+        alignas (32) Lanes losses {};     // Loss filter state
+        alignas (32) Lanes peaks {};      // Loudest output since the last idle check
+        std::array<std::uint32_t, numVoices> startTimes {};
+        std::uint32_t clock = 0;
+        int numSounding = 0;
+
+        float damping = 1.0f, feedback = 0.99f, mix = 0.5f; // Per block
+        int lastManualTrigger = 0;
+        bool manualTriggerArmed = false;
+        std::uint32_t noiseState = 0x9e3779b9u;
+    };
+
+    /** Ducks the signal by amount on note-ons or pluck(), recovering over the release time. */
+    class DuckerKernel : public Kernel
+    {
+    public:
+        void prepare (const juce::dsp::ProcessSpec& spec);
+        void reset() noexcept;
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    private:
+        double sampleRate = 44100.0;
+        std::vector<float> gains;
+        float target = 0.0f, duck = 0.0f;
+        TriggerWatch trigger;
+    };
+
+    /** Slow RMS gain rider towards -18 dBFS, within +/-24 dB; amount blends it in. Silence is left alone. */
+    class LevelMatchKernel : public Kernel
+    {
+    public:
+        void prepare (const juce::dsp::ProcessSpec& spec);
+        void reset() noexcept;
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    private:
+        double sampleRate = 44100.0;
+        std::vector<float> gains;
+        float meanSquare = 0.0f, gain = 1.0f;
+    };
+
+    //==============================================================================
+    // Complex algorithms
+
+    /**
+        Saturating state variable lowpass (shaper parameters) whose resonance rises
+        with the envelope by amount.
+
+        A zero-delay-feedback (TPT) SVF per channel whose bandpass integrator is
+        fed back through tanh. The saturator is anti-aliased to first order with
+        its antiderivative log cosh, so high drive stays clean without
+        oversampling. Channels are lanes of one loop, numLanes at a time, with
+        the input driven and the output scaled back so the small-signal gain is
+        unity at any drive.
+    */
+    class RezFilterKernel : public Kernel
+    {
+    public:
+        static constexpr int numLanes = 4;
+
+        void prepare (const juce::dsp::ProcessSpec& spec);
+        void reset() noexcept;
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    private:
+        using Lanes = std::array<float, numLanes>;
+
+        /** Filter state of numLanes consecutive channels. */
+        struct LaneGroup
+        {
+            alignas (16) Lanes ic1 {}, ic2 {}, previousBand {}, envelope {};
+        };
+
+        double sampleRate = 44100.0;
+        int numChannels = 0;
+        std::vector<LaneGroup> groups;
+    };
+
+    /**
+        Parallel feedback combs at the key period plus combDelay, each with its own LFO phase.
+
+        The eight combs are lanes of one loop: delay lines are interleaved per
+        sample ([position][comb]), so every sample writes all eight feedback
+        values contiguously and the per-comb work is fixed-width arithmetic the
+        compiler vectorises. Unused combs run with zero output gain instead of
+        being skipped. Delays are fractional (third-order Lagrange) and the LFO
+        is evaluated once per control period, with each comb's delay ramped
+        linearly across it.
+    */
+    class CombBankKernel : public Kernel
+    {
+    public:
+        static constexpr int maxCombCount = 8;
+
+        void prepare (const juce::dsp::ProcessSpec& spec);
+        void reset() noexcept;
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    private:
+        static constexpr int controlPeriod = 32; // Samples between LFO evaluations
+
+        using Lanes = std::array<float, maxCombCount>;
+
+        double sampleRate = 44100.0;
+        int numChannels = 0, lineLength = 0, mask = 0;
+        float maxDelay = 2.0f;
+        std::vector<float> lines;        // [channel][lineLength][comb]
+        std::vector<int> writePositions; // Per channel, shared by its combs
+        alignas (32) Lanes delays {};    // Delay of each comb in samples at the start of the next period
+        bool delaysValid = false;
+        float lfoPhase = 0.0f;
+    };
+
+    //==============================================================================
+    /**
+        Cascade of up to eight biquads at fractalFrequency, each the previous times
+        fractalRatio, run as one pipelined BiquadCascade pass per channel. The
+        all-pass network forces every stage to an all-pass; the time-variant
+        cascade keeps fractalType and sweeps the whole cascade up to two octaves
+        either way with a sine LFO.
+    */
+    struct AllPassNetwork     { static constexpr bool allPass = true;  static constexpr bool modulated = false; };
+    struct TimeVariantCascade { static constexpr bool allPass = false; static constexpr bool modulated = true;  };
+
+    template <typename Tuning>
+    class FractalKernel : public Kernel
+    {
+    public:
+        static constexpr int maxDepth = BiquadCascade::maxStages;
+
+        void prepare (const juce::dsp::ProcessSpec& spec)
+        {
+            sampleRate = spec.sampleRate;
+            states.assign (spec.numChannels, {});
+            designedFrequency = -1.0f;
+        }
+
+        void reset() noexcept
+        {
+            for (auto& state : states)
+                state.reset();
+
+            lfoPhase = 0.0f;
+        }
+
+        void process (const Context& context, const juce::dsp::AudioBlock<float>& block) noexcept
+        {
+            const auto& p = context.parameters;
+            const int numSamples = (int) block.getNumSamples();
+
+            if constexpr (Tuning::modulated)
+            {
+                const float phaseIncrement = FastMath::twoPi * p.modulationRate / (float) sampleRate;
+                const float octaves = 2.0f * juce::jlimit (0.0f, 1.0f, p.modulationDepth);
+
+                for (int start = 0; start < numSamples; start += controlPeriod)
+                {
+                    const int length = juce::jmin (controlPeriod, numSamples - start);
+
+                    design (p, p.fractalFrequency * FastMath::exp (FastMath::ln2 * octaves * FastMath::sin (lfoPhase)));
+                    processStages (block, start, length);
+
+                    lfoPhase = FastMath::wrapPhase (lfoPhase + phaseIncrement * (float) length);
+                }
+            }
+            else
+            {
+                if (p.fractalFrequency != designedFrequency || p.fractalType != designedType || p.fractalQ != designedQ
+                    || p.fractalDepth != designedDepth || p.fractalRatio != designedRatio)
+                    design (p, p.fractalFrequency);
+
+                processStages (block, 0, numSamples);
+            }
+        }
+
+    private:
+        static constexpr int controlPeriod = 32; // Samples between coefficient updates while modulated
+
+        void design (const Parameters& p, float baseFrequency) noexcept
+        {
+            Biquad::Type type = Biquad::Type::allpass;
+            if constexpr (! Tuning::allPass)
+                type = p.fractalType == 1 ? Biquad::Type::highpass
+                     : p.fractalType == 2 ? Biquad::Type::bandpass
+                                          : Biquad::Type::lowpass;
+
+            coefficients.setNumStages (p.fractalDepth);
+            const BiquadCoefficientCache::Curve curve (type, p.fractalQ);
+            float frequency = baseFrequency;
+
+            for (int i = 0; i < coefficients.numStages; ++i)
+            {
+                coefficients.setStage (i, curve.get (sampleRate, frequency));
+                frequency *= p.fractalRatio;
+            }
+
+            designedFrequency = p.fractalFrequency;
+            designedType = p.fractalType;
+            designedQ = p.fractalQ;
+            designedDepth = p.fractalDepth;
+            designedRatio = p.fractalRatio;
+        }
+
+        void processStages (const juce::dsp::AudioBlock<float>& block, int start, int length) noexcept
+        {
+            const size_t numChannels = juce::jmin (block.getNumChannels(), states.size());
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+                BiquadCascade::process (coefficients, states[ch], block.getChannelPointer (ch) + start, length);
+        }
+
+        double sampleRate = 44100.0;
+        BiquadCascade::Coefficients coefficients;
+        std::vector<BiquadCascade::State> states;
+        float lfoPhase = 0.0f;
+
+        float designedFrequency = -1.0f, designedQ = 0.0f, designedRatio = 0.0f;
+        int designedType = -1, designedDepth = 0;
+    };
+}
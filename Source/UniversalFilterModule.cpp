@@ -1,270 +1,188 @@
 #include "UniversalFilterModule.h"
 
-UniversalFilterModule::UniversalFilterModule()
-    : forwardFFT(fftOrder),
-      window(fftSize, juce::dsp::WindowingFunction<float>::hann),
-      combLfo([](float x) { return std::sin(x); }) // Sine wave for comb LFO
-{
-    fractalFilterChain.resize(8);
-}
-
-void UniversalFilterModule::prepare(const juce::dsp::ProcessSpec& spec)
-{
-    sampleRate = spec.sampleRate;
-
-    // Prepare all DSP components
-    for (auto& f : fractalFilterChain) f.prepare(spec);
-    spectralOutputBuffer.setSize(spec.numChannels, fftSize);
-    pluckDelayLine.prepare(spec);
-    pluckFilter.prepare(spec);
-    for (auto& f : formantFilters) f.prepare(spec);
-    for (auto& d : combDelayLines) d.prepare(spec);
-    combLfo.prepare(spec);
-
-    reset();
-}
+using namespace UniversalFilterKernels;
 
-void UniversalFilterModule::reset()
+namespace
 {
-    for (auto& f : fractalFilterChain) f.reset();
-    fifo.fill(0.0f); fifoIndex = 0; spectralOutputBuffer.clear(); spectralOutputPos = 0;
-    pluckDelayLine.reset(); pluckFilter.reset(); needsToPluck = true;
-    for (auto& f : formantFilters) f.reset();
-    for (auto& d : combDelayLines) d.reset();
-    combLfo.reset();
-
-    fractalNeedsUpdate = true;
-    formantNeedsUpdate = true;
-}
-
-void UniversalFilterModule::process(const juce::dsp::ProcessContextReplacing<float>& context)
-{
-    switch (currentModel)
-    {
-        case Model::Fractal:   processFractal(context);   break;
-        case Model::Spectral:  processSpectral(context);  break;
-        case Model::Pluck:     processPluck(context);     break;
-        case Model::Formant:   processFormant(context);   break;
-        case Model::Comb:      processComb(context);      break;
-        case Model::Shaper:    processShaper(context);    break;
-    }
+    using Algorithm = UniversalFilterModule::FilterAlgorithm;
+    using Stage = UniversalFilterModule::FilterStage;
+
+    //==============================================================================
+    // Kernel type and pipeline stage of every algorithm
+    template <Algorithm> struct AlgorithmTraits;
+
+    template <> struct AlgorithmTraits<Algorithm::LPF_Warm>           { using Type = StateVariableKernel<WarmLowpass>;    static constexpr Stage stage = Stage::Tone_Shaping; };
+    template <> struct AlgorithmTraits<Algorithm::LPF_Bright>         { using Type = StateVariableKernel<BrightLowpass>;  static constexpr Stage stage = Stage::Tone_Shaping; };
+    template <> struct AlgorithmTraits<Algorithm::HPF_Gentle>         { using Type = StateVariableKernel<GentleHighpass>; static constexpr Stage stage = Stage::Tone_Shaping; };
+    template <> struct AlgorithmTraits<Algorithm::HPF_Punch>          { using Type = StateVariableKernel<PunchHighpass>;  static constexpr Stage stage = Stage::Tone_Shaping; };
+    template <> struct AlgorithmTraits<Algorithm::BPF_Emphasis>       { using Type = StateVariableKernel<EmphasisBell>;   static constexpr Stage stage = Stage::Tone_Shaping; };
+    template <> struct AlgorithmTraits<Algorithm::BPF_Notch>          { using Type = SpectralKernel;                      static constexpr Stage stage = Stage::Tone_Shaping; };
+
+    template <> struct AlgorithmTraits<Algorithm::Harmonic_Uptone>    { using Type = UptoneKernel;                        static constexpr Stage stage = Stage::Harmonic_Enhancement; };
+    template <> struct AlgorithmTraits<Algorithm::Sub_Bass_Pump>      { using Type = SubBassKernel;                       static constexpr Stage stage = Stage::Sub_Isolation; };
+    template <> struct AlgorithmTraits<Algorithm::Resonant_Formant>   { using Type = FormantKernel;                       static constexpr Stage stage = Stage::Harmonic_Enhancement; };
+    template <> struct AlgorithmTraits<Algorithm::Spectral_Tilt>      { using Type = TiltKernel;                          static constexpr Stage stage = Stage::Final_Sculpting; };
+
+    template <> struct AlgorithmTraits<Algorithm::Envelope_Track>     { using Type = EnvelopeTrackKernel;                 static constexpr Stage stage = Stage::Dynamic_Processing; };
+    template <> struct AlgorithmTraits<Algorithm::Transient_Boost>    { using Type = PluckKernel;                         static constexpr Stage stage = Stage::Dynamic_Processing; };
+    template <> struct AlgorithmTraits<Algorithm::Sidechain_Compress> { using Type = DuckerKernel;                        static constexpr Stage stage = Stage::Dynamic_Processing; };
+    template <> struct AlgorithmTraits<Algorithm::Level_Match>        { using Type = LevelMatchKernel;                    static constexpr Stage stage = Stage::Dynamic_Processing; };
+
+    template <> struct AlgorithmTraits<Algorithm::MDA_RezFilter>      { using Type = RezFilterKernel;                     static constexpr Stage stage = Stage::Harmonic_Enhancement; };
+    template <> struct AlgorithmTraits<Algorithm::Comb_Filter_Bank>   { using Type = CombBankKernel;                      static constexpr Stage stage = Stage::Harmonic_Enhancement; };
+    template <> struct AlgorithmTraits<Algorithm::All_Pass_Network>   { using Type = FractalKernel<AllPassNetwork>;       static constexpr Stage stage = Stage::Final_Sculpting; };
+    template <> struct AlgorithmTraits<Algorithm::Time_Variant>       { using Type = FractalKernel<TimeVariantCascade>;   static constexpr Stage stage = Stage::Final_Sculpting; };
 }
 
 //==============================================================================
-// --- Parameter Setters ---
-void UniversalFilterModule::setModel(Model newModel) { if (currentModel != newModel) { currentModel = newModel; reset(); } }
-void UniversalFilterModule::pluck() { needsToPluck = true; }
-
-void UniversalFilterModule::setFractalType(int t) { if(fractalFilterType != t) { fractalFilterType = t; fractalNeedsUpdate = true; } }
-void UniversalFilterModule::setFractalFreq(float f) { if(fractalBaseFrequency != f) { fractalBaseFrequency = f; fractalNeedsUpdate = true; } }
-void UniversalFilterModule::setFractalQ(float q) { if(fractalQ != q) { fractalQ = q; fractalNeedsUpdate = true; } }
-void UniversalFilterModule::setFractalDepth(int d) { if(fractalDepth != d) { fractalDepth = d; fractalNeedsUpdate = true; } }
-void UniversalFilterModule::setFractalRatio(float r) { if(fractalRatio != r) { fractalRatio = r; fractalNeedsUpdate = true; } }
-
-void UniversalFilterModule::setSpectralMode(int m) { spectralMode = m; }
-void UniversalFilterModule::setSpectralFreq(float f) { spectralFrequency = f; }
-void UniversalFilterModule::setSpectralBw(float bw) { spectralBandwidth = bw; }
-
-void UniversalFilterModule::setPluckDecay(float d) { if(pluckDecay != d) { pluckDecay = d; updateFilters(); } }
-void UniversalFilterModule::setPluckDamping(float d) { if(pluckDamping != d) { pluckDamping = d; updateFilters(); } }
-
-void UniversalFilterModule::setFormantKeyTrack(float a) { if(formantKeyTrack != a) { formantKeyTrack = a; formantNeedsUpdate = true; } }
-void UniversalFilterModule::setFormantGain(float g) { if(formantGain != g) { formantGain = g; formantNeedsUpdate = true; } }
-void UniversalFilterModule::setFormantQ(float q) { if(formantQ != q) { formantQ = q; formantNeedsUpdate = true; } }
-void UniversalFilterModule::setFormantBaseFreq(double f) { if(formantBaseFrequency != f) { formantBaseFrequency = f; formantNeedsUpdate = true; } }
-
-void UniversalFilterModule::setCombCount(int c) { combCount = c; }
-void UniversalFilterModule::setCombDelay(float d) { combDelay = d; }
-void UniversalFilterModule::setCombFeedback(float fb) { combFeedback = fb; }
-void UniversalFilterModule::setCombLfoRate(float r) { combLfoRate = r; }
-void UniversalFilterModule::setCombLfoDepth(float d) { combLfoDepth = d; }
-
-void UniversalFilterModule::setShaperCutoff(float c) { shaperCutoff = c; }
-void UniversalFilterModule::setShaperResonance(float r) { shaperResonance = r; }
-void UniversalFilterModule::setShaperDrive(float d) { shaperDrive = d; }
-
-//==============================================================================
-// --- Internal Processing & Helper Functions ---
-
-void UniversalFilterModule::processShaper(const juce::dsp::ProcessContextReplacing<float>& context)
+struct UniversalFilterModule::AlgorithmEntry
 {
-    auto& block = context.getOutputBlock();
-    auto numSamples = block.getNumSamples();
-    auto numChannels = block.getNumChannels();
-
-    // Calculate filter coefficients from parameters
-    float f = 2.0f * std::sin(juce::MathConstants<float>::pi * shaperCutoff / (float)sampleRate);
-    float q = 1.0f - shaperResonance;
-    q = juce::jlimit(0.01f, 1.0f, q);
-
-    for (size_t ch = 0; ch < numChannels; ++ch)
+    std::unique_ptr<Kernel> (*create)();
+    void (*prepare) (Kernel&, const juce::dsp::ProcessSpec&);
+    void (*reset) (Kernel&);
+    void (*process) (Kernel&, const Context&, const juce::dsp::AudioBlock<float>&);
+    FilterStage stage;
+    int latencySamples;
+
+    /** Entry points of one algorithm, each a direct call into its kernel type. */
+    template <FilterAlgorithm algorithm>
+    static constexpr AlgorithmEntry make()
     {
-        auto* samples = block.getChannelPointer(ch);
-        for (size_t i = 0; i < numSamples; ++i)
-        {
-            float input = samples[i];
-
-            // Standard state-variable filter topology
-            float low = s2 + f * s1;
-            float high = input - low - q * s1;
-            float band = f * high + s1;
-
-            // --- The non-linear part ---
-            // Apply drive and waveshaper to the bandpass output before feeding it back
-            float shapedBand = std::tanh(band * (1.0f + shaperDrive * 5.0f));
-
-            // Update state variables using the shaped signal
-            s1 = f * high + shapedBand;
-            s2 = low;
-
-            // Output the low-pass signal
-            samples[i] = low;
-        }
+        using KernelType = typename AlgorithmTraits<algorithm>::Type;
+
+        return { [] () -> std::unique_ptr<Kernel> { return std::make_unique<KernelType>(); },
+                 [] (Kernel& k, const juce::dsp::ProcessSpec& spec) { static_cast<KernelType&> (k).prepare (spec); },
+                 [] (Kernel& k) { static_cast<KernelType&> (k).reset(); },
+                 [] (Kernel& k, const Context& c, const juce::dsp::AudioBlock<float>& b) { static_cast<KernelType&> (k).process (c, b); },
+                 AlgorithmTraits<algorithm>::stage,
+                 KernelType::latencySamples };
     }
-}
 
-void UniversalFilterModule::updateFilters()
-{
-    // Fractal
-    if (fractalNeedsUpdate)
+    /** One entry per algorithm, indexed by its enum value. */
+    template <int... indices>
+    static constexpr std::array<AlgorithmEntry, sizeof... (indices)> makeTable (std::integer_sequence<int, indices...>)
     {
-        float currentFreq = fractalBaseFrequency;
-        for (int i = 0; i < fractalDepth; ++i)
-        {
-            switch (fractalFilterType) {
-                case 0: *fractalFilterChain[i].coefficients = *juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, currentFreq, fractalQ); break;
-                case 1: *fractalFilterChain[i].coefficients = *juce::dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, currentFreq, fractalQ); break;
-                case 2: *fractalFilterChain[i].coefficients = *juce::dsp::IIR::Coefficients<float>::makeBandPass(sampleRate, currentFreq, fractalQ); break;
-            }
-            currentFreq *= fractalRatio;
-        }
-        fractalNeedsUpdate = false;
+        return { { make<static_cast<FilterAlgorithm> (indices)>()... } };
     }
+};
 
-    // Pluck
-    auto pluckCutoff = juce::jmap(pluckDecay, 0.0f, 1.0f, 8000.0f, 100.0f);
-    auto pluckQ = juce::jmap(pluckDamping, 0.0f, 1.0f, 0.707f, 2.0f);
-    *pluckFilter.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, pluckCutoff, pluckQ);
+const UniversalFilterModule::AlgorithmEntry& UniversalFilterModule::getEntry (FilterAlgorithm algorithm)
+{
+    static constexpr auto table = AlgorithmEntry::makeTable (std::make_integer_sequence<int, numAlgorithms>());
+    return table[(size_t) algorithm];
+}
 
-    // Formant
-    if (formantNeedsUpdate && keyTracker != nullptr)
-    {
-        double currentKeyFreq = keyTracker->getCurrentFrequency();
-        double baseFreqRatio = currentKeyFreq / formantBaseFrequency;
-        double tracking = juce::jlimit(0.0, 1.0, (double)formantKeyTrack);
-        double scaleFactor = juce::jmap(tracking, 1.0, baseFreqRatio);
-
-        for (int i = 0; i < numFormants; ++i)
-        {
-            double formantFreq = baseFormants[i] * scaleFactor;
-            formantFreq = juce::jlimit(20.0, sampleRate / 2.1, formantFreq);
-            *formantFilters[i].coefficients = *juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, (float)formantFreq, formantQ, juce::Decibels::decibelsToGain(formantGain));
-        }
-        formantNeedsUpdate = false;
-    }
+UniversalFilterModule::FilterStage UniversalFilterModule::getStage (FilterAlgorithm algorithm)
+{
+    return getEntry (algorithm).stage;
 }
 
-void UniversalFilterModule::processFractal(const juce::dsp::ProcessContextReplacing<float>& context)
+int UniversalFilterModule::getLatencySamples() const
 {
-    if (fractalNeedsUpdate) updateFilters();
-    for (int i = 0; i < fractalDepth; ++i) fractalFilterChain[i].process(context);
+    return activeEntry->latencySamples;
 }
 
-void UniversalFilterModule::processSpectral(const juce::dsp::ProcessContextReplacing<float>& context)
+//==============================================================================
+UniversalFilterModule::UniversalFilterModule()
+    : activeEntry (&getEntry (currentModel))
 {
-    auto& inputBlock = context.getInputBlock();
-    auto& outputBlock = context.getOutputBlock();
-    for (size_t i = 0; i < inputBlock.getNumSamples(); ++i)
-    {
-        float inputSample = 0.0f;
-        for (size_t ch = 0; ch < inputBlock.getNumChannels(); ++ch) inputSample += inputBlock.getSample(ch, i);
-        inputSample /= static_cast<float>(inputBlock.getNumChannels());
-
-        fifo[fifoIndex] = inputSample;
-        if (++fifoIndex >= hopSize)
-        {
-            fifoIndex = 0;
-            std::rotate(fifo.begin(), fifo.begin() + hopSize, fifo.end());
-            std::copy(fifo.begin() + (fftSize - hopSize), fifo.end(), fftBuffer.begin());
-            window.multiplyWithWindowingTable(fftBuffer.data(), fftSize);
-            std::copy(fftBuffer.begin(), fftBuffer.end(), workspace.begin());
-            forwardFFT.performRealOnlyForwardTransform(workspace.data());
-
-            const float binWidth = (float)sampleRate / fftSize;
-            for (int j = 0; j < fftSize / 2; ++j)
-            {
-                const float currentFreq = j * binWidth;
-                if (spectralMode == 0) { // Notch
-                    if (std::abs(currentFreq - spectralFrequency) < spectralBandwidth / 2.0f) {
-                        workspace[j * 2] = workspace[j * 2 + 1] = 0.0f;
-                    }
-                } else { // Comb
-                    const float harmonicRatio = currentFreq / spectralFrequency;
-                    if (std::abs(harmonicRatio - std::round(harmonicRatio)) * spectralFrequency < spectralBandwidth / 2.0f) {
-                        workspace[j * 2] *= 1.5f; workspace[j * 2 + 1] *= 1.5f;
-                    } else {
-                        workspace[j * 2] *= 0.5f; workspace[j * 2 + 1] *= 0.5f;
-                    }
-                }
-            }
-            forwardFFT.performRealOnlyInverseTransform(workspace.data());
-            for (int j = 0; j < fftSize; ++j) spectralOutputBuffer.addSample(0, (spectralOutputPos + j) % fftSize, workspace[j]);
-        }
-
-        float outputSample = spectralOutputBuffer.getSample(0, spectralOutputPos);
-        spectralOutputBuffer.setSample(0, spectralOutputPos, 0.0f);
-        spectralOutputPos = (spectralOutputPos + 1) % fftSize;
-        for (size_t ch = 0; ch < outputBlock.getNumChannels(); ++ch) outputBlock.setSample(ch, i, outputSample);
-    }
+    kernel = activeEntry->create();
 }
 
-void UniversalFilterModule::processPluck(const juce::dsp::ProcessContextReplacing<float>& context)
+UniversalFilterModule::~UniversalFilterModule() = default;
+
+void UniversalFilterModule::prepare(const juce::dsp::ProcessSpec& spec)
 {
-    if (needsToPluck) {
-        if (keyTracker == nullptr) return;
-        const float freq = juce::jlimit(20.0f, 20000.0f, (float)keyTracker->getCurrentFrequency());
-        const int delaySamples = static_cast<int>(sampleRate / freq);
-        pluckDelayLine.setDelay(delaySamples);
-        for (int i = 0; i < delaySamples; ++i) pluckDelayLine.pushSample(0, juce::Random::getSystemRandom().nextFloat() * 2.0f - 1.0f);
-        needsToPluck = false;
-    }
+    const juce::SpinLock::ScopedLockType lock (kernelLock);
 
-    auto& outputBlock = context.getOutputBlock();
-    for (size_t i = 0; i < outputBlock.getNumSamples(); ++i)
-    {
-        float delayedSample = pluckDelayLine.popSample(0);
-        float filteredSample = filter.processSample(delayedSample);
-        pluckDelayLine.pushSample(0, filteredSample * 0.995f); // Damping
-        for (size_t ch = 0; ch < outputBlock.getNumChannels(); ++ch) outputBlock.setSample(ch, i, delayedSample);
-    }
+    preparedSpec = spec;
+    isPrepared = true;
+    activeEntry->prepare (*kernel, spec);
 }
 
-void UniversalFilterModule::processFormant(const juce::dsp::ProcessContextReplacing<float>& context)
+void UniversalFilterModule::reset()
 {
-    if (formantNeedsUpdate) updateFilters();
-    for (auto& f : formantFilters) f.process(context);
+    const juce::SpinLock::ScopedLockType lock (kernelLock);
+    activeEntry->reset (*kernel);
 }
 
-void UniversalFilterModule::processComb(const juce::dsp::ProcessContextReplacing<float>& context)
+void UniversalFilterModule::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    // Only contended while setModel() swaps in a prepared kernel; pass that block through
+    const juce::SpinLock::ScopedTryLockType lock (kernelLock);
+    if (! lock.isLocked())
+        return;
+
+    const Context kernelContext { parameters, keyTracker, analysisPoint };
+    activeEntry->process (*kernel, kernelContext, context.getOutputBlock());
+}
+
+//==============================================================================
+// --- Parameter Setters ---
+void UniversalFilterModule::setModel(FilterAlgorithm newModel)
 {
-    if (keyTracker == nullptr) return;
-    combLfo.setFrequency(combLfoRate);
-    float lfoSample = combLfo.processSample(0.0f) * combLfoDepth;
+    if (currentModel == newModel)
+        return;
+
+    const int previousLatency = getLatencySamples();
 
-    float baseDelaySamples = (combDelay / 1000.0f) * (float)sampleRate;
-    float keyTrackedFreq = (float)keyTracker->getCurrentFrequency();
-    float keyTrackedDelay = (keyTrackedFreq > 0) ? (float)sampleRate / keyTrackedFreq : 0.0f;
+    // Build the new state here so the audio thread never allocates or waits on a prepare
+    const auto& entry = getEntry (newModel);
+    auto newKernel = entry.create();
+
+    if (isPrepared)
+        entry.prepare (*newKernel, preparedSpec);
 
-    auto& block = context.getOutputBlock();
-    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
     {
-        for (int i = 0; i < combCount; ++i)
-        {
-            float modulatedDelay = baseDelaySamples + lfoSample * 20.0f + keyTrackedDelay;
-            combDelayLines[i].setDelay(modulatedDelay);
-            float delayedSample = combDelayLines[i].popSample(ch);
-            combDelayLines[i].pushSample(ch, block.getSample(ch, 0) + delayedSample * combFeedback);
-            block.setSample(ch, 0, delayedSample);
-        }
+        const juce::SpinLock::ScopedLockType lock (kernelLock);
+        std::swap (kernel, newKernel);
+        activeEntry = &entry;
+        currentModel = newModel;
     }
+
+    // Registers with the shared analysis while the spectral kernel is active, and only then
+    updateAnalysisUser();
+
+    if (getLatencySamples() != previousLatency && onLatencyChanged != nullptr)
+        onLatencyChanged();
+
+    // The previous kernel is released here, outside the lock
 }
+
+void UniversalFilterModule::pluck() { ++parameters.triggerCount; }
+
+void UniversalFilterModule::setCutoff(float c) { parameters.cutoff = c; }
+void UniversalFilterModule::setResonance(float r) { parameters.resonance = r; }
+void UniversalFilterModule::setAmount(float a) { parameters.amount = a; }
+void UniversalFilterModule::setAttack(float ms) { parameters.attackMs = ms; }
+void UniversalFilterModule::setRelease(float ms) { parameters.releaseMs = ms; }
+void UniversalFilterModule::setModulationRate(float r) { parameters.modulationRate = r; }
+void UniversalFilterModule::setModulationDepth(float d) { parameters.modulationDepth = d; }
+
+void UniversalFilterModule::setFractalType(int t) { parameters.fractalType = t; }
+void UniversalFilterModule::setFractalFreq(float f) { parameters.fractalFrequency = f; }
+void UniversalFilterModule::setFractalQ(float q) { parameters.fractalQ = q; }
+void UniversalFilterModule::setFractalDepth(int d) { parameters.fractalDepth = d; }
+void UniversalFilterModule::setFractalRatio(float r) { parameters.fractalRatio = r; }
+
+void UniversalFilterModule::setSpectralMode(int m) { parameters.spectralMode = m; }
+void UniversalFilterModule::setSpectralFreq(float f) { parameters.spectralFrequency = f; }
+void UniversalFilterModule::setSpectralBw(float bw) { parameters.spectralBandwidth = bw; }
+
+void UniversalFilterModule::setPluckDecay(float d) { parameters.pluckDecay = d; }
+void UniversalFilterModule::setPluckDamping(float d) { parameters.pluckDamping = d; }
+
+void UniversalFilterModule::setFormantKeyTrack(float a) { parameters.formantKeyTrack = a; }
+void UniversalFilterModule::setFormantGain(float g) { parameters.formantGain = g; }
+void UniversalFilterModule::setFormantQ(float q) { parameters.formantQ = q; }
+void UniversalFilterModule::setFormantBaseFreq(double f) { parameters.formantBaseFrequency = f; }
+
+void UniversalFilterModule::setCombCount(int c) { parameters.combCount = c; }
+void UniversalFilterModule::setCombDelay(float d) { parameters.combDelay = d; }
+void UniversalFilterModule::setCombFeedback(float fb) { parameters.combFeedback = fb; }
+void UniversalFilterModule::setCombLfoRate(float r) { parameters.combLfoRate = r; }
+void UniversalFilterModule::setCombLfoDepth(float d) { parameters.combLfoDepth = d; }
+
+void UniversalFilterModule::setShaperCutoff(float c) { parameters.shaperCutoff = c; }
+void UniversalFilterModule::setShaperResonance(float r) { parameters.shaperResonance = r; }
+void UniversalFilterModule::setShaperDrive(float d) { parameters.shaperDrive = d; }
@@ -1,12 +1,20 @@
 #pragma once
 
 #include "Module.h"
+#include "UniversalFilterKernels.h"
 #include <juce_dsp/juce_dsp.h>
+#include <memory>
 
 //==============================================================================
 /**
     A universal filter module that can switch between multiple filter models,
     including spectral, physical modeling, and classic filter types.
+
+    Each FilterAlgorithm is its own kernel type (see UniversalFilterKernels.h),
+    reached through a table of template instantiations built at compile time.
+    Only the active algorithm's kernel exists; setModel() builds and prepares
+    the new one off the audio thread and swaps it in, and process() costs one
+    indirect call into the kernel per block.
 */
 class UniversalFilterModule : public FilterModule
 {
@@ -51,18 +59,37 @@ public:
         Dynamic_Processing  // Input-following behaviors
     };
 
+    static constexpr int numAlgorithms = static_cast<int>(FilterAlgorithm::Time_Variant) + 1;
+
+    /** Pipeline stage an algorithm belongs to. */
+    static FilterStage getStage (FilterAlgorithm algorithm);
+
     UniversalFilterModule();
+    ~UniversalFilterModule() override;
 
     void prepare (const juce::dsp::ProcessSpec& spec) override;
     void process (const juce::dsp::ProcessContextReplacing<float>& context) override;
     void reset() override;
 
     const juce::String getName() const override { return "Universal Filter"; }
+    // Only the spectral notch reads the shared STFT
+    bool usesSharedAnalysis() const override { return currentModel == FilterAlgorithm::BPF_Notch; }
+
+    // Depends on the algorithm: the spectral notch delays by its FFT frame, the rest are zero latency
+    int getLatencySamples() const override;
 
     //==============================================================================
     // --- Parameter Setters ---
+    /** Creates and prepares the new algorithm's kernel. Allocates, so not real-time safe.
+        May change getLatencySamples(). */
     void setModel (FilterAlgorithm newModel);
-    void pluck(); // Special trigger for Pluck model
+    void pluck(); // Triggers the pluck and ducking algorithms as a note-on would
+
+    // Shared by the tone shaping, harmonic and dynamics algorithms
+    void setCutoff(float cutoff); void setResonance(float resonance); void setAmount(float amount);
+    void setAttack(float ms); void setRelease(float ms);
+    // Time variant
+    void setModulationRate(float rate); void setModulationDepth(float depth);
 
     // Fractal
     void setFractalType(int type); void setFractalFreq(float freq); void setFractalQ(float q); void setFractalDepth(int depth); void setFractalRatio(float ratio);
@@ -82,57 +109,21 @@ public:
 
 private:
     //==============================================================================
-    // --- Internal Processing Functions ---
-    void processFractal(const juce::dsp::ProcessContextReplacing<float>& context);
-    void processSpectral(const juce::dsp::ProcessContextReplacing<float>& context);
-    void processPluck(const juce::dsp::ProcessContextReplacing<float>& context);
-    void processFormant(const juce::dsp::ProcessContextReplacing<float>& context);
-    void processComb(const juce::dsp::ProcessContextReplacing<float>& context);
-    void processShaper(const juce::dsp::ProcessContextReplacing<float>& context);
-
-    void updateFilters();
+    struct AlgorithmEntry; // Kernel factory and entry points of one algorithm
+    static const AlgorithmEntry& getEntry (FilterAlgorithm algorithm);
 
     //==============================================================================
     // --- State & Parameters ---
-    double sampleRate = 44100.0;
     FilterAlgorithm currentModel = FilterAlgorithm::LPF_Warm;
+    UniversalFilterKernels::Parameters parameters;
 
-    // --- DSP Components & Parameters for All Models ---
+    // Kernel of currentModel only; setModel() holds the lock just to swap, process() try-locks
+    std::unique_ptr<UniversalFilterKernels::Kernel> kernel;
+    const AlgorithmEntry* activeEntry = nullptr;
+    juce::SpinLock kernelLock;
 
-    // Fractal
-    std::vector<juce::dsp::IIR::Filter<float>> fractalFilterChain;
-    int fractalFilterType = 0; float fractalBaseFrequency = 1000.0f; float fractalQ = 1.0f; int fractalDepth = 4; float fractalRatio = 0.5f;
-    bool fractalNeedsUpdate = true;
-
-    // Spectral
-    static constexpr int fftOrder = 11, fftSize = 1 << fftOrder, hopSize = fftSize / 4;
-    juce::dsp::FFT forwardFFT;
-    juce::dsp::WindowingFunction<float> window;
-    std::array<float, fftSize> fftBuffer, fifo;
-    std::array<float, fftSize * 2> workspace;
-    juce::AudioBuffer<float> spectralOutputBuffer;
-    int fifoIndex = 0, spectralOutputPos = 0;
-    int spectralMode = 0; float spectralFrequency = 1000.0f; float spectralBandwidth = 100.0f;
+    juce::dsp::ProcessSpec preparedSpec { 44100.0, 512, 2 };
+    bool isPrepared = false;
 
-    // Pluck
-    juce::dsp::DelayLine<float> pluckDelayLine { 44100 };
-    juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>> pluckFilter;
-    bool needsToPluck = true; float pluckDecay = 0.5f; float pluckDamping = 0.5f;
-
-    // Formant (from FormantTracker)
-    static constexpr int numFormants = 3;
-    std::array<juce::dsp::IIR::Filter<float>, numFormants> formantFilters;
-    std::array<double, 3> baseFormants = {350.0, 1200.0, 2400.0}; 
-    float formantKeyTrack = 1.0f; float formantGain = 8.0f; float formantQ = 8.0f; double formantBaseFrequency = 100.0;
-    bool formantNeedsUpdate = true;
-
-    // Comb (from CombStack)
-    static constexpr int maxCombCount = 8;
-    std::array<juce::dsp::DelayLine<float>, maxCombCount> combDelayLines;
-    juce::dsp::Oscillator<float> combLfo;
-    int combCount = 6; float combDelay = 1.0f; float combFeedback = 0.7f; float combLfoRate = 1.0f; float combLfoDepth = 0.5f;
-
-    // Shaper
-    float shaperCutoff = 1000.0f, shaperResonance = 0.5f, shaperDrive = 0.0f;
-    float s1 = 0.0f, s2 = 0.0f; // State variables for manual SVF
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (UniversalFilterModule)
 };
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <cmath>
+
+//==============================================================================
+/**
+    WaveDigitalFilter - Wave digital circuit models of diode clipping stages
+
+    Header-only, so the models inline into the caller's sample loop. Diodes are
+    never iterated per sample: their reflection is solved exactly through the
+    Wright omega function when the circuit is prepared, and the sample loop
+    reads the result back from tables.
+*/
+namespace WaveDigitalFilter
+{
+    /** Shockley model of a silicon diode. */
+    struct Diode
+    {
+        float saturationCurrent;    // Is, in amps
+        float idealityFactor;       // n
+    };
+
+    /** 1N914, the clipping diode of both the ProCo RAT and the Tube Screamer. */
+    static constexpr Diode diode1N914 { 2.52e-9f, 1.752f };
+
+    /** Thermal voltage at room temperature, in volts. */
+    static constexpr double thermalVoltage = 0.02585;
+
+    /** The Wright omega function: the w that solves w + log (w) = x, to about 1e-8
+        relative. For building tables, not for the sample loop. */
+    inline double wrightOmega (double x) noexcept
+    {
+        double w = x > 1.0 ? x - std::log (x) : std::exp (x);
+
+        for (int i = 0; i < 4; ++i)
+            w -= (w + std::log (w) - x) / (1.0 + 1.0 / w);
+
+        return w;
+    }
+
+    //==============================================================================
+    /**
+        DiodePair - Antiparallel diode pair at the root of a wave digital filter
+
+        For an incident wave a at a port of resistance R, the root voltage is
+        a - Vt w(log (R Is / Vt) + a / Vt + R Is / Vt) + R Is (Werner et al., "An
+        Improved and Generalized Diode Clipper Model for Wave Digital Filters",
+        AES 2015). It is odd in a and smooth, so it is tabulated for a >= 0 on a
+        fine grid up to 4 V, where the diodes turn on, and a coarse one up to
+        128 V, and interpolated linearly; the result stays within about 0.1 mV
+        of the exact solution. The reflected wave is twice the voltage minus a.
+    */
+    class DiodePair
+    {
+    public:
+        /** Tabulates the pair for a port resistance. Not for every sample: this solves
+            the diode equation at every grid point. */
+        void setPortResistance (double portResistance, Diode diode = diode1N914) noexcept
+        {
+            const double vt = thermalVoltage * diode.idealityFactor;
+            const double rIs = portResistance * diode.saturationCurrent;
+            const double offset = std::log (rIs / vt) + rIs / vt;
+
+            for (int k = 0; k < tableSize; ++k)
+            {
+                const double a = k < finePoints ? k / finePointsPerVolt
+                                                : fineRange + (k - finePoints) / coarsePointsPerVolt;
+                rootVoltages[(size_t) k] = (float) (a - vt * wrightOmega (offset + a / vt) + rIs);
+            }
+        }
+
+        /** Voltage across the pair for an incident wave a. */
+        float getVoltage (float a) const noexcept
+        {
+            int index;
+            float t;
+            locate (a, index, t);
+            return std::copysign (interpolate (index, t), a);
+        }
+
+        /** Grid point below |a| and the fraction of the way to the next one. Pure
+            arithmetic, so loops of it vectorise. */
+        static void locate (float a, int& index, float& t) noexcept
+        {
+            const float magnitude = std::abs (a);
+            const float position = std::min (maxPosition, std::min (magnitude, (float) fineRange) * (float) finePointsPerVolt
+                                                          + std::max (magnitude - (float) fineRange, 0.0f) * (float) coarsePointsPerVolt);
+            index = (int) position;
+            t = position - (float) index;
+        }
+
+        /** Voltage at |a| from what locate() found; copy the sign of a onto it. */
+        float interpolate (int index, float t) const noexcept
+        {
+            const float* table = rootVoltages.data();
+            return table[index] + t * (table[index + 1] - table[index]);
+        }
+
+    private:
+        static constexpr double fineRange = 4.0;            // Volts
+        static constexpr double finePointsPerVolt = 256.0;
+        static constexpr double coarsePointsPerVolt = 2.0;
+        static constexpr int finePoints = 1024;             // fineRange * finePointsPerVolt
+        static constexpr int tableSize = finePoints + 249;  // Up to 128 V, plus the last point's neighbour
+        static constexpr float maxPosition = (float) (tableSize - 2) + 0.999f;
+
+        std::array<float, tableSize> rootVoltages {};
+    };
+
+    //==============================================================================
+    /**
+        ResistiveClipper - Voltage source with series resistance into an
+        antiparallel diode pair to ground
+
+        The source is the only child of the root, so the circuit has no memory: the
+        incident wave is the source voltage itself. With no recursion, the grid
+        positions of a whole chunk are found in one vectorised pass, leaving only
+        the table reads to a second one.
+    */
+    class ResistiveClipper
+    {
+    public:
+        void prepare (float resistance, Diode diode = diode1N914) noexcept
+        {
+            diodes.setPortResistance (juce::jmax (1.0f, resistance), diode);
+        }
+
+        /** Source voltages in, voltages across the diodes out. */
+        void process (float* __restrict samples, int numSamples) const noexcept
+        {
+            constexpr int chunkSize = 64;
+            alignas (16) int indices[chunkSize];
+            alignas (16) float fractions[chunkSize];
+
+            for (int start = 0; start < numSamples; start += chunkSize)
+            {
+                const int n = std::min (chunkSize, numSamples - start);
+                float* chunk = samples + start;
+
+                for (int i = 0; i < n; ++i)
+                    DiodePair::locate (chunk[i], indices[i], fractions[i]);
+
+                for (int i = 0; i < n; ++i)
+                    chunk[i] = std::copysign (diodes.interpolate (indices[i], fractions[i]), chunk[i]);
+            }
+        }
+
+    private:
+        DiodePair diodes;
+    };
+
+    //==============================================================================
+    /**
+        DiodeClipper - Voltage source with series resistance, shunt capacitor and an
+        antiparallel diode pair to ground
+
+            Vs --[ R ]--+-------+------ out
+                        |       |
+                        C     D1 D2
+                        |       |
+                       GND     GND
+
+        A parallel adaptor joins the resistive source and the bilinear-transformed
+        capacitor, with the diode pair at the root. Templated on the lane count:
+        lanes are channels, each call advances every lane by one sample in a
+        fixed-width loop, and the capacitor state of each lane lives with the
+        caller, so one clipper (and its tables) serves any number of channels.
+
+        R can be a pot. prepare() tabulates the diodes at numResistances points
+        spaced evenly in log R across the pot's range, and the sample loop
+        interpolates between the two tables either side of the current setting,
+        within about 0.2 mV of the exact solution, so R can move every sample
+        without anything being solved on the audio thread.
+    */
+    template <int numLanes, int numResistances = 8>
+    class DiodeClipper
+    {
+    public:
+        using Lanes = std::array<float, numLanes>;
+
+        /** Where a source resistance falls between the tables, and the adaptor weight
+            that goes with it. Shared by every lane, so find it once per sample. */
+        struct Setting
+        {
+            int table = 0;          // Table below the resistance
+            float t = 0.0f;         // Fraction of the way to the next one
+            float weight = 0.5f;    // Source share of the adaptor's conductance
+        };
+
+        /** Tabulates the diodes across a range of source resistances. Not for the audio
+            thread: this solves the diode equation numResistances times over. */
+        void prepare (double sampleRate, float minResistance, float maxResistance, float capacitance,
+                      Diode diode = diode1N914) noexcept
+        {
+            capacitorResistance = (float) (1.0 / (2.0 * capacitance * sampleRate));
+            lowestResistance = juce::jmax (1.0f, minResistance);
+
+            const double span = std::log (juce::jmax ((double) maxResistance, lowestResistance * 1.001) / lowestResistance);
+            tablesPerLog = (float) ((numResistances - 1) / span);
+
+            for (int k = 0; k < numResistances; ++k)
+            {
+                const double resistance = lowestResistance * std::exp (span * k / (numResistances - 1));
+                tables[(size_t) k].setPortResistance (resistance * capacitorResistance / (resistance + capacitorResistance), diode);
+            }
+        }
+
+        /** Finds the tables and weight for a source resistance, clamped to the range
+            given to prepare(). Cheap enough to call every sample. */
+        Setting locate (float resistance) const noexcept
+        {
+            const float position = juce::jlimit (0.0f, (float) (numResistances - 1) - 0.001f,
+                                                 std::log (resistance / lowestResistance) * tablesPerLog);
+            Setting setting;
+            setting.table = (int) position;
+            setting.t = position - (float) setting.table;
+            setting.weight = capacitorResistance / (juce::jmax (1.0f, resistance) + capacitorResistance);
+            return setting;
+        }
+
+        /** Source voltages in, voltages across the diodes out, one sample per lane.
+            capacitorWaves is the circuit state of the lanes; zero it to reset. */
+        void process (const Setting& setting, Lanes& capacitorWaves, Lanes& voltages) const noexcept
+        {
+            const float weight = setting.weight;
+            const float t = setting.t;
+            const DiodePair& below = tables[(size_t) setting.table];
+            const DiodePair& above = tables[(size_t) setting.table + 1];
+            alignas (16) Lanes waves = capacitorWaves;
+            alignas (16) Lanes out;
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                // The source reflects its voltage, the capacitor the wave it was last sent
+                const float capacitor = waves[(size_t) lane];
+
+                // Up through the adaptor (the conductance-weighted mean of its children),
+                // then back down: every port of a parallel junction sees the root voltage
+                const float a = capacitor + weight * (voltages[(size_t) lane] - capacitor);
+
+                int index;
+                float fraction;
+                DiodePair::locate (a, index, fraction);
+
+                const float low = below.interpolate (index, fraction);
+                const float v = std::copysign (low + t * (above.interpolate (index, fraction) - low), a);
+
+                waves[(size_t) lane] = 2.0f * v - capacitor;
+                out[(size_t) lane] = v;
+            }
+
+            capacitorWaves = waves;
+            voltages = out;
+        }
+
+    private:
+        std::array<DiodePair, (size_t) numResistances> tables;
+
+        float capacitorResistance = 1.0f;
+        float lowestResistance = 1.0f;
+        float tablesPerLog = 1.0f;
+    };
+}
@@ -0,0 +1,480 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "FastMath.h"
+
+//==============================================================================
+/**
+    Waveshapers - Static nonlinearities with antiderivative anti-aliasing (ADAA)
+
+    A curve applied sample by sample makes harmonics above Nyquist that fold
+    back as aliases. ADAA outputs the mean of the curve over the segment
+    between consecutive inputs instead, worked out from its antiderivative,
+    which filters those harmonics before they are sampled (Parker et al.,
+    DAFx 2016; Bilbao et al., "Antiderivative Antialiasing for Memoryless
+    Nonlinearities", IEEE SPL 2017). First order costs one antiderivative per
+    sample and delays by half a sample; second order suppresses aliases
+    further and delays by one. A lot of what 2x-4x oversampling buys, at a
+    fraction of its cost.
+
+    Shapes are types with static apply(), antiderivative1() and
+    antiderivative2(); Processor<Shape, order, T> runs one. Everything is
+    written against Math<T>, so T can be float, double or a
+    juce::dsp::SIMDRegister whose lanes are channels. Nothing branches: the
+    quotients and their fallbacks for inputs too close together are both
+    worked out, with safe denominators, and blended, so block loops vectorise.
+*/
+namespace Waveshapers
+{
+    //==============================================================================
+    /** The operations shapes are written in, per sample type. */
+    template <typename T>
+    struct Math;
+
+    template <>
+    struct Math<float>
+    {
+        using Mask = bool;
+
+        /** Input spacing below which quotients give way to their fallbacks, relative to
+            max (1, |x|) for saturating shapes. Balances cancellation (FastMath is good to
+            about 1e-6) against the fallback error: first order stays within 4e-5 of the
+            double version (1e-3 at the hard clip's corners), second order within 2e-3. */
+        static constexpr float tolerance1 = 1.0e-2f;
+        static constexpr float tolerance2 = 3.0e-2f;
+
+        static float constant (double c) noexcept          { return (float) c; }
+        static float abs (float x) noexcept                 { return std::abs (x); }
+        static float min (float a, float b) noexcept        { return std::min (a, b); }
+        static float max (float a, float b) noexcept        { return std::max (a, b); }
+        static Mask less (float a, float b) noexcept        { return a < b; }
+        static float divide (float a, float b) noexcept     { return a / b; }
+        static float copySign (float magnitude, float sign) noexcept { return std::copysign (magnitude, sign); }
+
+        /** An exact blend rather than a ternary: GCC sinks selected operands into branches
+            and the loop stops vectorising. Both operands must be finite. */
+        static float select (Mask m, float a, float b) noexcept
+        {
+            const float weight = FastMath::select (m, 1.0f, 0.0f);
+            return weight * a + (1.0f - weight) * b;
+        }
+
+        static float exp (float x) noexcept     { return FastMath::exp (x); }
+        static float log (float x) noexcept     { return FastMath::log (x); }
+        static float sin (float x) noexcept     { return FastMath::sin (x); }
+        static float cos (float x) noexcept     { return FastMath::cos (x); }
+        static float tanh (float x) noexcept    { return FastMath::tanh (x); }
+    };
+
+    template <>
+    struct Math<double>
+    {
+        using Mask = bool;
+
+        static constexpr double tolerance1 = 1.0e-5;
+        static constexpr double tolerance2 = 1.0e-3;
+
+        static double constant (double c) noexcept              { return c; }
+        static double abs (double x) noexcept                   { return std::abs (x); }
+        static double min (double a, double b) noexcept         { return std::min (a, b); }
+        static double max (double a, double b) noexcept         { return std::max (a, b); }
+        static Mask less (double a, double b) noexcept          { return a < b; }
+        static double divide (double a, double b) noexcept      { return a / b; }
+        static double copySign (double magnitude, double sign) noexcept { return std::copysign (magnitude, sign); }
+        static double select (Mask m, double a, double b) noexcept      { return m ? a : b; }
+
+        static double exp (double x) noexcept   { return std::exp (std::min (x, 700.0)); }
+        static double log (double x) noexcept   { return std::log (x); }
+        static double sin (double x) noexcept   { return std::sin (x); }
+        static double cos (double x) noexcept   { return std::cos (x); }
+        static double tanh (double x) noexcept  { return std::tanh (x); }
+    };
+
+    /** Lanes are independent signals. Arithmetic and comparisons use the register; division
+        and the transcendental functions run lane by lane through the scalar versions. */
+    template <typename Element>
+    struct Math<juce::dsp::SIMDRegister<Element>>
+    {
+        using T = juce::dsp::SIMDRegister<Element>;
+        using Mask = typename T::vMaskType;
+
+        static constexpr Element tolerance1 = Math<Element>::tolerance1;
+        static constexpr Element tolerance2 = Math<Element>::tolerance2;
+
+        static T constant (double c) noexcept       { return T::expand ((Element) c); }
+        static T abs (T x) noexcept                 { return T::abs (x); }
+        static T min (T a, T b) noexcept            { return T::min (a, b); }
+        static T max (T a, T b) noexcept            { return T::max (a, b); }
+        static Mask less (T a, T b) noexcept        { return T::lessThan (a, b); }
+        static T select (Mask m, T a, T b) noexcept { return (a & m) + (b & ~m); }
+
+        static T copySign (T magnitude, T sign) noexcept
+        {
+            return select (less (sign, constant (0)), constant (0) - magnitude, magnitude);
+        }
+
+        static T divide (T a, T b) noexcept
+        {
+            T result;
+            for (size_t i = 0; i < T::SIMDNumElements; ++i)
+                result.set (i, a.get (i) / b.get (i));
+            return result;
+        }
+
+        static T exp (T x) noexcept     { return lanewise (x, [] (Element e) { return Math<Element>::exp (e); }); }
+        static T log (T x) noexcept     { return lanewise (x, [] (Element e) { return Math<Element>::log (e); }); }
+        static T sin (T x) noexcept     { return lanewise (x, [] (Element e) { return Math<Element>::sin (e); }); }
+        static T cos (T x) noexcept     { return lanewise (x, [] (Element e) { return Math<Element>::cos (e); }); }
+        static T tanh (T x) noexcept    { return lanewise (x, [] (Element e) { return Math<Element>::tanh (e); }); }
+
+    private:
+        template <typename Function>
+        static T lanewise (T x, Function&& function) noexcept
+        {
+            T result;
+            for (size_t i = 0; i < T::SIMDNumElements; ++i)
+                result.set (i, function (x.get (i)));
+            return result;
+        }
+    };
+
+    //==============================================================================
+    // Shapes. Antiderivatives are only defined up to a constant (and the second up to
+    // a linear term); each picks the one that keeps its values smallest, since every
+    // digit of their size is lost again when neighbouring values are differenced.
+    // saturates says they grow with |x| regardless, so tolerances scale with it.
+
+    /** tanh, the smooth saturator. */
+    struct Tanh
+    {
+        static constexpr bool saturates = true;
+
+        template <typename T>
+        static T apply (T x) noexcept { return Math<T>::tanh (x); }
+
+        /** log cosh x, written as |x| + log (1 + e^-2|x|) - log 2 so it cannot overflow. */
+        template <typename T>
+        static T antiderivative1 (T x) noexcept
+        {
+            using M = Math<T>;
+            const T a = M::abs (x);
+            return a + M::log (M::constant (1) + M::exp (a * M::constant (-2))) - M::constant (FastMath::ln2);
+        }
+
+        /** x|x| / 2 - x log 2 + sign (x) (Li2 (-e^-2|x|) + pi^2 / 12) / 2, odd and zero at zero. */
+        template <typename T>
+        static T antiderivative2 (T x) noexcept
+        {
+            using M = Math<T>;
+            const T a = M::abs (x);
+            const T u = M::exp (a * M::constant (-2));
+            const T dilog = negativeDilog (u) - M::constant (dilogAtMinusOne);
+            return M::copySign (a * (a * M::constant (0.5) - M::constant (FastMath::ln2)) + dilog * M::constant (0.5), x);
+        }
+
+    private:
+        // Li2 (-1) = -pi^2 / 12, as the polynomial below has it, so the antiderivative is exactly zero at zero
+        static constexpr double dilogAtMinusOne = -0.82246703588936;
+
+        /** Li2 (-u) for u in [0, 1], within 3e-9. */
+        template <typename T>
+        static T negativeDilog (T u) noexcept
+        {
+            using M = Math<T>;
+            T p = M::constant (-7.5476886256e-4);
+            p = p * u + M::constant (4.4230035822e-3);
+            p = p * u + M::constant (-1.2455900797e-2);
+            p = p * u + M::constant (2.3953679404e-2);
+            p = p * u + M::constant (-3.8830223855e-2);
+            p = p * u + M::constant (6.2289425429e-2);
+            p = p * u + M::constant (-1.1109153893e-1);
+            p = p * u + M::constant (2.4999928374e-1);
+            p = p * u + M::constant (-9.9999999560e-1);
+            return p * u;
+        }
+    };
+
+    /** Clamp to [-1, 1], the harshest of the clippers and the one that aliases worst. */
+    struct HardClip
+    {
+        static constexpr bool saturates = true;
+
+        template <typename T>
+        static T apply (T x) noexcept
+        {
+            using M = Math<T>;
+            return M::min (M::constant (1), M::max (M::constant (-1), x));
+        }
+
+        template <typename T>
+        static T antiderivative1 (T x) noexcept
+        {
+            using M = Math<T>;
+            const T a = M::abs (x);
+            return M::select (M::less (a, M::constant (1)), a * a * M::constant (0.5), a - M::constant (0.5));
+        }
+
+        template <typename T>
+        static T antiderivative2 (T x) noexcept
+        {
+            using M = Math<T>;
+            const T a = M::abs (x);
+            const T inside = a * a * a * M::constant (1.0 / 6.0);
+            const T outside = (a * a - a) * M::constant (0.5) + M::constant (1.0 / 6.0);
+            return M::copySign (M::select (M::less (a, M::constant (1)), inside, outside), x);
+        }
+    };
+
+    /** x / (1 + |x|), a soft clipper with a longer knee than tanh. */
+    struct SoftClip
+    {
+        static constexpr bool saturates = true;
+
+        template <typename T>
+        static T apply (T x) noexcept
+        {
+            using M = Math<T>;
+            return M::divide (x, M::constant (1) + M::abs (x));
+        }
+
+        template <typename T>
+        static T antiderivative1 (T x) noexcept
+        {
+            using M = Math<T>;
+            const T a = M::abs (x);
+            return a - M::log (M::constant (1) + a);
+        }
+
+        template <typename T>
+        static T antiderivative2 (T x) noexcept
+        {
+            using M = Math<T>;
+            const T a = M::abs (x);
+            const T b = M::constant (1) + a;
+            return M::copySign (a * (a * M::constant (0.5) + M::constant (1)) - b * M::log (b), x);
+        }
+    };
+
+    /** sin, the west-coast fold: past +-pi/2 the curve turns back on itself. */
+    struct SineFold
+    {
+        static constexpr bool saturates = false;
+
+        template <typename T>
+        static T apply (T x) noexcept { return Math<T>::sin (x); }
+
+        template <typename T>
+        static T antiderivative1 (T x) noexcept { return Math<T>::constant (0) - Math<T>::cos (x); }
+
+        template <typename T>
+        static T antiderivative2 (T x) noexcept { return Math<T>::constant (0) - Math<T>::sin (x); }
+    };
+
+    //==============================================================================
+    namespace detail
+    {
+        /** (Fa - Fb) / (a - b), the mean of the derivative of F over [b, a], or fallback when a
+            and b are within tolerance of each other and the quotient would be mostly rounding. */
+        template <typename T>
+        T mean (T a, T b, T Fa, T Fb, T tolerance, T fallback) noexcept
+        {
+            using M = Math<T>;
+            const T delta = a - b;
+            const auto close = M::less (M::abs (delta), tolerance);
+            const T quotient = M::divide (Fa - Fb, M::select (close, M::constant (1), delta));
+            return M::select (close, fallback, quotient);
+        }
+
+        /** The input scale the spacing tolerances are relative to. Antiderivatives of
+            saturating shapes grow with |x|, and so does the rounding in their differences. */
+        template <typename Shape, typename T>
+        T scale (T a, T b) noexcept
+        {
+            using M = Math<T>;
+
+            if constexpr (Shape::saturates)
+                return M::max (M::constant (1), M::max (M::abs (a), M::abs (b)));
+            else
+                return M::constant (1);
+        }
+
+        /** Mean of the shape over [x1, x0], from its antiderivative F at both ends. */
+        template <typename Shape, typename T>
+        T firstOrder (T x0, T x1, T F0, T F1) noexcept
+        {
+            using M = Math<T>;
+            const T tolerance = M::constant (M::tolerance1) * scale<Shape> (x0, x1);
+            return mean (x0, x1, F0, F1, tolerance, Shape::apply ((x0 + x1) * M::constant (0.5)));
+        }
+    }
+
+    //==============================================================================
+    /** First-order ADAA from two inputs, for loops that keep their own history (a
+        saturator inside a filter's feedback path, say): the mean of the shape over
+        [previous, x]. Works out both antiderivatives, where Processor reuses the last. */
+    template <typename Shape, typename T>
+    T firstOrder (T x, T previous) noexcept
+    {
+        return detail::firstOrder<Shape> (x, previous, Shape::antiderivative1 (x), Shape::antiderivative1 (previous));
+    }
+
+    //==============================================================================
+    /**
+        Processor - One signal (or one per SIMD lane) through an anti-aliased shape
+
+        process() takes a sample or a block in place; blocks run as a few passes over
+        64-sample chunks that each vectorise for float. setBias() moves the operating
+        point along the curve for asymmetric, even-harmonic shaping, and takes f (bias)
+        back off the output so silence stays silent; any shape can be biased.
+    */
+    template <typename Shape, int order, typename T = float>
+    class Processor
+    {
+        static_assert (order == 1 || order == 2, "ADAA is implemented for first and second order");
+
+        using M = Math<T>;
+
+    public:
+        Processor() noexcept { reset(); }
+
+        /** Offsets the input by bias. Takes effect on the next sample, without a reset. */
+        void setBias (T newBias) noexcept
+        {
+            bias = newBias;
+            biasOutput = Shape::apply (bias);
+        }
+
+        /** Clears the history, as if the input had been silent. */
+        void reset() noexcept
+        {
+            lastInput = secondLastInput = bias;
+            lastAntiderivative = order == 1 ? Shape::antiderivative1 (bias) : Shape::antiderivative2 (bias);
+            lastFirstAntiderivative = lastMean = Shape::antiderivative1 (bias);
+        }
+
+        T process (T x) noexcept
+        {
+            x = x + bias;
+
+            if constexpr (order == 1)
+            {
+                const T F = Shape::antiderivative1 (x);
+                const T y = detail::firstOrder<Shape> (x, lastInput, F, lastAntiderivative);
+                lastInput = x;
+                lastAntiderivative = F;
+                return y - biasOutput;
+            }
+            else
+            {
+                const T F = Shape::antiderivative2 (x);
+                const T G = Shape::antiderivative1 (x);
+                const T m = secondOrderMean (x, lastInput, F, lastAntiderivative, G, lastFirstAntiderivative);
+                const T y = secondOrder (x, lastInput, secondLastInput, lastAntiderivative, m, lastMean);
+                secondLastInput = lastInput;
+                lastInput = x;
+                lastAntiderivative = F;
+                lastFirstAntiderivative = G;
+                lastMean = m;
+                return y - biasOutput;
+            }
+        }
+
+        void process (T* samples, int numSamples) noexcept
+        {
+            constexpr int chunkSize = 64;
+            constexpr int history = order;
+
+            // Inputs, their antiderivatives and (second order) the means of the first
+            // antiderivative, each led by the history carried over from the last chunk
+            T xs[chunkSize + history], Fs[chunkSize + history], Gs[chunkSize + history], means[chunkSize + 1];
+            const T offset = bias, outputOffset = biasOutput;
+
+            for (int start = 0; start < numSamples; start += chunkSize)
+            {
+                const int n = std::min (chunkSize, numSamples - start);
+                T* chunk = samples + start;
+
+                xs[history - 1] = lastInput;
+                Fs[history - 1] = lastAntiderivative;
+
+                for (int i = 0; i < n; ++i)
+                    xs[i + history] = chunk[i] + offset;
+
+                if constexpr (order == 1)
+                {
+                    for (int i = 0; i < n; ++i)
+                        Fs[i + 1] = Shape::antiderivative1 (xs[i + 1]);
+
+                    for (int i = 0; i < n; ++i)
+                        chunk[i] = detail::firstOrder<Shape> (xs[i + 1], xs[i], Fs[i + 1], Fs[i]) - outputOffset;
+                }
+                else
+                {
+                    xs[0] = secondLastInput;
+                    Gs[1] = lastFirstAntiderivative;
+                    means[0] = lastMean;
+
+                    for (int i = 0; i < n; ++i)
+                    {
+                        Fs[i + 2] = Shape::antiderivative2 (xs[i + 2]);
+                        Gs[i + 2] = Shape::antiderivative1 (xs[i + 2]);
+                    }
+
+                    for (int i = 0; i < n; ++i)
+                        means[i + 1] = secondOrderMean (xs[i + 2], xs[i + 1], Fs[i + 2], Fs[i + 1], Gs[i + 2], Gs[i + 1]);
+
+                    for (int i = 0; i < n; ++i)
+                        chunk[i] = secondOrder (xs[i + 2], xs[i + 1], xs[i], Fs[i + 1], means[i + 1], means[i]) - outputOffset;
+
+                    secondLastInput = xs[n];
+                    lastFirstAntiderivative = Gs[n + 1];
+                    lastMean = means[n];
+                }
+
+                lastInput = xs[n + history - 1];
+                lastAntiderivative = Fs[n + history - 1];
+            }
+        }
+
+    private:
+        /** Mean of the first antiderivative G over [x1, x0], from the second F. The fallback
+            is Simpson's rule rather than the midpoint: second order divides these means by
+            the input spacing again, so their errors have to be much smaller. */
+        static T secondOrderMean (T x0, T x1, T F0, T F1, T G0, T G1) noexcept
+        {
+            const T tolerance = M::constant (M::tolerance2) * detail::scale<Shape> (x0, x1);
+            const T simpson = (G0 + G1 + M::constant (4) * Shape::antiderivative1 ((x0 + x1) * M::constant (0.5))) * M::constant (1.0 / 6.0);
+            return detail::mean (x0, x1, F0, F1, tolerance, simpson);
+        }
+
+        /** 2 (mean0 - mean1) / (x0 - x2). When x0 and x2 nearly meet, that is worked out
+            about their midpoint instead; when x1 is close to it too, the curve is read at
+            the centroid of the three, where the triangular kernel puts its weight. F1 is
+            the second antiderivative at x1. */
+        static T secondOrder (T x0, T x1, T x2, T F1, T mean0, T mean1) noexcept
+        {
+            const T tolerance = M::constant (M::tolerance2) * M::max (detail::scale<Shape> (x0, x1), detail::scale<Shape> (x2, x2));
+            const T one = M::constant (1), two = M::constant (2), half = M::constant (0.5);
+
+            const T span = x0 - x2;
+            const auto narrow = M::less (M::abs (span), tolerance);
+            const T regular = M::divide (two * (mean0 - mean1), M::select (narrow, one, span));
+
+            const T midpoint = (x0 + x2) * half;
+            const T delta = midpoint - x1;
+            const auto collapsed = M::less (M::abs (delta), tolerance);
+            const T safeDelta = M::select (collapsed, one, delta);
+            const T skewed = M::divide (two * (Shape::antiderivative1 (midpoint)
+                                               + M::divide (F1 - Shape::antiderivative2 (midpoint), safeDelta)), safeDelta);
+            const T flat = Shape::apply ((x0 + x1 + x2) * M::constant (1.0 / 3.0));
+
+            return M::select (narrow, M::select (collapsed, flat, skewed), regular);
+        }
+
+        T bias = M::constant (0), biasOutput = M::constant (0);
+        T lastInput, secondLastInput;   // Biased
+        T lastAntiderivative;           // The order's antiderivative at lastInput
+        T lastFirstAntiderivative;      // Second order: the first antiderivative at lastInput
+        T lastMean;                     // Second order: mean of the first antiderivative over [secondLastInput, lastInput]
+    };
+}
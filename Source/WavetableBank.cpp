@@ -0,0 +1,127 @@
+#include "WavetableBank.h"
+#include <cstring>
+#include <cmath>
+
+//==============================================================================
+WavetableBank::WavetableBank (std::vector<float> frameData, const juce::String& tableName)
+    : ownedData (std::move (frameData)),
+      name (tableName)
+{
+    numFrames = juce::jlimit (0, maxFrames, (int) (ownedData.size() / frameSize));
+    samples = ownedData.data();
+}
+
+WavetableBank::WavetableBank (std::unique_ptr<juce::MemoryMappedFile> mapped, const float* data, int frames, const juce::String& tableName)
+    : mappedFile (std::move (mapped)),
+      samples (data),
+      numFrames (frames),
+      name (tableName)
+{
+}
+
+//==============================================================================
+std::unique_ptr<WavetableBank> WavetableBank::loadFromCacheFile (const juce::File& cacheFile)
+{
+    if (! cacheFile.existsAsFile())
+        return nullptr;
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile> (cacheFile, juce::MemoryMappedFile::readOnly, false);
+
+    if (mapped->getData() == nullptr || mapped->getSize() < sizeof (CacheHeader))
+        return nullptr;
+
+    CacheHeader header;
+    std::memcpy (&header, mapped->getData(), sizeof (CacheHeader));
+
+    if (std::memcmp (header.magic, "WFWT", 4) != 0
+        || header.version != cacheVersion
+        || header.frameSize != (std::uint32_t) frameSize
+        || header.numFrames == 0
+        || header.numFrames > (std::uint32_t) maxFrames)
+        return nullptr;
+
+    const auto expectedSize = sizeof (CacheHeader) + (size_t) header.numFrames * frameSize * sizeof (float);
+    if (mapped->getSize() < expectedSize)
+        return nullptr;
+
+    auto* data = reinterpret_cast<const float*> (static_cast<const char*> (mapped->getData()) + sizeof (CacheHeader));
+
+    // Cache names are "<source>_<hash>", show only the source part
+    const auto tableName = cacheFile.getFileNameWithoutExtension().upToLastOccurrenceOf ("_", false, false);
+
+    std::unique_ptr<WavetableBank> bank (new WavetableBank (std::move (mapped), data, (int) header.numFrames, tableName));
+    bank->sourcePitchHz = header.sourcePitchHz;
+    return bank;
+}
+
+bool WavetableBank::writeToCacheFile (const juce::File& cacheFile) const
+{
+    if (numFrames == 0)
+        return false;
+
+    cacheFile.getParentDirectory().createDirectory();
+
+    // Write to a temporary file first so a half-written cache is never mapped
+    juce::TemporaryFile temp (cacheFile);
+
+    {
+        juce::FileOutputStream out (temp.getFile());
+        if (! out.openedOk())
+            return false;
+
+        CacheHeader header {};
+        std::memcpy (header.magic, "WFWT", 4);
+        header.version = cacheVersion;
+        header.frameSize = (std::uint32_t) frameSize;
+        header.numFrames = (std::uint32_t) numFrames;
+        header.sourcePitchHz = sourcePitchHz;
+
+        if (! out.write (&header, sizeof (header))
+            || ! out.write (samples, (size_t) numFrames * frameSize * sizeof (float)))
+            return false;
+
+        out.flush();
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+//==============================================================================
+float WavetableBank::getSample (float framePosition, float phase) const noexcept
+{
+    if (numFrames == 0)
+        return 0.0f;
+
+    framePosition = juce::jlimit (0.0f, (float) (numFrames - 1), framePosition);
+    const int frameA = (int) framePosition;
+    const int frameB = juce::jmin (frameA + 1, numFrames - 1);
+    const float frameFrac = framePosition - (float) frameA;
+
+    const int index1 = ((int) phase) & (frameSize - 1);
+    const int index2 = (index1 + 1) & (frameSize - 1);
+    const float frac = phase - std::floor (phase);
+
+    const auto* a = getFrame (frameA);
+    const auto* b = getFrame (frameB);
+
+    const float sampleA = a[index1] + frac * (a[index2] - a[index1]);
+    const float sampleB = b[index1] + frac * (b[index2] - b[index1]);
+
+    return sampleA + frameFrac * (sampleB - sampleA);
+}
+
+//==============================================================================
+juce::File WavetableBank::getCacheFileFor (const juce::File& sourceFile)
+{
+    // Key on path, size and modification time so edited sources re-extract
+    const auto key = sourceFile.getFullPathName()
+                   + juce::String (sourceFile.getSize())
+                   + juce::String (sourceFile.getLastModificationTime().toMilliseconds());
+
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+               .getChildFile ("WubForge")
+               .getChildFile ("WavetableCache")
+               .getChildFile (sourceFile.getFileNameWithoutExtension()
+                              + "_" + juce::String::toHexString (key.hashCode64())
+                              + ".wfwt");
+}
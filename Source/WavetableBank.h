@@ -0,0 +1,76 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+//==============================================================================
+/**
+    WavetableBank - Immutable multi-frame wavetable storage
+
+    Holds up to maxFrames single-cycle frames of frameSize samples each, laid out
+    contiguously so that frame n starts at getFrame (n). The samples either live
+    in an owned vector (generated or freshly extracted tables) or point straight
+    into a memory-mapped cache file, so large libraries load without copying.
+
+    Cache file layout (".wfwt", native-endian float32):
+        Header  (32 bytes) - magic, version, frameSize, numFrames, source pitch
+        Frames  (numFrames * frameSize floats)
+*/
+class WavetableBank
+{
+public:
+    static constexpr int frameSize = 2048;
+    static constexpr int maxFrames = 256;
+
+    /** Creates a bank that owns its sample data (numFrames * frameSize floats). */
+    WavetableBank (std::vector<float> frameData, const juce::String& name);
+
+    /** Maps a cache file written by writeToCacheFile(). Returns nullptr if the file is missing or invalid. */
+    static std::unique_ptr<WavetableBank> loadFromCacheFile (const juce::File& cacheFile);
+
+    /** Writes the bank to disk in the memory-mappable cache format. */
+    bool writeToCacheFile (const juce::File& cacheFile) const;
+
+    //==============================================================================
+    int getNumFrames() const noexcept { return numFrames; }
+    const float* getFrame (int frameIndex) const noexcept { return samples + (size_t) frameIndex * frameSize; }
+    const juce::String& getName() const noexcept { return name; }
+    bool isMemoryMapped() const noexcept { return mappedFile != nullptr; }
+
+    float getSourcePitchHz() const noexcept { return sourcePitchHz; }
+    void setSourcePitchHz (float pitchHz) noexcept { sourcePitchHz = pitchHz; }
+
+    /** Reads the bank at a fractional frame position (0..numFrames-1) and phase (0..frameSize). */
+    float getSample (float framePosition, float phase) const noexcept;
+
+    //==============================================================================
+    /** Returns the cache location used for a given source audio file. */
+    static juce::File getCacheFileFor (const juce::File& sourceFile);
+
+private:
+    WavetableBank (std::unique_ptr<juce::MemoryMappedFile> mapped, const float* data, int frames, const juce::String& name);
+
+    struct CacheHeader
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t frameSize;
+        std::uint32_t numFrames;
+        float sourcePitchHz;
+        std::uint32_t reserved[3];
+    };
+
+    static_assert (sizeof (CacheHeader) == 32, "Cache header must stay 32 bytes so frame data is aligned");
+    static constexpr std::uint32_t cacheVersion = 1;
+
+    std::vector<float> ownedData;
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const float* samples = nullptr;
+    int numFrames = 0;
+    float sourcePitchHz = 0.0f;
+    juce::String name;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableBank)
+};
@@ -0,0 +1,261 @@
+#include "WavetableExtractor.h"
+#include <cmath>
+#include <algorithm>
+
+//==============================================================================
+WavetableExtractor::WavetableExtractor()
+    : juce::Thread ("WubForge Wavetable Extractor")
+{
+}
+
+WavetableExtractor::~WavetableExtractor()
+{
+    stopThread (4000);
+}
+
+void WavetableExtractor::requestExtraction (const juce::File& sourceFile)
+{
+    {
+        const juce::ScopedLock sl (requestLock);
+        pendingFile = sourceFile;
+    }
+
+    if (! isThreadRunning())
+        startThread();
+
+    notify();
+}
+
+void WavetableExtractor::run()
+{
+    while (! threadShouldExit())
+    {
+        juce::File fileToProcess;
+
+        {
+            const juce::ScopedLock sl (requestLock);
+            std::swap (fileToProcess, pendingFile);
+        }
+
+        if (fileToProcess == juce::File())
+        {
+            wait (-1);
+            continue;
+        }
+
+        const auto cacheFile = WavetableBank::getCacheFileFor (fileToProcess);
+        auto bank = WavetableBank::loadFromCacheFile (cacheFile);
+
+        if (bank == nullptr)
+        {
+            bank = extractFromFile (fileToProcess, this);
+
+            // Re-open through the cache so the extracted table is mapped, not held in RAM twice
+            if (bank != nullptr && bank->writeToCacheFile (cacheFile))
+                if (auto mapped = WavetableBank::loadFromCacheFile (cacheFile))
+                    bank = std::move (mapped);
+        }
+
+        if (bank != nullptr && ! threadShouldExit() && onTableReady != nullptr)
+            onTableReady (std::move (bank));
+    }
+}
+
+//==============================================================================
+std::unique_ptr<WavetableBank> WavetableExtractor::extractFromFile (const juce::File& sourceFile, juce::Thread* ownerThread)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (sourceFile));
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+        return nullptr;
+
+    const double sourceRate = reader->sampleRate;
+    const int numSamples = (int) juce::jmin (reader->lengthInSamples, (juce::int64) (maxSourceSeconds * sourceRate));
+    const int numChannels = (int) reader->numChannels;
+
+    juce::AudioBuffer<float> source (numChannels, numSamples);
+    reader->read (&source, 0, numSamples, 0, true, true);
+
+    // Mix down to mono in channel 0
+    for (int ch = 1; ch < numChannels; ++ch)
+        source.addFrom (0, 0, source, ch, 0, numSamples);
+    if (numChannels > 1)
+        source.applyGain (0, 0, numSamples, 1.0f / (float) numChannels);
+
+    const float* mono = source.getReadPointer (0);
+
+    const int minLag = juce::jmax (2, (int) (sourceRate / maxPitchHz));
+    const int maxLag = (int) (sourceRate / minPitchHz);
+    const int windowSize = maxLag;
+    const int analysisLength = windowSize + maxLag + 1;
+
+    // Leave room for the analysis window plus one full period after it
+    const int usable = numSamples - analysisLength - maxLag - 2;
+    if (usable <= 0)
+        return nullptr;
+
+    const int numFrames = juce::jlimit (1, WavetableBank::maxFrames, usable / maxLag);
+    const double frameSpacing = numFrames > 1 ? (double) usable / (double) (numFrames - 1) : 0.0;
+
+    std::vector<float> frames;
+    frames.reserve ((size_t) numFrames * WavetableBank::frameSize);
+
+    std::vector<float> difference;
+    std::vector<float> workspace (WavetableBank::frameSize * 2);
+    juce::dsp::FFT fft (11);
+    static_assert ((1 << 11) == WavetableBank::frameSize, "FFT order must match the wavetable frame size");
+
+    std::vector<float> periods;
+    float lastPeriod = 0.0f;
+
+    for (int frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+    {
+        if (ownerThread != nullptr && ownerThread->threadShouldExit())
+            return nullptr;
+
+        const int position = (int) std::round (frameIndex * frameSpacing);
+        float period = detectPeriod (mono + position, windowSize, minLag, maxLag, difference);
+
+        // Unvoiced region: keep the previous period so the table stays continuous
+        if (period <= 0.0f)
+            period = lastPeriod;
+        if (period <= 0.0f)
+            continue;
+
+        lastPeriod = period;
+        periods.push_back (period);
+
+        // Align the slice on the first rising zero crossing so frames share a start point
+        int start = position;
+        for (int i = position; i < position + (int) period; ++i)
+        {
+            if (mono[i] <= 0.0f && mono[i + 1] > 0.0f)
+            {
+                start = i;
+                break;
+            }
+        }
+
+        // Resample exactly one period into the frame
+        auto frameOffset = frames.size();
+        frames.resize (frameOffset + WavetableBank::frameSize);
+        auto* frame = frames.data() + frameOffset;
+
+        const double step = (double) period / (double) WavetableBank::frameSize;
+        for (int i = 0; i < WavetableBank::frameSize; ++i)
+        {
+            const double readPos = start + i * step;
+            const int index = (int) readPos;
+            const float frac = (float) (readPos - index);
+            frame[i] = mono[index] + frac * (mono[index + 1] - mono[index]);
+        }
+
+        normaliseFramePhase (frame, fft, workspace);
+    }
+
+    if (frames.empty())
+        return nullptr;
+
+    auto bank = std::make_unique<WavetableBank> (std::move (frames), sourceFile.getFileNameWithoutExtension());
+
+    std::sort (periods.begin(), periods.end());
+    bank->setSourcePitchHz ((float) (sourceRate / periods[periods.size() / 2]));
+
+    return bank;
+}
+
+//==============================================================================
+float WavetableExtractor::detectPeriod (const float* data, int windowSize, int minLag, int maxLag, std::vector<float>& difference)
+{
+    // YIN: difference function followed by cumulative mean normalisation
+    difference.assign ((size_t) maxLag + 2, 0.0f);
+
+    for (int lag = 1; lag <= maxLag + 1; ++lag)
+    {
+        float sum = 0.0f;
+        for (int j = 0; j < windowSize; ++j)
+        {
+            const float delta = data[j] - data[j + lag];
+            sum += delta * delta;
+        }
+        difference[(size_t) lag] = sum;
+    }
+
+    difference[0] = 1.0f;
+    float runningSum = 0.0f;
+    for (int lag = 1; lag <= maxLag + 1; ++lag)
+    {
+        runningSum += difference[(size_t) lag];
+        difference[(size_t) lag] = runningSum > 0.0f ? difference[(size_t) lag] * (float) lag / runningSum : 1.0f;
+    }
+
+    int bestLag = -1;
+    for (int lag = minLag; lag <= maxLag; ++lag)
+    {
+        if (difference[(size_t) lag] < yinThreshold)
+        {
+            while (lag + 1 <= maxLag && difference[(size_t) lag + 1] < difference[(size_t) lag])
+                ++lag;
+            bestLag = lag;
+            break;
+        }
+    }
+
+    if (bestLag < 0)
+        return 0.0f;
+
+    // Parabolic interpolation around the minimum for sub-sample accuracy
+    const float a = difference[(size_t) bestLag - 1];
+    const float b = difference[(size_t) bestLag];
+    const float c = difference[(size_t) bestLag + 1];
+    const float denominator = a - 2.0f * b + c;
+    const float offset = std::abs (denominator) > 1.0e-9f ? 0.5f * (a - c) / denominator : 0.0f;
+
+    return (float) bestLag + juce::jlimit (-0.5f, 0.5f, offset);
+}
+
+void WavetableExtractor::normaliseFramePhase (float* frame, juce::dsp::FFT& fft, std::vector<float>& workspace)
+{
+    constexpr int size = WavetableBank::frameSize;
+
+    std::fill (workspace.begin(), workspace.end(), 0.0f);
+    std::copy (frame, frame + size, workspace.begin());
+    fft.performRealOnlyForwardTransform (workspace.data());
+
+    // Rotate every harmonic so the fundamental sits at sine phase (a circular time shift)
+    const float fundamentalPhase = std::atan2 (workspace[3], workspace[2]);
+    const float rotation = -juce::MathConstants<float>::halfPi - fundamentalPhase;
+
+    workspace[0] = workspace[1] = 0.0f; // Remove DC
+
+    for (int bin = 1; bin <= size / 2; ++bin)
+    {
+        const float angle = rotation * (float) bin;
+        const float c = std::cos (angle), s = std::sin (angle);
+        const float re = workspace[(size_t) bin * 2], im = workspace[(size_t) bin * 2 + 1];
+
+        workspace[(size_t) bin * 2]     = re * c - im * s;
+        workspace[(size_t) bin * 2 + 1] = re * s + im * c;
+
+        if (bin < size / 2)
+        {
+            workspace[(size_t) (size - bin) * 2]     =  workspace[(size_t) bin * 2];
+            workspace[(size_t) (size - bin) * 2 + 1] = -workspace[(size_t) bin * 2 + 1];
+        }
+    }
+
+    // Nyquist must stay real
+    workspace[(size_t) size + 1] = 0.0f;
+
+    fft.performRealOnlyInverseTransform (workspace.data());
+
+    float peak = 0.0f;
+    for (int i = 0; i < size; ++i)
+        peak = juce::jmax (peak, std::abs (workspace[(size_t) i]));
+
+    const float gain = peak > 1.0e-6f ? 1.0f / peak : 0.0f;
+    for (int i = 0; i < size; ++i)
+        frame[i] = workspace[(size_t) i] * gain;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_dsp/juce_dsp.h>
+#include <functional>
+#include "WavetableBank.h"
+
+//==============================================================================
+/**
+    WavetableExtractor - Background pitch-synchronous wavetable extraction
+
+    Turns an arbitrary audio file into a multi-frame WavetableBank:
+    1. The file is mixed to mono and scanned at evenly spaced positions
+    2. A YIN pitch estimate at each position gives the local period
+    3. One period, starting on a rising zero crossing, is resampled to a frame
+    4. The frame's FFT is rotated so the fundamental starts at zero phase,
+       which keeps neighbouring frames aligned for click-free morphing
+
+    Results are cached next to the other WubForge user data via
+    WavetableBank::getCacheFileFor(), so a file is only analysed once.
+*/
+class WavetableExtractor : private juce::Thread
+{
+public:
+    WavetableExtractor();
+    ~WavetableExtractor() override;
+
+    /** Queues a file for extraction on the background thread, replacing any pending request. */
+    void requestExtraction (const juce::File& sourceFile);
+
+    /** Called on the extractor thread once a table is available (from cache or newly extracted). */
+    std::function<void (std::unique_ptr<WavetableBank>)> onTableReady;
+
+    /** Extracts a table synchronously. Never call this from the audio thread. */
+    static std::unique_ptr<WavetableBank> extractFromFile (const juce::File& sourceFile,
+                                                           juce::Thread* ownerThread = nullptr);
+
+private:
+    void run() override;
+
+    static float detectPeriod (const float* data, int windowSize, int minLag, int maxLag, std::vector<float>& difference);
+    static void normaliseFramePhase (float* frame, juce::dsp::FFT& fft, std::vector<float>& workspace);
+
+    static constexpr double maxSourceSeconds = 60.0;
+    static constexpr float minPitchHz = 30.0f;
+    static constexpr float maxPitchHz = 2000.0f;
+    static constexpr float yinThreshold = 0.15f;
+
+    juce::CriticalSection requestLock;
+    juce::File pendingFile;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableExtractor)
+};
@@ -4,9 +4,8 @@
 // Constructor
 WavetableFilterModule::WavetableFilterModule()
 {
-    // Initialize wavetable buffer for modulation source
-    wavetable.setSize(1, wavetableSize);
-    wavetable.clear();
+    // Extracted tables arrive on the extractor thread and are handed to the audio thread
+    extractor.onTableReady = [this](std::unique_ptr<WavetableBank> bank) { installBank(std::move(bank)); };
 
     // Initialize complex modulation LFO
     updateLfoShape();
@@ -28,17 +27,30 @@ WavetableFilterModule::WavetableFilterModule()
 }
 
 // Destructor
-WavetableFilterModule::~WavetableFilterModule() = default;
+WavetableFilterModule::~WavetableFilterModule()
+{
+    // An extraction already past its exit check still installs its bank, so wait for
+    // it here, while the members installBank() writes are alive
+    extractor.stopThread(4000);
+    extractor.onTableReady = nullptr;
+}
 
 // AudioModule interface implementation
 void WavetableFilterModule::prepare(const juce::dsp::ProcessSpec& spec)
 {
     sampleRate = spec.sampleRate;
 
-    // Prepare filter
-    filter.prepare(spec);
-    filter.parameters->setCutOffFrequency(sampleRate, baseCutoff, resonance);
-    filter.parameters->type = juce::dsp::StateVariableFilter::Parameters<float>::Type::lowPass;
+    // One filter and phase-modulation layer per channel
+    filters.clear();
+    filters.resize(spec.numChannels);
+    phaseAccumulators.assign(spec.numChannels, 0.0f);
+
+    for (auto& filter : filters) {
+        filter.prepare({ spec.sampleRate, spec.maximumBlockSize, 1 });
+        filter.parameters->setCutOffFrequency(sampleRate, baseCutoff, resonance);
+    }
+
+    setFilterType(filterType);
 
     // Prepare LFO
     lfo.prepare(spec);
@@ -57,24 +69,27 @@ void WavetableFilterModule::process(const juce::dsp::ProcessContextReplacing<flo
     auto inputBlock = context.getInputBlock();
     auto outputBlock = context.getOutputBlock();
     auto numSamples = (int)inputBlock.getNumSamples();
-    auto numChannels = (int)inputBlock.getNumChannels();
+    auto numChannels = juce::jmin((int)inputBlock.getNumChannels(), (int)filters.size());
+
+    // Pick up a newly loaded wavetable, if any
+    swapInPendingBank();
 
-    // Process each channel
-    for (int channel = 0; channel < numChannels; ++channel) {
-        auto* input = inputBlock.getChannelPointer(channel);
-        auto* output = outputBlock.getChannelPointer(channel);
+    // Modulation advances once per sample frame and is shared by the channels, so they
+    // stay in step; only the envelope follows each channel's own input
+    for (int sample = 0; sample < numSamples; ++sample) {
+        float lfoMod = processLfoModulation();
 
-        for (int sample = 0; sample < numSamples; ++sample) {
-            float inputSample = input[sample];
+        for (int channel = 0; channel < numChannels; ++channel) {
+            float inputSample = inputBlock.getChannelPointer(channel)[sample];
 
             // Process envelope follower for input dynamics
             float envelopeLevel = envelopeFollower.processSample(channel, inputSample * envelopeSensitivity);
-
-            // Get complex modular modulation amounts (for evolving digital harmonics)
-            float lfoMod = processLfoModulation();
-            float wtMod = processWavetableModulation();
             float envMod = envelopeLevel * 2.0f - 1.0f; // Convert to bipolar modulation
 
+            // Frame scanning: manual position plus LFO/envelope sweep across the frames
+            float framePosition = juce::jlimit(0.0f, 1.0f, wavetablePosition + scanModDepth * 0.5f * (lfoMod + envMod));
+            float wtMod = processWavetableModulation(framePosition);
+
             // **Complex Digital Harmonic Modulation Algorithm**
             // Create evolving robotic textures through multifaceted modulation
 
@@ -87,7 +102,7 @@ void WavetableFilterModule::process(const juce::dsp::ProcessContextReplacing<flo
             float spectralCutoff = harmonicCutoff * (1.0f + spectralMod * 1.5f);
 
             // Layer 3: Phase-modulated distortion of filter frequency (digital artifacts)
-            static float phaseAccumulator = 0.0f;
+            float& phaseAccumulator = phaseAccumulators[(size_t)channel];
             phaseAccumulator += 0.1f * wavetableIncrement;
             float phaseMod = std::sin(phaseAccumulator * wtMod * 0.5f); // FM-like artifacts
             float finalCutoff = spectralCutoff * (1.0f + phaseMod * 0.3f);
@@ -102,6 +117,7 @@ void WavetableFilterModule::process(const juce::dsp::ProcessContextReplacing<flo
             dynamicRes = juce::jlimit(0.1f, 1.0f, dynamicRes);
 
             // Set filter parameters with complex modulation
+            auto& filter = filters[(size_t)channel];
             filter.parameters->setCutOffFrequency(sampleRate, finalCutoff, dynamicRes);
 
             // Process through filter
@@ -112,35 +128,85 @@ void WavetableFilterModule::process(const juce::dsp::ProcessContextReplacing<flo
             float digitalArtifact = std::fmod(finalCutoff, 1000.0f) * 0.001f; // Frequency-based artifacts
             float processedWet = filteredSample * (1.0f + digitalArtifact * wtMod);
 
-            output[sample] = inputSample * (1.0f - wetMix) + processedWet * wetMix;
+            outputBlock.getChannelPointer(channel)[sample] = inputSample * (1.0f - wetMix) + processedWet * wetMix;
         }
+
+        advanceWavetablePhase();
     }
 }
 
 void WavetableFilterModule::reset()
 {
-    filter.reset();
+    for (auto& filter : filters) {
+        filter.reset();
+    }
+
+    std::fill(phaseAccumulators.begin(), phaseAccumulators.end(), 0.0f);
     lfo.reset();
     envelopeFollower.reset();
 
-    wavetablePosition = 0.0f;
+    wavetablePhase = 0.0f;
     lfoPhase = 0.0f;
 }
 
 // Wavetable Management
 bool WavetableFilterModule::loadWavetableFromAudioFile(const juce::File& file)
 {
-    // TODO: Fix JUCE API compatibility - AudioFormatManager not available in current JUCE version
-    juce::Logger::writeToLog("WavetableFilterModule: AudioFormatManager not available - needs JUCE API compatibility fix");
+    if (!file.existsAsFile()) {
+        return false;
+    }
 
-    return false;
+    // Previously extracted tables are memory-mapped straight from the cache
+    if (auto cached = WavetableBank::loadFromCacheFile(WavetableBank::getCacheFileFor(file))) {
+        installBank(std::move(cached));
+        return true;
+    }
+
+    extractor.requestExtraction(file);
+    return true;
 }
 
 void WavetableFilterModule::unloadWavetable()
 {
-    wavetable.clear();
-    wavetableLoaded = false;
-    loadedWavetableName = "";
+    installBank(nullptr);
+}
+
+juce::String WavetableFilterModule::getWavetableName() const
+{
+    const juce::SpinLock::ScopedLockType lock(bankLock);
+    return loadedWavetableName;
+}
+
+void WavetableFilterModule::installBank(std::unique_ptr<WavetableBank> newBank)
+{
+    // Both of these are released when this function returns, off the audio thread
+    std::unique_ptr<WavetableBank> superseded, retired;
+
+    const bool loaded = newBank != nullptr;
+    const auto name = loaded ? newBank->getName() : juce::String();
+
+    {
+        const juce::SpinLock::ScopedLockType lock(bankLock);
+        retired = std::move(retiredBank);
+        superseded = std::move(pendingBank);
+        pendingBank = std::move(newBank);
+        hasPendingBank = true;
+        loadedWavetableName = name;
+    }
+
+    wavetableLoaded = loaded;
+}
+
+void WavetableFilterModule::swapInPendingBank()
+{
+    const juce::SpinLock::ScopedTryLockType lock(bankLock);
+
+    // retiredBank is always empty here: installBank() clears it before posting a new bank
+    if (lock.isLocked() && hasPendingBank) {
+        retiredBank = std::move(activeBank);
+        activeBank = std::move(pendingBank);
+        hasPendingBank = false;
+    }
 }
 
 // Parameter setters
@@ -168,7 +234,9 @@ void WavetableFilterModule::setFilterType(int type)
         default: filterTypeEnum = juce::dsp::StateVariableFilter::Parameters<float>::Type::lowPass; break;
     }
 
-    filter.parameters->type = filterTypeEnum;
+    for (auto& filter : filters) {
+        filter.parameters->type = filterTypeEnum;
+    }
 }
 
 void WavetableFilterModule::setLfoRate(float rateHz)
@@ -200,7 +268,12 @@ void WavetableFilterModule::setWavetableRate(float rate)
 
 void WavetableFilterModule::setWavetablePosition(float position)
 {
-    wavetablePosition = position * (float)wavetableSize;
+    wavetablePosition = juce::jlimit(0.0f, 1.0f, position);
+}
+
+void WavetableFilterModule::setScanModDepth(float depth)
+{
+    scanModDepth = juce::jlimit(0.0f, 1.0f, depth);
 }
 
 void WavetableFilterModule::setEnvelopeSensitivity(float sensitivity)
@@ -266,23 +339,14 @@ void WavetableFilterModule::updateEnvelopeCoefficients()
     // This is a simplified implementation
 }
 
-float WavetableFilterModule::getWavetableSample()
+float WavetableFilterModule::getWavetableSample(float framePosition)
 {
-    if (!wavetableLoaded) {
+    if (activeBank == nullptr) {
         return 0.0f; // Return silence if no wavetable loaded
     }
 
-    // Get interpolated sample from wavetable
-    float samplePos = wavetablePosition;
-    int index1 = (int)samplePos;
-    int index2 = (index1 + 1) % wavetableSize;
-    float frac = samplePos - (float)index1;
-
-    float sample1 = wavetable.getSample(0, index1);
-    float sample2 = wavetable.getSample(0, index2);
-
-    // Linear interpolation
-    return sample1 + frac * (sample2 - sample1);
+    // Interpolated read at the current phase, crossfaded between neighbouring frames
+    return activeBank->getSample(framePosition * (float)(activeBank->getNumFrames() - 1), wavetablePhase);
 }
 
 float WavetableFilterModule::processLfoModulation()
@@ -305,72 +369,80 @@ float WavetableFilterModule::processEnvelopeModulation()
     return 0.0f;
 }
 
-float WavetableFilterModule::processWavetableModulation()
+float WavetableFilterModule::processWavetableModulation(float framePosition)
 {
-    if (!wavetableLoaded || wavetableModDepth <= 0.0f) {
+    if (activeBank == nullptr || wavetableModDepth <= 0.0f) {
         return 0.0f;
     }
 
-    // Get sample from wavetable
-    float wtSample = getWavetableSample();
+    // Get sample from wavetable and apply depth
+    return getWavetableSample(framePosition) * wavetableModDepth;
+}
 
-    // Advance wavetable position
-    wavetablePosition += wavetableIncrement;
-    if (wavetablePosition >= wavetableSize) {
-        wavetablePosition -= wavetableSize;
+void WavetableFilterModule::advanceWavetablePhase()
+{
+    // Advance read head within the frame
+    wavetablePhase += wavetableIncrement;
+    if (wavetablePhase >= (float)WavetableBank::frameSize) {
+        wavetablePhase -= (float)WavetableBank::frameSize;
     }
-
-    // Apply depth and return
-    return wtSample * wavetableModDepth;
 }
 
 // Private method: Create complex digital wavetable for robotic harmonics
 void WavetableFilterModule::createDefaultDigitalWavetable()
 {
-    // Clear existing wavetable
-    wavetable.clear();
-
-    // Generate complex digital waveform that creates evolving robotic harmonics
-    for (int i = 0; i < wavetableSize; ++i) {
-        float phase = (float)i / (float)wavetableSize; // 0.0 to 1.0
-
-        // **Complex Digital Harmonic Algorithm**
-        // Create evolving robotic textures with multiple interacting harmonics
-
-        // Primary harmonics (create metallic/digital character)
-        float primaryHarmonic = std::sin(phase * juce::MathConstants<float>::twoPi) * 0.6f;
-        float secondaryHarmonic = std::sin(phase * juce::MathConstants<float>::twoPi * 2.0f) * 0.4f;
-        float tertiaryHarmonic = std::sin(phase * juce::MathConstants<float>::twoPi * 3.0f) * 0.3f;
-
-        // Phase-modulated harmonics (create evolving digital sweeps)
-        float phaseMod1 = std::sin(phase * juce::MathConstants<float>::twoPi * 7.0f) * 0.1f;
-        float phaseMod2 = std::cos(phase * juce::MathConstants<float>::twoPi * 11.0f) * 0.08f;
-
-        // Harmonic interaction (creates unpredictable robotic movement)
-        float interaction1 = primaryHarmonic * secondaryHarmonic * 0.5f;
-        float interaction2 = secondaryHarmonic * tertiaryHarmonic * 0.3f;
-
-        // Pulsing envelope (creates rhythmic digital character)
-        float envelope = 0.5f + 0.5f * std::sin(phase * juce::MathConstants<float>::twoPi * 8.0f);
-
-        // Combine all elements for complex digital texture
-        float digitalWavetable = primaryHarmonic +
-                                secondaryHarmonic +
-                                tertiaryHarmonic +
-                                interaction1 +
-                                interaction2 +
-                                phaseMod1 +
-                                phaseMod2;
-
-        // Apply envelope and normalize
-        digitalWavetable *= envelope;
-        digitalWavetable = juce::jlimit(-1.0f, 1.0f, digitalWavetable);
-
-        // Store in wavetable buffer
-        wavetable.setSample(0, i, digitalWavetable * 0.3f); // Scale down for modulation intensity
+    constexpr int numFrames = 16;
+    constexpr int frameSize = WavetableBank::frameSize;
+    std::vector<float> frames((size_t)numFrames * frameSize);
+
+    // Each frame pushes the upper harmonics and pulse rate further, so scanning
+    // the table morphs from a smooth tone to a busier robotic texture
+    for (int frame = 0; frame < numFrames; ++frame) {
+        float morph = (float)frame / (float)(numFrames - 1);
+        float pulseRate = (float)(8 + frame / 2); // Integer rate keeps each frame single-cycle
+        float* frameData = frames.data() + (size_t)frame * frameSize;
+
+        for (int i = 0; i < frameSize; ++i) {
+            float phase = (float)i / (float)frameSize; // 0.0 to 1.0
+
+            // **Complex Digital Harmonic Algorithm**
+            // Create evolving robotic textures with multiple interacting harmonics
+
+            // Primary harmonics (create metallic/digital character)
+            float primaryHarmonic = std::sin(phase * juce::MathConstants<float>::twoPi) * 0.6f;
+            float secondaryHarmonic = std::sin(phase * juce::MathConstants<float>::twoPi * 2.0f) * 0.4f;
+            float tertiaryHarmonic = std::sin(phase * juce::MathConstants<float>::twoPi * 3.0f) * 0.3f * (1.0f + morph);
+
+            // Phase-modulated harmonics (create evolving digital sweeps)
+            float phaseMod1 = std::sin(phase * juce::MathConstants<float>::twoPi * 7.0f) * 0.1f * (1.0f + 2.0f * morph);
+            float phaseMod2 = std::cos(phase * juce::MathConstants<float>::twoPi * 11.0f) * 0.08f * (1.0f + 3.0f * morph);
+
+            // Harmonic interaction (creates unpredictable robotic movement)
+            float interaction1 = primaryHarmonic * secondaryHarmonic * 0.5f;
+            float interaction2 = secondaryHarmonic * tertiaryHarmonic * 0.3f;
+
+            // Pulsing envelope (creates rhythmic digital character)
+            float envelope = 0.5f + 0.5f * std::sin(phase * juce::MathConstants<float>::twoPi * pulseRate);
+
+            // Combine all elements for complex digital texture
+            float digitalWavetable = primaryHarmonic +
+                                    secondaryHarmonic +
+                                    tertiaryHarmonic +
+                                    interaction1 +
+                                    interaction2 +
+                                    phaseMod1 +
+                                    phaseMod2;
+
+            // Apply envelope and normalize
+            digitalWavetable *= envelope;
+            digitalWavetable = juce::jlimit(-1.0f, 1.0f, digitalWavetable);
+
+            frameData[i] = digitalWavetable * 0.3f; // Scale down for modulation intensity
+        }
     }
 
-    // Mark as loaded
+    // Called from the constructor, before any audio thread exists
+    activeBank = std::make_unique<WavetableBank>(std::move(frames), "Complex Digital Harmonic");
+    loadedWavetableName = activeBank->getName();
     wavetableLoaded = true;
-    loadedWavetableName = "Complex Digital Harmonic";
 }
@@ -1,14 +1,17 @@
 #pragma once
 
 #include "Module.h"
-#include "../JUCE/modules/juce_dsp/juce_dsp.h"
-#include "../JUCE/modules/juce_audio_processors/juce_audio_processors.h"
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "WavetableBank.h"
+#include "WavetableExtractor.h"
 
 /**
  * WavetableFilterModule - "Dying Wavetable" Filter Effect
  *
  * This module implements a sophisticated filter modulation system using:
- * 1. Resampled audio files as wavetable modulation sources
+ * 1. Multi-frame wavetables (up to 256 frames) extracted pitch-synchronously
+ *    from audio files, scanned and morphed by position, LFO and envelope
  * 2. Complex LFO with custom shapes for "dying" filter sweeps
  * 3. FM-style filter modulation using wavetable data
  * 4. Psychoacoustic processing with envelope following and A-weighting
@@ -34,10 +37,11 @@ public:
     ModuleType getType() const override { return ModuleType::Filter; }
 
     // Wavetable Management
+    // Loads instantly from the on-disk cache, otherwise extracts on a background thread
     bool loadWavetableFromAudioFile(const juce::File& file);
     void unloadWavetable();
-    bool isWavetableLoaded() const { return wavetableLoaded; }
-    juce::String getWavetableName() const { return loadedWavetableName; }
+    bool isWavetableLoaded() const { return wavetableLoaded.load(); }
+    juce::String getWavetableName() const;
 
     // Core Parameters
     void setCutoffFrequency(float frequencyHz);
@@ -52,7 +56,8 @@ public:
     // Wavetable Modulation Parameters
     void setWavetableModDepth(float depth); // 0.0-1.0: FM-style modulation amount
     void setWavetableRate(float rate); // 0.01-10.0: Wavetable playback speed
-    void setWavetablePosition(float position); // 0.0-1.0: Manual position control
+    void setWavetablePosition(float position); // 0.0-1.0: Frame scan position (first to last frame)
+    void setScanModDepth(float depth); // 0.0-1.0: How much LFO/envelope sweep the frame position
 
     // Envelope Following Parameters
     void setEnvelopeSensitivity(float sensitivity); // 0.0-1.0: How much input dynamics affect modulation
@@ -66,19 +71,29 @@ public:
     float getCurrentCutoff() const { return baseCutoff; }
     float getCurrentResonance() const { return resonance; }
     float getCurrentLfoPhase() const { return lfoPhase; }
-    float getCurrentWavetablePosition() const { return wavetablePosition / (float)wavetableSize; }
+    float getCurrentWavetablePosition() const { return wavetablePosition; }
 
 private:
     // Wavetable System
-    juce::AudioSampleBuffer wavetable;
-    int wavetableSize = 2048;
-    bool wavetableLoaded = false;
-    juce::String loadedWavetableName;
-    float wavetablePosition = 0.0f;
+    // activeBank is only touched by the audio thread. New banks are handed over
+    // through pendingBank and the one they replace is parked in retiredBank, so
+    // the audio thread never frees memory or unmaps files.
+    std::unique_ptr<WavetableBank> activeBank;
+    std::unique_ptr<WavetableBank> pendingBank;
+    std::unique_ptr<WavetableBank> retiredBank;
+    bool hasPendingBank = false;
+    juce::SpinLock bankLock;
+    WavetableExtractor extractor;
+
+    std::atomic<bool> wavetableLoaded { false };
+    juce::String loadedWavetableName; // guarded by bankLock
+    float wavetablePosition = 0.0f; // 0.0-1.0 across frames
+    float wavetablePhase = 0.0f;    // Read head inside the current frame (samples)
     float wavetableIncrement = 1.0f;
+    float scanModDepth = 0.3f;
 
-    // Core Filter
-    juce::dsp::StateVariableFilter::Filter<float> filter;
+    // Core Filter - one per channel, each with its own state and modulated cutoff
+    std::vector<juce::dsp::StateVariableFilter::Filter<float>> filters;
     float baseCutoff = 1000.0f;
     float resonance = 0.5f;
     int filterType = 0; // 0=LP, 1=HP, 2=BP, 3=Notch
@@ -105,14 +120,18 @@ private:
 
     // DSP State
     double sampleRate = 44100.0;
+    std::vector<float> phaseAccumulators; // Phase-modulation layer, per channel
 
     // Internal Methods
     void updateLfoShape();
     void updateEnvelopeCoefficients();
-    float getWavetableSample();
+    void installBank(std::unique_ptr<WavetableBank> newBank);
+    void swapInPendingBank();
+    float getWavetableSample(float framePosition);
     float processLfoModulation();
     float processEnvelopeModulation();
-    float processWavetableModulation();
+    float processWavetableModulation(float framePosition); // Reads at the current phase; shared by the channels
+    void advanceWavetablePhase(); // Once per sample frame
     void createDefaultDigitalWavetable();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableFilterModule)